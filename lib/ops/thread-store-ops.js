@@ -4,6 +4,7 @@ import { type BaseStoreOpsHandlers } from './base-ops.js';
 import type { RawThreadInfo } from '../types/minimally-encoded-thread-permissions-types.js';
 import type {
   ClientDBThreadInfo,
+  ClientDBThreadPatch,
   RawThreadInfos,
   ThreadStore,
 } from '../types/thread-types.js';
@@ -36,10 +37,16 @@ export type ClientDBReplaceThreadOperation = {
   +payload: ClientDBThreadInfo,
 };
 
+export type ClientDBPatchThreadOperation = {
+  +type: 'patch',
+  +payload: ClientDBThreadPatch,
+};
+
 export type ClientDBThreadStoreOperation =
   | RemoveThreadOperation
   | RemoveAllThreadsOperation
-  | ClientDBReplaceThreadOperation;
+  | ClientDBReplaceThreadOperation
+  | ClientDBPatchThreadOperation;
 
 export const threadStoreOpsHandlers: BaseStoreOpsHandlers<
   ThreadStore,
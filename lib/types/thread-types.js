@@ -190,6 +190,17 @@ export type ClientDBThreadInfo = {
   +pinnedCount?: number,
 };
 
+// Patches the JSON columns of a thread in place instead of replacing the
+// whole row. `currentUser` and `roles` are JSON merge patches of the
+// respective fields, `members` is a JSON object mapping member IDs to merge
+// patches of those members.
+export type ClientDBThreadPatch = {
+  +id: string,
+  +currentUser?: ?string,
+  +roles?: ?string,
+  +members?: ?string,
+};
+
 export type ThreadDeletionRequest = {
   +threadID: string,
   +accountPassword?: empty,
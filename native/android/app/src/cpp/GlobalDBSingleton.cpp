@@ -7,22 +7,80 @@ GlobalDBSingleton GlobalDBSingleton::instance;
 GlobalDBSingleton::GlobalDBSingleton()
     : multithreadingEnabled(true),
       databaseThread(std::make_unique<WorkerThread>("database")),
-      tasksCancelled(false) {
+      tasksCancelled(false),
+      readThreadsEnabled(false),
+      nextReadThread(0) {
 }
 
-void GlobalDBSingleton::scheduleOrRun(const taskType task) {
-  this->scheduleOrRunCommonImpl(task);
+std::optional<std::uint64_t>
+GlobalDBSingleton::scheduleOrRun(Task task, TaskPriority priority) {
+  return this->scheduleOrRunCommonImpl(std::move(task), priority);
 }
 
-void GlobalDBSingleton::scheduleOrRunCancellable(const taskType task) {
-  this->scheduleOrRunCancellableCommonImpl(task);
+std::optional<std::uint64_t> GlobalDBSingleton::scheduleOrRunWithoutWaiting(
+    Task task,
+    TaskPriority priority) {
+  return this->scheduleOrRunWithoutWaitingCommonImpl(std::move(task), priority);
 }
 
 void GlobalDBSingleton::scheduleOrRunCancellable(
-    const taskType task,
-    const std::shared_ptr<facebook::react::Promise> promise,
-    const std::shared_ptr<facebook::react::CallInvoker> jsInvoker) {
-  this->scheduleOrRunCancellableCommonImpl(task, promise, jsInvoker);
+    Task task,
+    TaskPriority priority) {
+  this->scheduleOrRunCancellableCommonImpl(std::move(task), priority);
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellable(
+    Task task,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken) {
+  this->scheduleOrRunCancellableCommonImpl(
+      std::move(task),
+      std::move(promise),
+      std::move(jsInvoker),
+      std::move(cancellationToken));
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableRead(Task task) {
+  this->scheduleOrRunCancellableReadCommonImpl(std::move(task));
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableRead(
+    Task task,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken,
+    ReadOrdering ordering) {
+  this->scheduleOrRunCancellableReadCommonImpl(
+      std::move(task),
+      std::move(promise),
+      std::move(jsInvoker),
+      std::move(cancellationToken),
+      ordering);
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableSnapshotReads(
+    openSnapshotType openSnapshot,
+    std::vector<taskType> reads,
+    taskType closeSnapshot,
+    taskType onDone,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken) {
+  this->scheduleOrRunCancellableSnapshotReadsCommonImpl(
+      std::move(openSnapshot),
+      std::move(reads),
+      std::move(closeSnapshot),
+      std::move(onDone),
+      std::move(promise),
+      std::move(jsInvoker),
+      std::move(cancellationToken));
+}
+
+void GlobalDBSingleton::enableReadThreads(
+    std::size_t readThreadsCount,
+    const taskType readThreadInitializer) {
+  this->enableReadThreadsCommonImpl(readThreadsCount, readThreadInitializer);
 }
 
 void GlobalDBSingleton::enableMultithreading() {
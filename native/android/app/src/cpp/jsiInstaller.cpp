@@ -62,6 +62,13 @@ public:
         additionalParameters.get("sqliteFilePath");
     std::string sqliteFilePath = sqliteFilePathObj->toString();
 
+    jni::local_ref<jni::JObject> isLowRamDeviceObj =
+        additionalParameters.get("isLowRamDevice");
+    if (isLowRamDeviceObj->toString() == "true") {
+      comm::SQLiteQueryExecutor::performanceProfile =
+          comm::SQLitePerformanceProfile::lowMemory;
+    }
+
     comm::SQLiteQueryExecutor::initialize(sqliteFilePath);
   }
 
@@ -1,5 +1,6 @@
 package app.comm.android.fbjni;
 
+import android.app.ActivityManager;
 import android.content.Context;
 import com.facebook.react.bridge.ReactContext;
 import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
@@ -21,6 +22,10 @@ public class CommHybrid {
     HashMap<String, Object> additionalParameters =
         new HashMap<String, Object>();
     additionalParameters.put("sqliteFilePath", sqliteFilePath);
+    ActivityManager activityManager =
+        (ActivityManager)context.getSystemService(Context.ACTIVITY_SERVICE);
+    additionalParameters.put(
+        "isLowRamDevice", activityManager.isLowRamDevice());
 
     new CommHybrid().initHybrid(contextPointer, holder, additionalParameters);
   }
@@ -0,0 +1,89 @@
+#include "CryptoModule.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+#include <memory>
+#include <string>
+
+namespace comm {
+namespace crypto {
+
+OlmBuffer toBuffer(const std::string &value) {
+  return OlmBuffer(value.begin(), value.end());
+}
+
+// Sets up a session the same way two devices do: the sender uses the
+// published keys of the receiver and the receiver responds to the initial
+// message.
+void initializeSession(CryptoModule &sender, CryptoModule &receiver) {
+  receiver.validatePrekey();
+  folly::dynamic oneTimeKeys =
+      folly::parseJson(receiver.getOneTimeKeysForPublishing(1));
+  std::string oneTimeKey =
+      (*oneTimeKeys["curve25519"].values().begin()).asString();
+  sender.initializeOutboundForSendingSession(
+      receiver.id,
+      toBuffer(receiver.getIdentityKeys()),
+      toBuffer(receiver.getPrekey()),
+      toBuffer(receiver.getPrekeySignature()),
+      toBuffer(oneTimeKey));
+
+  EncryptedData initialMessage =
+      sender.encrypt(receiver.id, "{\"type\": \"init\"}");
+  receiver.initializeInboundForReceivingSession(
+      sender.id, initialMessage.message, toBuffer(sender.getIdentityKeys()));
+  receiver.decrypt(sender.id, initialMessage);
+}
+
+static void OlmSessionInitialization(benchmark::State &state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    CryptoModule sender("sender");
+    CryptoModule receiver("receiver");
+    state.ResumeTiming();
+    initializeSession(sender, receiver);
+  }
+}
+BENCHMARK(OlmSessionInitialization)->Unit(benchmark::kMicrosecond);
+
+// Args: plaintext size
+static void OlmEncrypt(benchmark::State &state) {
+  CryptoModule sender("sender");
+  CryptoModule receiver("receiver");
+  initializeSession(sender, receiver);
+  std::string plaintext(state.range(0), 'a');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sender.encrypt(receiver.id, plaintext));
+  }
+  state.SetBytesProcessed(state.iterations() * plaintext.size());
+}
+BENCHMARK(OlmEncrypt)
+    ->Arg(64)
+    ->Arg(1024)
+    ->Arg(16384)
+    ->Unit(benchmark::kMicrosecond);
+
+// Args: plaintext size
+static void OlmDecrypt(benchmark::State &state) {
+  CryptoModule sender("sender");
+  CryptoModule receiver("receiver");
+  initializeSession(sender, receiver);
+  std::string plaintext(state.range(0), 'a');
+  for (auto _ : state) {
+    state.PauseTiming();
+    EncryptedData encryptedData = sender.encrypt(receiver.id, plaintext);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(receiver.decrypt(sender.id, encryptedData));
+  }
+  state.SetBytesProcessed(state.iterations() * plaintext.size());
+}
+BENCHMARK(OlmDecrypt)
+    ->Arg(64)
+    ->Arg(1024)
+    ->Arg(16384)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace crypto
+} // namespace comm
@@ -0,0 +1,218 @@
+#include "HostDataDirectory.h"
+#include "PlatformSpecificTools.h"
+#include "SQLitePerformanceProfile.h"
+#include "SQLiteProfiler.h"
+#include "SQLiteQueryExecutor.h"
+#include "SyntheticDataset.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace comm {
+
+// Set COMM_BENCHMARK_PERFORMANCE_PROFILE to the name of a preset to compare
+// the presets with each other.
+SQLitePerformanceProfile getBenchmarkPerformanceProfile() {
+  const char *profileName = std::getenv("COMM_BENCHMARK_PERFORMANCE_PROFILE");
+  if (!profileName) {
+    return SQLitePerformanceProfile::standard;
+  }
+  for (const SQLitePerformanceProfile &preset :
+       SQLitePerformanceProfile::getPresets()) {
+    if (preset.name == profileName) {
+      return preset;
+    }
+  }
+  throw std::invalid_argument(
+      "Unknown performance profile: " + std::string(profileName));
+}
+
+// Every benchmark starts from a freshly migrated, empty database. Set
+// COMM_BENCHMARK_SQL_PROFILE to get the SQL profile of each run logged.
+class DatabaseBenchmark : public benchmark::Fixture {
+protected:
+  std::unique_ptr<SQLiteQueryExecutor> executor;
+
+public:
+  void SetUp(const benchmark::State &state) override {
+    static std::string databasePath =
+        (getHostDataDirectory() / "comm.sqlite").string();
+    SQLiteQueryExecutor::performanceProfile = getBenchmarkPerformanceProfile();
+    SQLiteQueryExecutor::initialize(databasePath);
+    SQLiteProfiler::setEnabled(std::getenv("COMM_BENCHMARK_SQL_PROFILE"));
+    SQLiteQueryExecutor::clearSensitiveData();
+    this->executor = std::make_unique<SQLiteQueryExecutor>();
+  }
+
+  void TearDown(const benchmark::State &state) override {
+    this->executor.reset();
+    PlatformSpecificTools::removeBackupDirectory();
+    if (SQLiteProfiler::isEnabled()) {
+      SQLiteProfiler::logProfiles(10);
+      SQLiteProfiler::reset();
+    }
+  }
+};
+
+SyntheticDatasetConfig getDatasetConfig(const benchmark::State &state) {
+  SyntheticDatasetConfig config;
+  config.threadsCount = state.range(0);
+  config.messagesPerThread = state.range(1);
+  return config;
+}
+
+// Args: batch size
+BENCHMARK_DEFINE_F(DatabaseBenchmark, ReplaceMessagesBatch)
+(benchmark::State &state) {
+  SyntheticDatasetConfig config;
+  config.threadsCount = 1;
+  config.messagesPerThread = state.range(0);
+  SyntheticDataset dataset = SyntheticDataset::generate(config);
+  for (auto _ : state) {
+    this->executor->beginTransaction();
+    this->executor->replaceMessages(dataset.messages);
+    this->executor->replaceMedias(dataset.media);
+    this->executor->commitTransaction();
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.messages.size());
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, ReplaceMessagesBatch)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Args: batch size
+BENCHMARK_DEFINE_F(DatabaseBenchmark, ReplaceThreadsBatch)
+(benchmark::State &state) {
+  SyntheticDatasetConfig config;
+  config.threadsCount = state.range(0);
+  config.messagesPerThread = 0;
+  SyntheticDataset dataset = SyntheticDataset::generate(config);
+  for (auto _ : state) {
+    this->executor->beginTransaction();
+    for (const Thread &thread : dataset.threads) {
+      this->executor->replaceThread(thread);
+    }
+    this->executor->commitTransaction();
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.threads.size());
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, ReplaceThreadsBatch)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMicrosecond);
+
+// Args: threads count, messages per thread
+BENCHMARK_DEFINE_F(DatabaseBenchmark, LoadAllThreads)
+(benchmark::State &state) {
+  SyntheticDataset dataset =
+      SyntheticDataset::generate(getDatasetConfig(state));
+  dataset.load(*this->executor);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(this->executor->getAllThreads());
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.threads.size());
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, LoadAllThreads)
+    ->Args({100, 0})
+    ->Args({1000, 0})
+    ->Unit(benchmark::kMillisecond);
+
+// Args: threads count, messages per thread
+BENCHMARK_DEFINE_F(DatabaseBenchmark, LoadAllMessages)
+(benchmark::State &state) {
+  SyntheticDataset dataset =
+      SyntheticDataset::generate(getDatasetConfig(state));
+  dataset.load(*this->executor);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(this->executor->getAllMessages());
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.messages.size());
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, LoadAllMessages)
+    ->Args({100, 100})
+    ->Args({100, 1000})
+    ->Unit(benchmark::kMillisecond);
+
+// Args: threads count, messages per thread
+BENCHMARK_DEFINE_F(DatabaseBenchmark, LoadClientDBStoreSnapshot)
+(benchmark::State &state) {
+  SyntheticDataset dataset =
+      SyntheticDataset::generate(getDatasetConfig(state));
+  dataset.load(*this->executor);
+  this->executor->writeClientDBStoreSnapshot();
+  for (auto _ : state) {
+    std::size_t messagesCount = 0;
+    auto store = this->executor->getClientDBStoreSnapshot(
+        1000, [&messagesCount](std::vector<MessageEntity> &&chunk) {
+          messagesCount += chunk.size();
+          benchmark::DoNotOptimize(chunk);
+        });
+    if (!store) {
+      state.SkipWithError("Client DB store snapshot is missing.");
+      break;
+    }
+    benchmark::DoNotOptimize(store);
+    benchmark::DoNotOptimize(messagesCount);
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.messages.size());
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, LoadClientDBStoreSnapshot)
+    ->Args({100, 100})
+    ->Args({100, 1000})
+    ->Unit(benchmark::kMillisecond);
+
+// Args: messages written between captures
+BENCHMARK_DEFINE_F(DatabaseBenchmark, CaptureBackupLogs)
+(benchmark::State &state) {
+  SyntheticDatasetConfig config;
+  config.threadsCount = 1;
+  config.messagesPerThread = state.range(0);
+  // Backup logs are only captured once there is a main compaction.
+  this->executor->createMainCompaction("benchmark");
+  for (auto _ : state) {
+    state.PauseTiming();
+    // Rows that didn't change wouldn't end up in the log.
+    config.seed++;
+    SyntheticDataset dataset = SyntheticDataset::generate(config);
+    this->executor->beginTransaction();
+    this->executor->replaceMessages(dataset.messages);
+    this->executor->commitTransaction();
+    state.ResumeTiming();
+    this->executor->captureBackupLogs();
+  }
+  state.SetItemsProcessed(state.iterations() * config.messagesPerThread);
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, CaptureBackupLogs)
+    ->Arg(1)
+    ->Arg(100)
+    ->Unit(benchmark::kMicrosecond);
+
+// Args: threads count, messages per thread
+BENCHMARK_DEFINE_F(DatabaseBenchmark, SearchMessages)
+(benchmark::State &state) {
+  SyntheticDataset dataset =
+      SyntheticDataset::generate(getDatasetConfig(state));
+  dataset.load(*this->executor);
+  std::size_t queryIndex = 0;
+  for (auto _ : state) {
+    const std::string &word =
+        dataset.vocabulary[queryIndex++ % dataset.vocabulary.size()];
+    benchmark::DoNotOptimize(
+        this->executor->searchMessages(word, std::nullopt, 20, 0));
+  }
+}
+BENCHMARK_REGISTER_F(DatabaseBenchmark, SearchMessages)
+    ->Args({100, 1000})
+    ->Args({500, 1000})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace comm
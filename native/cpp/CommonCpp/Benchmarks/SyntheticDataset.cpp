@@ -0,0 +1,136 @@
+#include "SyntheticDataset.h"
+
+#include <random>
+#include <string>
+
+namespace comm {
+
+const std::int64_t DATASET_START_TIME = 1700000000000;
+
+std::string
+generateRandomText(std::mt19937_64 &generator, std::size_t length) {
+  static const std::string characters =
+      " 0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  std::uniform_int_distribution<std::size_t> distribution(
+      0, characters.size() - 1);
+  std::string text;
+  text.reserve(length);
+  for (std::size_t i = 0; i < length; i++) {
+    text += characters[distribution(generator)];
+  }
+  return text;
+}
+
+// Generates a JSON object of approximately the given size.
+std::string generateJSONBlob(
+    std::mt19937_64 &generator,
+    const std::string &key,
+    std::size_t size) {
+  std::size_t overhead = key.size() + 7;
+  std::size_t textLength = size > overhead ? size - overhead : 0;
+  return "{\"" + key + "\":\"" + generateRandomText(generator, textLength) +
+      "\"}";
+}
+
+std::string generateRandomWord(std::mt19937_64 &generator) {
+  std::uniform_int_distribution<std::size_t> lengthDistribution(3, 10);
+  std::uniform_int_distribution<int> letterDistribution('a', 'z');
+  std::string word(lengthDistribution(generator), ' ');
+  for (char &letter : word) {
+    letter = static_cast<char>(letterDistribution(generator));
+  }
+  return word;
+}
+
+std::string generateRandomSentence(
+    std::mt19937_64 &generator,
+    const std::vector<std::string> &vocabulary,
+    std::size_t length) {
+  std::uniform_int_distribution<std::size_t> distribution(
+      0, vocabulary.size() - 1);
+  std::string sentence;
+  while (sentence.size() < length) {
+    if (sentence.size()) {
+      sentence += ' ';
+    }
+    sentence += vocabulary[distribution(generator)];
+  }
+  return sentence;
+}
+
+SyntheticDataset
+SyntheticDataset::generate(const SyntheticDatasetConfig &config) {
+  std::mt19937_64 generator(config.seed);
+  std::bernoulli_distribution hasMedia(config.mediaRatio);
+  SyntheticDataset dataset;
+  dataset.vocabulary.reserve(config.vocabularySize);
+  for (std::size_t i = 0; i < config.vocabularySize; i++) {
+    dataset.vocabulary.push_back(generateRandomWord(generator));
+  }
+  dataset.threads.reserve(config.threadsCount);
+  dataset.messageStoreThreads.reserve(config.threadsCount);
+  dataset.messages.reserve(config.threadsCount * config.messagesPerThread);
+
+  std::int64_t time = DATASET_START_TIME;
+  for (std::size_t threadIndex = 0; threadIndex < config.threadsCount;
+       threadIndex++) {
+    std::string threadID = "256|" + std::to_string(threadIndex);
+    Thread thread{};
+    thread.id = threadID;
+    thread.type = 4;
+    thread.name =
+        std::make_unique<std::string>(generateRandomText(generator, 16));
+    thread.color = "4b87aa";
+    thread.creation_time = time;
+    thread.members =
+        generateJSONBlob(generator, "members", config.threadJSONSize / 2);
+    thread.roles =
+        generateJSONBlob(generator, "roles", config.threadJSONSize / 2);
+    thread.current_user = "{\"role\":\"member\",\"subscription\":{}}";
+    dataset.threads.push_back(std::move(thread));
+    dataset.messageStoreThreads.push_back({threadID, 0});
+
+    for (std::size_t messageIndex = 0; messageIndex < config.messagesPerThread;
+         messageIndex++) {
+      std::string messageID = threadID + "|" + std::to_string(messageIndex);
+      Message message{};
+      message.id = messageID;
+      message.thread = threadID;
+      message.user = "256";
+      message.type = 0;
+      message.content = std::make_unique<std::string>(generateRandomSentence(
+          generator, dataset.vocabulary, config.messageTextSize));
+      message.time = time++;
+      dataset.messages.push_back(std::move(message));
+
+      if (!hasMedia(generator)) {
+        continue;
+      }
+      for (std::size_t mediaIndex = 0; mediaIndex < config.mediaPerMessage;
+           mediaIndex++) {
+        std::string mediaID = messageID + "|" + std::to_string(mediaIndex);
+        dataset.media.push_back(
+            {mediaID,
+             messageID,
+             threadID,
+             "comm-blob-service://" + generateRandomText(generator, 64),
+             "photo",
+             "{\"dimensions\":{\"width\":1024,\"height\":768}}"});
+      }
+    }
+  }
+  return dataset;
+}
+
+void SyntheticDataset::load(const DatabaseQueryExecutor &executor) const {
+  executor.beginTransaction();
+  for (const Thread &thread : this->threads) {
+    executor.replaceThread(thread);
+  }
+  executor.replaceMessageStoreThreads(this->messageStoreThreads);
+  executor.replaceMessages(this->messages);
+  executor.replaceMedias(this->media);
+  executor.commitTransaction();
+}
+
+} // namespace comm
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DatabaseQueryExecutor.h"
+#include "entities/Media.h"
+#include "entities/Message.h"
+#include "entities/MessageStoreThread.h"
+#include "entities/Thread.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+struct SyntheticDatasetConfig {
+  std::size_t threadsCount{100};
+  std::size_t messagesPerThread{100};
+  // Fraction of messages that have media attached.
+  double mediaRatio{0.1};
+  std::size_t mediaPerMessage{1};
+  // Size of the JSON blobs stored in each thread (members, roles).
+  std::size_t threadJSONSize{2048};
+  // Text messages store their text as content. It's made of words drawn
+  // uniformly from a vocabulary of the given size.
+  std::size_t messageTextSize{128};
+  std::size_t vocabularySize{10000};
+  // Datasets generated from the same config and seed are identical.
+  std::uint64_t seed{0};
+};
+
+struct SyntheticDataset {
+  std::vector<std::string> vocabulary;
+  std::vector<Thread> threads;
+  std::vector<MessageStoreThread> messageStoreThreads;
+  std::vector<Message> messages;
+  std::vector<Media> media;
+
+  static SyntheticDataset generate(const SyntheticDatasetConfig &config);
+  // Writes the whole dataset in a single transaction.
+  void load(const DatabaseQueryExecutor &executor) const;
+};
+
+} // namespace comm
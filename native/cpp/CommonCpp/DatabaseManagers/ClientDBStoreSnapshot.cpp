@@ -0,0 +1,501 @@
+#include "ClientDBStoreSnapshot.h"
+#include "AESCrypto.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+namespace comm {
+
+// Has to be bumped whenever the layout of the snapshot or of any entity in
+// it changes, so that snapshots written by older app versions are ignored.
+const std::uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+const char SNAPSHOT_MAGIC[4] = {'C', 'D', 'B', 'S'};
+// magic, format version and generation
+const std::size_t SNAPSHOT_HEADER_SIZE = 4 + 4 + 8;
+// Plaintext is sealed once this much of it was written. A segment may be
+// larger by the size of one entity.
+const std::size_t SNAPSHOT_SEGMENT_SIZE = 1 << 20;
+// index of the segment and whether it's the last one
+const std::size_t SEGMENT_HEADER_SIZE = 8 + 1;
+
+const int IV_LENGTH = 12;
+const int TAG_LENGTH = 16;
+
+// Snapshots never leave the device, so values are stored in its native byte
+// order.
+class SnapshotWriter {
+  std::vector<std::uint8_t> &buffer;
+  // Called after every entity, e.g. to seal the buffer once it's big enough.
+  std::function<void()> onEntityWritten;
+
+public:
+  SnapshotWriter(
+      std::vector<std::uint8_t> &buffer,
+      std::function<void()> onEntityWritten = []() {})
+      : buffer(buffer), onEntityWritten(std::move(onEntityWritten)) {
+  }
+
+  template <typename T> void writeValue(T value) {
+    static_assert(std::is_trivially_copyable<T>::value);
+    const auto *bytes = reinterpret_cast<const std::uint8_t *>(&value);
+    this->buffer.insert(this->buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void write(const std::string &value) {
+    this->writeValue<std::uint32_t>(value.size());
+    this->buffer.insert(this->buffer.end(), value.begin(), value.end());
+  }
+
+  void write(const std::unique_ptr<std::string> &value) {
+    this->writeValue<std::uint8_t>(value != nullptr);
+    if (value) {
+      this->write(*value);
+    }
+  }
+
+  void write(int value) {
+    this->writeValue<std::int32_t>(value);
+  }
+
+  void write(const std::unique_ptr<int> &value) {
+    this->writeValue<std::uint8_t>(value != nullptr);
+    if (value) {
+      this->write(*value);
+    }
+  }
+
+  void write(int64_t value) {
+    this->writeValue<std::int64_t>(value);
+  }
+
+  template <typename T> void writeEntities(const std::vector<T> &entities) {
+    this->writeValue<std::uint64_t>(entities.size());
+    for (const T &entity : entities) {
+      EntitySchemaOf<T>::schema.forEachMember(
+          entity, [this](const auto &member) { this->write(member); });
+      this->onEntityWritten();
+    }
+  }
+
+  // Messages are written in chunks as they are read, so their total count
+  // isn't known upfront. Every chunk is preceded by its size, and an empty
+  // one ends them.
+  void writeMessagesChunk(const std::vector<MessageEntity> &messages) {
+    if (messages.empty()) {
+      return;
+    }
+    this->writeValue<std::uint64_t>(messages.size());
+    for (const auto &[message, media] : messages) {
+      EntitySchemaOf<Message>::schema.forEachMember(
+          message, [this](const auto &member) { this->write(member); });
+      this->writeEntities(media);
+      this->onEntityWritten();
+    }
+  }
+
+  void endMessages() {
+    this->writeValue<std::uint64_t>(0);
+  }
+
+  void writeHeader(std::uint64_t generation) {
+    this->buffer.insert(
+        this->buffer.end(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4);
+    this->writeValue<std::uint32_t>(SNAPSHOT_FORMAT_VERSION);
+    this->writeValue<std::uint64_t>(generation);
+  }
+};
+
+class SnapshotReader {
+  std::vector<std::uint8_t> buffer;
+  std::size_t offset{0};
+  // Appends the plaintext of the next segment to the buffer. Returns false
+  // once there are no more segments.
+  std::function<bool(std::vector<std::uint8_t> &)> readNextSegment;
+
+  void ensureAvailable(std::uint64_t length) {
+    while (length > this->buffer.size() - this->offset) {
+      this->buffer.erase(
+          this->buffer.begin(), this->buffer.begin() + this->offset);
+      this->offset = 0;
+      if (!this->readNextSegment || !this->readNextSegment(this->buffer)) {
+        throw std::runtime_error("Client DB store snapshot is truncated.");
+      }
+    }
+  }
+
+public:
+  SnapshotReader(const std::uint8_t *data, std::size_t size)
+      : buffer(data, data + size) {
+  }
+
+  SnapshotReader(
+      std::function<bool(std::vector<std::uint8_t> &)> readNextSegment)
+      : readNextSegment(std::move(readNextSegment)) {
+  }
+
+  template <typename T> T readValue() {
+    static_assert(std::is_trivially_copyable<T>::value);
+    this->ensureAvailable(sizeof(T));
+    T value;
+    std::memcpy(&value, this->buffer.data() + this->offset, sizeof(T));
+    this->offset += sizeof(T);
+    return value;
+  }
+
+  void read(std::string &value) {
+    std::size_t length = this->readValue<std::uint32_t>();
+    this->ensureAvailable(length);
+    value.assign(
+        reinterpret_cast<const char *>(this->buffer.data() + this->offset),
+        length);
+    this->offset += length;
+  }
+
+  void read(std::unique_ptr<std::string> &value) {
+    if (!this->readValue<std::uint8_t>()) {
+      value = nullptr;
+      return;
+    }
+    value = std::make_unique<std::string>();
+    this->read(*value);
+  }
+
+  void read(int &value) {
+    value = this->readValue<std::int32_t>();
+  }
+
+  void read(std::unique_ptr<int> &value) {
+    if (!this->readValue<std::uint8_t>()) {
+      value = nullptr;
+      return;
+    }
+    value = std::make_unique<int>();
+    this->read(*value);
+  }
+
+  void read(int64_t &value) {
+    value = this->readValue<std::int64_t>();
+  }
+
+  std::size_t readCount() {
+    std::uint64_t count = this->readValue<std::uint64_t>();
+    // Every entity takes at least one byte, which keeps a corrupted count
+    // from reserving an arbitrary amount of memory.
+    this->ensureAvailable(count);
+    return count;
+  }
+
+  template <typename T> void readEntities(std::vector<T> &entities) {
+    std::size_t count = this->readCount();
+    entities.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+      T entity{};
+      EntitySchemaOf<T>::schema.forEachMember(
+          entity, [this](auto &member) { this->read(member); });
+      entities.push_back(std::move(entity));
+    }
+  }
+
+  void readMessages(
+      std::size_t chunkSize,
+      const ClientDBStoreSnapshot::MessagesChunkCallback &onMessages) {
+    std::vector<MessageEntity> chunk;
+    while (std::size_t count = this->readCount()) {
+      for (std::size_t i = 0; i < count; i++) {
+        Message message{};
+        EntitySchemaOf<Message>::schema.forEachMember(
+            message, [this](auto &member) { this->read(member); });
+        std::vector<Media> media;
+        this->readEntities(media);
+        chunk.emplace_back(std::move(message), std::move(media));
+        if (chunk.size() >= chunkSize) {
+          onMessages(std::move(chunk));
+          chunk = std::vector<MessageEntity>();
+        }
+      }
+    }
+    if (!chunk.empty()) {
+      onMessages(std::move(chunk));
+    }
+  }
+
+  // Returns the generation if the header is valid.
+  std::optional<std::uint64_t> readHeader() {
+    this->ensureAvailable(SNAPSHOT_HEADER_SIZE);
+    if (std::memcmp(this->buffer.data() + this->offset, SNAPSHOT_MAGIC, 4)) {
+      return std::nullopt;
+    }
+    this->offset += 4;
+    if (this->readValue<std::uint32_t>() != SNAPSHOT_FORMAT_VERSION) {
+      return std::nullopt;
+    }
+    return this->readValue<std::uint64_t>();
+  }
+
+  bool atEnd() {
+    return this->offset == this->buffer.size() &&
+        (!this->readNextSegment || !this->readNextSegment(this->buffer));
+  }
+};
+
+// Segments are stored one after another, each preceded by its sealed size.
+// Their plaintext starts with the index of the segment and whether it's the
+// last one, so segments can't be reordered, dropped or cut off without
+// failing authentication.
+class SnapshotSegmentSealer {
+  std::ofstream &file;
+  std::vector<std::uint8_t> encryptionKeyBytes;
+  std::uint64_t segmentIndex{0};
+
+public:
+  std::vector<std::uint8_t> plaintext;
+
+  SnapshotSegmentSealer(std::ofstream &file, const std::string &encryptionKey)
+      : file(file),
+        encryptionKeyBytes(encryptionKey.begin(), encryptionKey.end()) {
+    this->startSegment();
+  }
+
+  void startSegment() {
+    SnapshotWriter writer(this->plaintext);
+    writer.writeValue<std::uint64_t>(this->segmentIndex++);
+    writer.writeValue<std::uint8_t>(0);
+  }
+
+  void seal(bool last) {
+    this->plaintext[SEGMENT_HEADER_SIZE - 1] = last;
+    std::vector<std::uint8_t> sealedData(
+        this->plaintext.size() + IV_LENGTH + TAG_LENGTH);
+    AESCrypto<std::vector<std::uint8_t> &>::encrypt(
+        this->encryptionKeyBytes, this->plaintext, sealedData);
+    std::uint32_t sealedDataSize = sealedData.size();
+    this->file.write(
+        reinterpret_cast<const char *>(&sealedDataSize),
+        sizeof(sealedDataSize));
+    this->file.write(
+        reinterpret_cast<const char *>(sealedData.data()), sealedData.size());
+    this->plaintext.clear();
+    if (!last) {
+      this->startSegment();
+    }
+  }
+
+  void sealIfFull() {
+    if (this->plaintext.size() >= SNAPSHOT_SEGMENT_SIZE) {
+      this->seal(false);
+    }
+  }
+};
+
+class SnapshotSegmentOpener {
+  std::ifstream &file;
+  std::vector<std::uint8_t> encryptionKeyBytes;
+  std::uint64_t remainingSize;
+  std::uint64_t segmentIndex{0};
+  bool lastOpened{false};
+
+public:
+  SnapshotSegmentOpener(
+      std::ifstream &file,
+      const std::string &encryptionKey,
+      std::uint64_t remainingSize)
+      : file(file),
+        encryptionKeyBytes(encryptionKey.begin(), encryptionKey.end()),
+        remainingSize(remainingSize) {
+  }
+
+  bool openNext(std::vector<std::uint8_t> &buffer) {
+    if (this->lastOpened) {
+      if (this->remainingSize) {
+        throw std::runtime_error(
+            "Client DB store snapshot has trailing data.");
+      }
+      return false;
+    }
+    std::uint32_t sealedDataSize;
+    if (this->remainingSize < sizeof(sealedDataSize) ||
+        !this->file.read(
+            reinterpret_cast<char *>(&sealedDataSize),
+            sizeof(sealedDataSize))) {
+      throw std::runtime_error("Client DB store snapshot is truncated.");
+    }
+    this->remainingSize -= sizeof(sealedDataSize);
+    if (sealedDataSize > this->remainingSize ||
+        sealedDataSize < IV_LENGTH + TAG_LENGTH + SEGMENT_HEADER_SIZE) {
+      throw std::runtime_error("Client DB store snapshot is truncated.");
+    }
+    std::vector<std::uint8_t> sealedData(sealedDataSize);
+    if (!this->file.read(
+            reinterpret_cast<char *>(sealedData.data()), sealedDataSize)) {
+      throw std::runtime_error("Client DB store snapshot is truncated.");
+    }
+    this->remainingSize -= sealedDataSize;
+
+    std::size_t plaintextStart = buffer.size();
+    buffer.resize(plaintextStart + sealedDataSize - IV_LENGTH - TAG_LENGTH);
+    AESCrypto<rust::Slice<std::uint8_t>>::decrypt(
+        rust::Slice<std::uint8_t>(
+            this->encryptionKeyBytes.data(), this->encryptionKeyBytes.size()),
+        rust::Slice<std::uint8_t>(sealedData.data(), sealedData.size()),
+        rust::Slice<std::uint8_t>(
+            buffer.data() + plaintextStart, buffer.size() - plaintextStart));
+
+    SnapshotReader segmentHeader(
+        buffer.data() + plaintextStart, SEGMENT_HEADER_SIZE);
+    std::uint64_t segmentIndex = segmentHeader.readValue<std::uint64_t>();
+    std::uint8_t last = segmentHeader.readValue<std::uint8_t>();
+    if (segmentIndex != this->segmentIndex++ || last > 1) {
+      throw std::runtime_error("Client DB store snapshot segment mismatch.");
+    }
+    this->lastOpened = last;
+    buffer.erase(
+        buffer.begin() + plaintextStart,
+        buffer.begin() + plaintextStart + SEGMENT_HEADER_SIZE);
+    return true;
+  }
+};
+
+std::optional<std::uint64_t>
+ClientDBStoreSnapshot::getGeneration(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  std::uint8_t header[SNAPSHOT_HEADER_SIZE];
+  if (!file.read(reinterpret_cast<char *>(header), SNAPSHOT_HEADER_SIZE)) {
+    return std::nullopt;
+  }
+  return SnapshotReader(header, SNAPSHOT_HEADER_SIZE).readHeader();
+}
+
+std::unique_ptr<ClientDBStore> ClientDBStoreSnapshot::read(
+    const std::string &path,
+    const std::string &encryptionKey,
+    std::uint64_t generation,
+    std::size_t messagesChunkSize,
+    const MessagesChunkCallback &onMessages) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+  std::uint64_t fileSize = file.tellg();
+  file.seekg(0);
+  std::uint8_t header[SNAPSHOT_HEADER_SIZE];
+  if (fileSize < SNAPSHOT_HEADER_SIZE ||
+      !file.read(reinterpret_cast<char *>(header), SNAPSHOT_HEADER_SIZE) ||
+      SnapshotReader(header, SNAPSHOT_HEADER_SIZE).readHeader() !=
+          generation) {
+    return nullptr;
+  }
+
+  auto store = std::make_unique<ClientDBStore>();
+  bool messagesHandedOver = false;
+  try {
+    SnapshotSegmentOpener opener(
+        file, encryptionKey, fileSize - SNAPSHOT_HEADER_SIZE);
+    SnapshotReader reader([&opener](std::vector<std::uint8_t> &buffer) {
+      return opener.openNext(buffer);
+    });
+    // The header is repeated in the authenticated plaintext, so a tampered
+    // header can't make a snapshot pass for another generation.
+    if (reader.readHeader() != generation) {
+      throw std::runtime_error("Client DB store snapshot header mismatch.");
+    }
+    reader.readEntities(store->drafts);
+    reader.readMessages(
+        messagesChunkSize,
+        [&messagesHandedOver,
+         &onMessages](std::vector<MessageEntity> &&chunk) {
+          messagesHandedOver = true;
+          onMessages(std::move(chunk));
+        });
+    reader.readEntities(store->threads);
+    reader.readEntities(store->messageStoreThreads);
+    reader.readEntities(store->reports);
+    reader.readEntities(store->users);
+    reader.readEntities(store->keyservers);
+    reader.readEntities(store->communities);
+    if (!reader.atEnd()) {
+      throw std::runtime_error("Client DB store snapshot has trailing data.");
+    }
+  } catch (const std::exception &e) {
+    if (messagesHandedOver) {
+      throw;
+    }
+    Logger::log(
+        "Failed to read client DB store snapshot. Details: " +
+        std::string(e.what()));
+    return nullptr;
+  }
+  return store;
+}
+
+std::string get_temporary_snapshot_path(const std::string &path) {
+  return path + "_tmp";
+}
+
+void ClientDBStoreSnapshot::writeTemporary(
+    const std::string &path,
+    const std::string &encryptionKey,
+    std::uint64_t generation,
+    const ClientDBStore &store,
+    const std::function<void(const MessagesChunkCallback &)> &readMessages) {
+  std::string tempPath = get_temporary_snapshot_path(path);
+  std::ofstream tempFile(
+      tempPath, std::ofstream::out | std::ofstream::trunc | std::ios::binary);
+  if (!tempFile.is_open()) {
+    throw std::runtime_error(
+        "Failed to open temporary client DB store snapshot file.");
+  }
+
+  try {
+    std::vector<std::uint8_t> header;
+    SnapshotWriter(header).writeHeader(generation);
+    tempFile.write(
+        reinterpret_cast<const char *>(header.data()), header.size());
+
+    SnapshotSegmentSealer sealer(tempFile, encryptionKey);
+    SnapshotWriter writer(
+        sealer.plaintext, [&sealer]() { sealer.sealIfFull(); });
+    writer.writeHeader(generation);
+    writer.writeEntities(store.drafts);
+    readMessages([&writer](std::vector<MessageEntity> &&chunk) {
+      writer.writeMessagesChunk(chunk);
+    });
+    writer.endMessages();
+    writer.writeEntities(store.threads);
+    writer.writeEntities(store.messageStoreThreads);
+    writer.writeEntities(store.reports);
+    writer.writeEntities(store.users);
+    writer.writeEntities(store.keyservers);
+    writer.writeEntities(store.communities);
+    sealer.seal(true);
+    tempFile.close();
+  } catch (...) {
+    tempFile.close();
+    std::remove(tempPath.c_str());
+    throw;
+  }
+  if (!tempFile) {
+    std::remove(tempPath.c_str());
+    throw std::runtime_error("Failed to write client DB store snapshot file.");
+  }
+}
+
+void ClientDBStoreSnapshot::commitTemporary(const std::string &path) {
+  std::string tempPath = get_temporary_snapshot_path(path);
+  if (std::rename(tempPath.c_str(), path.c_str())) {
+    throw std::runtime_error(
+        "Failed to rename complete client DB store snapshot file from "
+        "temporary path to target path.");
+  }
+}
+
+void ClientDBStoreSnapshot::remove(const std::string &path) {
+  std::remove(get_temporary_snapshot_path(path).c_str());
+  std::remove(path.c_str());
+}
+
+} // namespace comm
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "entities/CommunityInfo.h"
+#include "entities/Draft.h"
+#include "entities/KeyserverInfo.h"
+#include "entities/Message.h"
+#include "entities/MessageStoreThread.h"
+#include "entities/Report.h"
+#include "entities/Thread.h"
+#include "entities/UserInfo.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+// Everything `getClientDBStore` hands over to JS.
+struct ClientDBStore {
+  std::vector<Draft> drafts;
+  std::vector<MessageEntity> messages;
+  std::vector<Thread> threads;
+  std::vector<MessageStoreThread> messageStoreThreads;
+  std::vector<Report> reports;
+  std::vector<UserInfo> users;
+  std::vector<KeyserverInfo> keyservers;
+  std::vector<CommunityInfo> communities;
+};
+
+// Encrypted binary image of the client DB store, which lets cold start skip
+// querying the database. The database stays the source of truth: a snapshot
+// is tagged with the generation of the store it was taken at and is ignored
+// once the store moves on, so it can be dropped at any time. It's sealed in
+// segments, so neither writing nor reading it holds all of it in memory.
+class ClientDBStoreSnapshot {
+public:
+  using MessagesChunkCallback =
+      std::function<void(std::vector<MessageEntity> &&)>;
+
+  // Reads only the unencrypted header of the snapshot.
+  static std::optional<std::uint64_t> getGeneration(const std::string &path);
+  // Returns nullptr if there is no readable snapshot of the given generation.
+  // Messages are left out of the returned store and handed over to
+  // `onMessages` in chunks of `messagesChunkSize` as they are decrypted
+  // instead. Throws if the snapshot turns out to be unreadable once some of
+  // them were handed over.
+  static std::unique_ptr<ClientDBStore> read(
+      const std::string &path,
+      const std::string &encryptionKey,
+      std::uint64_t generation,
+      std::size_t messagesChunkSize,
+      const MessagesChunkCallback &onMessages);
+  // Writes the snapshot to the temporary path of `path`. It only replaces
+  // the current snapshot once it's committed. Messages of `store` are
+  // ignored, they are taken from `readMessages` chunk by chunk instead.
+  static void writeTemporary(
+      const std::string &path,
+      const std::string &encryptionKey,
+      std::uint64_t generation,
+      const ClientDBStore &store,
+      const std::function<void(const MessagesChunkCallback &)> &readMessages);
+  static void commitTemporary(const std::string &path);
+  // Also removes a temporary snapshot that wasn't committed.
+  static void remove(const std::string &path);
+};
+
+} // namespace comm
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace comm {
+
+struct DatabaseMaintenanceReport {
+  // Pages returned to the file system.
+  int64_t pagesReclaimed{0};
+  int64_t timeSpentMs{0};
+  // The database was rebuilt to switch it to incremental auto vacuum.
+  bool autoVacuumConverted{false};
+  // The database is too large to be rebuilt within the time budget.
+  bool autoVacuumConversionPending{false};
+  // The message search index has to be rebuilt, because rebuilding the
+  // database renumbered the rowids it refers to.
+  bool messageSearchIndexReset{false};
+  bool optimized{false};
+  bool analyzed{false};
+  // False if the time budget ran out before all maintenance was done.
+  bool completed{false};
+
+  void add(const DatabaseMaintenanceReport &report) {
+    this->pagesReclaimed += report.pagesReclaimed;
+    this->timeSpentMs += report.timeSpentMs;
+    this->autoVacuumConverted |= report.autoVacuumConverted;
+    this->autoVacuumConversionPending = report.autoVacuumConversionPending;
+    this->messageSearchIndexReset |= report.messageSearchIndexReset;
+    this->optimized |= report.optimized;
+    this->analyzed |= report.analyzed;
+    this->completed = report.completed;
+  }
+};
+
+} // namespace comm
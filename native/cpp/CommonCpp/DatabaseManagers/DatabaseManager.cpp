@@ -95,4 +95,16 @@ void DatabaseManager::reportDBOperationsFailure() {
   CommSecureStore::set(DATABASE_MANAGER_STATUS_KEY, DB_OPERATIONS_FAILURE);
 }
 
+void DatabaseManager::setCurrentThreadReadOnly() {
+  SQLiteQueryExecutor::setCurrentThreadReadOnly();
+}
+
+void DatabaseManager::setCurrentThreadWriter() {
+  SQLiteQueryExecutor::setCurrentThreadWriter();
+}
+
+bool DatabaseManager::areReadConnectionsSupported() {
+  return sqlite3_threadsafe() != 0;
+}
+
 } // namespace comm
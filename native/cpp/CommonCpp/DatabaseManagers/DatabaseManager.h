@@ -20,6 +20,15 @@ public:
   static void initializeQueryExecutor(std::string &databasePath);
   static bool checkIfDatabaseNeedsDeletion();
   static void reportDBOperationsFailure();
+  // Makes queries issued from the calling thread use a dedicated read-only
+  // database connection.
+  static void setCurrentThreadReadOnly();
+  // Makes the writer connection usable only from the calling thread, which
+  // has to be the database thread.
+  static void setCurrentThreadWriter();
+  // Connections can only be used on several threads at once if SQLite was
+  // built with its mutexes, i.e. not with SQLITE_THREADSAFE=0.
+  static bool areReadConnectionsSupported();
 };
 
 } // namespace comm
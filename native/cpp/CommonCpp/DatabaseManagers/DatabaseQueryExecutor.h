@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../CryptoTools/Persist.h"
+#include "ClientDBStoreSnapshot.h"
+#include "DatabaseMaintenanceReport.h"
 #include "entities/CommunityInfo.h"
 #include "entities/Draft.h"
 #include "entities/KeyserverInfo.h"
@@ -11,8 +13,12 @@
 #include "entities/PersistItem.h"
 #include "entities/Report.h"
 #include "entities/Thread.h"
+#include "entities/ThreadPatch.h"
+#include "entities/ThreadSummary.h"
 #include "entities/UserInfo.h"
 
+#include <functional>
+#include <optional>
 #include <string>
 
 namespace comm {
@@ -34,10 +40,53 @@ public:
   virtual void removeAllMessages() const = 0;
   virtual std::vector<std::pair<Message, std::vector<Media>>>
   getAllMessages() const = 0;
+  // Streams all messages ordered by id, handing them over in chunks of at
+  // least `chunkSize` messages (the last one may be smaller) so that callers
+  // never have to hold the whole table in memory at once.
+  virtual void getAllMessagesInChunks(
+      std::size_t chunkSize,
+      const std::function<void(std::vector<MessageEntity> &&)> &onChunk)
+      const = 0;
+  // Returns up to `limit` messages of the thread older than the message
+  // with `beforeTime` and `beforeID`, newest first. Messages with the same
+  // time are ordered by id. Uses the (thread, time, id) index, and media are
+  // fetched only for the returned messages. Pages hold at most 500 messages,
+  // larger limits are clamped.
+  virtual std::vector<std::pair<Message, std::vector<Media>>>
+  getMessagesForThread(
+      std::string threadID,
+      int64_t beforeTime,
+      std::string beforeID,
+      int limit) const = 0;
+  // Returns up to `limit` messages of the thread newer than the message with
+  // `afterTime` and `afterID`, oldest first.
+  virtual std::vector<std::pair<Message, std::vector<Media>>>
+  getMessagesForThreadAfter(
+      std::string threadID,
+      int64_t afterTime,
+      std::string afterID,
+      int limit) const = 0;
+  // Returns ids of text messages matching all words of the query, the last
+  // one by prefix, best matches first. Pages are selected by `limit` and
+  // `offset`.
+  virtual std::vector<std::string> searchMessages(
+      std::string query,
+      std::optional<std::string> threadID,
+      int limit,
+      int offset) const = 0;
+  // Adds up to `messagesCount` messages created before the search index to
+  // it. Returns true once all of them are indexed.
+  virtual bool indexMessagesForSearch(int messagesCount) const = 0;
+  // Empties the search index, so that `indexMessagesForSearch` rebuilds it
+  // from all messages. Has to run in a transaction.
+  virtual void resetMessageSearchIndex() const = 0;
+  // Message count and latest message of every thread with messages.
+  virtual std::vector<ThreadSummary> getThreadSummaries() const = 0;
   virtual void removeMessages(const std::vector<std::string> &ids) const = 0;
   virtual void
   removeMessagesForThreads(const std::vector<std::string> &threadIDs) const = 0;
   virtual void replaceMessage(const Message &message) const = 0;
+  virtual void replaceMessages(const std::vector<Message> &messages) const = 0;
   virtual void rekeyMessage(std::string from, std::string to) const = 0;
   virtual void removeAllMedia() const = 0;
   virtual void replaceMessageStoreThreads(
@@ -52,10 +101,13 @@ public:
   virtual void
   removeMediaForThreads(const std::vector<std::string> &thread_ids) const = 0;
   virtual void replaceMedia(const Media &media) const = 0;
+  virtual void replaceMedias(const std::vector<Media> &medias) const = 0;
   virtual void rekeyMediaContainers(std::string from, std::string to) const = 0;
   virtual std::vector<Thread> getAllThreads() const = 0;
   virtual void removeThreads(std::vector<std::string> ids) const = 0;
   virtual void replaceThread(const Thread &thread) const = 0;
+  // Returns false if there is no thread with the ID of the patch.
+  virtual bool patchThread(const ThreadPatch &patch) const = 0;
   virtual void removeAllThreads() const = 0;
   virtual void replaceReport(const Report &report) const = 0;
   virtual void removeReports(const std::vector<std::string> &ids) const = 0;
@@ -78,8 +130,31 @@ public:
   virtual void removeAllCommunities() const = 0;
   virtual std::vector<CommunityInfo> getAllCommunities() const = 0;
   virtual void beginTransaction() const = 0;
+  // Begins a transaction and takes its snapshot right away instead of on the
+  // first read.
+  virtual void beginReadTransaction() const = 0;
+  // Bumps the generation of the client DB store if the transaction changed
+  // it.
   virtual void commitTransaction() const = 0;
   virtual void rollbackTransaction() const = 0;
+  // Changes to the client DB store have to be committed by a transaction for
+  // the store generation to be bumped, so writes that would otherwise run
+  // outside of one go through this. Rolls back if they throw.
+  void runInTransaction(const std::function<void()> &writes) const {
+    this->beginTransaction();
+    try {
+      writes();
+      this->commitTransaction();
+    } catch (...) {
+      this->rollbackTransaction();
+      throw;
+    }
+  }
+  // Savepoints nest within the current transaction, so a part of it can be
+  // rolled back on its own. Rolling back to a savepoint also releases it.
+  virtual void createSavepoint(const std::string &name) const = 0;
+  virtual void releaseSavepoint(const std::string &name) const = 0;
+  virtual void rollbackToSavepoint(const std::string &name) const = 0;
   virtual std::vector<OlmPersistSession> getOlmPersistSessionsData() const = 0;
   virtual std::optional<std::string> getOlmPersistAccountData() const = 0;
   virtual void
@@ -102,12 +177,47 @@ public:
 #ifdef EMSCRIPTEN
   virtual std::vector<WebThread> getAllThreadsWeb() const = 0;
   virtual void replaceThreadWeb(const WebThread &thread) const = 0;
+  virtual bool patchThreadWeb(const WebThreadPatch &patch) const = 0;
   virtual std::vector<MessageWithMedias> getAllMessagesWeb() const = 0;
+  virtual std::vector<MessageWithMedias> getMessagesForThreadWeb(
+      std::string threadID,
+      std::string beforeTime,
+      std::string beforeID,
+      int limit) const = 0;
+  virtual std::vector<MessageWithMedias> getMessagesForThreadAfterWeb(
+      std::string threadID,
+      std::string afterTime,
+      std::string afterID,
+      int limit) const = 0;
+  virtual std::vector<std::string> searchMessagesWeb(
+      std::string query,
+      NullableString threadID,
+      int limit,
+      int offset) const = 0;
+  virtual std::vector<WebThreadSummary> getThreadSummariesWeb() const = 0;
   virtual void replaceMessageWeb(const WebMessage &message) const = 0;
   virtual NullableString getOlmPersistAccountDataWeb() const = 0;
 #else
   virtual void createMainCompaction(std::string backupID) const = 0;
   virtual void captureBackupLogs() const = 0;
+  // Returns nullptr unless the snapshot is up to date with the database.
+  // Messages are handed over to `onMessages` in chunks instead of being
+  // returned with the rest of the store, see `ClientDBStoreSnapshot::read`.
+  virtual std::unique_ptr<ClientDBStore> getClientDBStoreSnapshot(
+      std::size_t messagesChunkSize,
+      const std::function<void(std::vector<MessageEntity> &&)> &onMessages)
+      const = 0;
+  // Does nothing if the snapshot is already up to date.
+  virtual void writeClientDBStoreSnapshot() const = 0;
+  // Reclaims free pages and refreshes the query planner statistics. Stops
+  // once `timeBudgetMs` is used up, so it has to be called until the report
+  // says it completed.
+  virtual DatabaseMaintenanceReport
+  performMaintenance(int timeBudgetMs) const = 0;
+  // Rebuilds the database to switch it to incremental auto vacuum, however
+  // long it takes, so it has to run while the user isn't waiting for the
+  // database.
+  virtual DatabaseMaintenanceReport convertToIncrementalAutoVacuum() const = 0;
 #endif
 };
 
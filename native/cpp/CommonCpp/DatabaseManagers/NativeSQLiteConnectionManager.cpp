@@ -191,11 +191,8 @@ bool NativeSQLiteConnectionManager::getLogsMonitoring() {
   return sqlite3session_enable(backupLogsSession, -1);
 }
 
-void NativeSQLiteConnectionManager::initializeConnection(
-    std::string sqliteFilePath,
-    std::function<void(sqlite3 *)> on_db_open_callback) {
-  SQLiteConnectionManager::initializeConnection(
-      sqliteFilePath, on_db_open_callback);
+void NativeSQLiteConnectionManager::adoptConnection(sqlite3 *connection) {
+  SQLiteConnectionManager::adoptConnection(connection);
   attachSession();
   setLogsMonitoring(false);
 }
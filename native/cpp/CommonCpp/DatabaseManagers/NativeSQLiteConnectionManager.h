@@ -22,9 +22,7 @@ public:
   NativeSQLiteConnectionManager();
   void setLogsMonitoring(bool enabled);
   bool getLogsMonitoring();
-  void initializeConnection(
-      std::string sqliteFilePath,
-      std::function<void(sqlite3 *)> on_db_open_callback) override;
+  void adoptConnection(sqlite3 *connection) override;
   void closeConnection() override;
   ~NativeSQLiteConnectionManager();
   bool captureLogs(
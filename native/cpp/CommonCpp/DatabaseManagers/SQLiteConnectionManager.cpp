@@ -1,6 +1,8 @@
 #include "SQLiteConnectionManager.h"
 
+#include "CancellationToken.h"
 #include "Logger.h"
+#include "SQLiteProfiler.h"
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -8,7 +10,8 @@
 
 namespace comm {
 
-SQLiteConnectionManager::SQLiteConnectionManager() : dbConnection(nullptr) {
+SQLiteConnectionManager::SQLiteConnectionManager()
+    : statementCacheHits(0), statementCacheMisses(0), dbConnection(nullptr) {
 }
 
 sqlite3 *SQLiteConnectionManager::getConnection() {
@@ -25,6 +28,15 @@ void SQLiteConnectionManager::handleSQLiteError(
   }
 }
 
+void SQLiteConnectionManager::finalizeStatement(sqlite3_stmt *statement) {
+  SQLiteProfiler::onStatementFinalized(statement);
+  sqlite3_finalize(statement);
+}
+
+int SQLiteConnectionManager::interruptIfTaskCancelled(void *context) {
+  return CancellationScope::isCurrentTaskCancelled();
+}
+
 void SQLiteConnectionManager::initializeConnection(
     std::string sqliteFilePath,
     std::function<void(sqlite3 *)> on_db_open_callback) {
@@ -32,9 +44,32 @@ void SQLiteConnectionManager::initializeConnection(
     return;
   }
 
-  int connectResult = sqlite3_open(sqliteFilePath.c_str(), &dbConnection);
+  sqlite3 *connection;
+  int connectResult = sqlite3_open(sqliteFilePath.c_str(), &connection);
   handleSQLiteError(connectResult, "Failed to open database connection.");
-  on_db_open_callback(dbConnection);
+  on_db_open_callback(connection);
+  adoptConnection(connection);
+}
+
+void SQLiteConnectionManager::adoptConnection(sqlite3 *connection) {
+  if (dbConnection) {
+    sqlite3_close(connection);
+    throw std::runtime_error(
+        "Programmer error: attempt to adopt a connection but database "
+        "connection is already initialized.");
+  }
+
+  dbConnection = connection;
+  // Statements of a task whose cancellation token gets cancelled fail with
+  // SQLITE_INTERRUPT instead of running to completion.
+  sqlite3_progress_handler(
+      dbConnection,
+      interruptCheckInstructionsCount,
+      SQLiteConnectionManager::interruptIfTaskCancelled,
+      nullptr);
+  if (SQLiteProfiler::isEnabled()) {
+    SQLiteProfiler::attach(dbConnection);
+  }
 }
 
 void SQLiteConnectionManager::closeConnectionInternal() {
@@ -42,9 +77,24 @@ void SQLiteConnectionManager::closeConnectionInternal() {
     return;
   }
 
-  int closeResult = sqlite3_close(dbConnection);
-  handleSQLiteError(closeResult, "Failed to close database connection.");
+  clearStatementCache();
+  // Statements that are still handed out are finalized on release.
+  // sqlite3_close_v2 defers freeing the connection until then, whereas
+  // sqlite3_close would fail with SQLITE_BUSY and leak it.
+  if (!preparedStatementsCache.empty()) {
+    Logger::log(
+        "Closing database connection with " +
+        std::to_string(preparedStatementsCache.size()) +
+        " prepared statements still in use.");
+  }
+  int closeResult = sqlite3_close_v2(dbConnection);
   dbConnection = nullptr;
+  if (closeResult != SQLITE_OK) {
+    Logger::log(
+        std::string{"Failed to close database connection. Details: "} +
+        sqlite3_errstr(closeResult));
+  }
+  handleSQLiteError(closeResult, "Failed to close database connection.");
 }
 
 void SQLiteConnectionManager::closeConnection() {
@@ -55,6 +105,99 @@ SQLiteConnectionManager::~SQLiteConnectionManager() {
   closeConnectionInternal();
 }
 
+sqlite3_stmt *SQLiteConnectionManager::acquirePreparedStatement(
+    const std::string &sql,
+    const std::string *&cacheKey) {
+  if (!dbConnection) {
+    throw std::runtime_error(
+        "Programmer error: attempt to prepare statement but database "
+        "connection is not initialized.");
+  }
+
+  auto cachedStatement = preparedStatementsCache.find(sql);
+  if (cachedStatement != preparedStatementsCache.end() &&
+      !cachedStatement->second.inUse) {
+    statementCacheHits++;
+    cachedStatement->second.inUse = true;
+    idleStatements.erase(cachedStatement->second.idlePosition);
+    cacheKey = &cachedStatement->first;
+    return cachedStatement->second.statement;
+  }
+
+  statementCacheMisses++;
+  sqlite3_stmt *statement;
+  int prepareSQLResult = sqlite3_prepare_v3(
+      dbConnection,
+      sql.c_str(),
+      -1,
+      SQLITE_PREPARE_PERSISTENT,
+      &statement,
+      nullptr);
+  handleSQLiteError(prepareSQLResult, "Failed to prepare SQL statement.");
+  SQLiteProfiler::onStatementPrepared(statement);
+
+  cacheKey = nullptr;
+  if (cachedStatement != preparedStatementsCache.end()) {
+    return statement;
+  }
+  if (preparedStatementsCache.size() >= preparedStatementsCacheCapacity) {
+    if (idleStatements.empty()) {
+      return statement;
+    }
+    auto leastRecentlyUsed =
+        preparedStatementsCache.find(*idleStatements.front());
+    idleStatements.pop_front();
+    finalizeStatement(leastRecentlyUsed->second.statement);
+    preparedStatementsCache.erase(leastRecentlyUsed);
+  }
+  auto insertedStatement = preparedStatementsCache.emplace(
+      sql, CachedStatement{statement, true, false, idleStatements.end()});
+  cacheKey = &insertedStatement.first->first;
+  return statement;
+}
+
+void SQLiteConnectionManager::releasePreparedStatement(
+    const std::string *cacheKey,
+    sqlite3_stmt *statement) {
+  if (!cacheKey) {
+    finalizeStatement(statement);
+    return;
+  }
+
+  sqlite3_reset(statement);
+  sqlite3_clear_bindings(statement);
+
+  auto cachedStatement = preparedStatementsCache.find(*cacheKey);
+  if (!cachedStatement->second.evicted) {
+    cachedStatement->second.inUse = false;
+    cachedStatement->second.idlePosition =
+        idleStatements.insert(idleStatements.end(), cacheKey);
+    return;
+  }
+  preparedStatementsCache.erase(cachedStatement);
+  finalizeStatement(statement);
+}
+
+void SQLiteConnectionManager::clearStatementCache() {
+  auto cachedStatement = preparedStatementsCache.begin();
+  while (cachedStatement != preparedStatementsCache.end()) {
+    // statements that are in use are finalized on release
+    if (cachedStatement->second.inUse) {
+      cachedStatement->second.evicted = true;
+      cachedStatement++;
+      continue;
+    }
+    finalizeStatement(cachedStatement->second.statement);
+    cachedStatement = preparedStatementsCache.erase(cachedStatement);
+  }
+  idleStatements.clear();
+}
+
+StatementCacheStats SQLiteConnectionManager::getStatementCacheStats() const {
+  return {
+      statementCacheHits, statementCacheMisses, preparedStatementsCache.size()};
+}
+
 void SQLiteConnectionManager::restoreFromBackupLog(
     const std::vector<std::uint8_t> &backupLog) {
   if (!dbConnection) {
@@ -6,10 +6,51 @@
 
 #include <sqlite3.h>
 #include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace comm {
+
+struct StatementCacheStats {
+  std::size_t hits;
+  std::size_t misses;
+  std::size_t size;
+};
+
 class SQLiteConnectionManager {
+  struct CachedStatement {
+    sqlite3_stmt *statement;
+    bool inUse;
+    // set when the cache is cleared while the statement is handed out, the
+    // entry is then dropped on release
+    bool evicted;
+    // position in idleStatements, only meaningful when the statement isn't
+    // in use
+    std::list<const std::string *>::iterator idlePosition;
+  };
+
+  // Prepared statements are cached by their SQL text. A cached statement is
+  // marked as in use while it is handed out, so nested usage of the same
+  // query prepares a fresh, uncached statement instead of sharing it. The
+  // cache owns the SQL text, and an entry stays in the map for as long as its
+  // statement is handed out, so borrowers can refer to it by its key.
+  std::unordered_map<std::string, CachedStatement> preparedStatementsCache;
+  // Keys of cached statements that aren't handed out, least recently used
+  // first. When the cache is full, the first of them is evicted to make room
+  // for a new statement.
+  std::list<const std::string *> idleStatements;
+  std::size_t statementCacheHits;
+  std::size_t statementCacheMisses;
+  static const std::size_t preparedStatementsCacheCapacity = 128;
+  // How many virtual machine instructions SQLite runs between checks whether
+  // the statement should be interrupted.
+  static const int interruptCheckInstructionsCount = 1000;
+
+  static int interruptIfTaskCancelled(void *context);
+  static void finalizeStatement(sqlite3_stmt *statement);
+
 protected:
   sqlite3 *dbConnection;
   static void handleSQLiteError(
@@ -24,8 +65,23 @@ public:
   virtual void initializeConnection(
       std::string sqliteFilePath,
       std::function<void(sqlite3 *)> on_db_open_callback);
+  // Takes over a connection that the caller opened and set up, e.g. the one
+  // migrations ran on, so that it doesn't have to be opened again.
+  virtual void adoptConnection(sqlite3 *connection);
   virtual void closeConnection();
   virtual ~SQLiteConnectionManager();
   virtual void restoreFromBackupLog(const std::vector<std::uint8_t> &backupLog);
+
+  // `cacheKey` is set to the key of the cache entry the statement belongs to,
+  // or to nullptr if the statement isn't cached. It stays valid until the
+  // statement is released.
+  sqlite3_stmt *acquirePreparedStatement(
+      const std::string &sql,
+      const std::string *&cacheKey);
+  void releasePreparedStatement(
+      const std::string *cacheKey,
+      sqlite3_stmt *statement);
+  void clearStatementCache();
+  StatementCacheStats getStatementCacheStats() const;
 };
 } // namespace comm
@@ -0,0 +1,34 @@
+#include "SQLitePerformanceProfile.h"
+
+namespace comm {
+
+const std::vector<SQLitePerformanceProfile> &
+SQLitePerformanceProfile::getPresets() {
+  static const std::vector<SQLitePerformanceProfile> presets{
+      SQLitePerformanceProfile::lowMemory,
+      SQLitePerformanceProfile::standard,
+      SQLitePerformanceProfile::desktop};
+  return presets;
+}
+
+std::string SQLitePerformanceProfile::getCipherSettingsSQL(
+    const std::string &schemaName) const {
+  return "PRAGMA " + schemaName +
+      ".cipher_page_size = " + std::to_string(this->cipherPageSize) + ";";
+}
+
+std::string SQLitePerformanceProfile::getConnectionSettingsSQL() const {
+  // A negative cache size is in KiB rather than in pages.
+  return "PRAGMA cache_size = -" + std::to_string(this->cacheSizeKiB) +
+      ";"
+      "PRAGMA temp_store = " +
+      (this->tempStoreInMemory ? "MEMORY" : "FILE") +
+      ";"
+      "PRAGMA synchronous = " +
+      this->synchronous +
+      ";"
+      "PRAGMA journal_mode = " +
+      this->journalMode + ";";
+}
+
+} // namespace comm
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace comm {
+
+// Settings SQLite and SQLCipher are tuned with. Connection settings are
+// applied to every connection when it's opened, the cipher page size is part
+// of the database file format.
+//
+// Some settings are deliberately left out. SQLCipher never memory-maps
+// encrypted databases, so `mmap_size` has no effect. We use raw keys, which
+// skip key derivation, so KDF settings don't matter. Disabling HMAC would
+// give up detecting tampered pages.
+struct SQLitePerformanceProfile {
+  std::string name;
+  // Page cache of each connection. There is one writer connection and one
+  // per read thread.
+  int cacheSizeKiB;
+  // Whether temporary tables and indexes, e.g. ones built for sorting, are
+  // kept in memory rather than in temporary files.
+  bool tempStoreInMemory;
+  // With the write-ahead log, NORMAL keeps the database intact but may lose
+  // the last commits after a power loss, FULL syncs the log on every commit.
+  std::string synchronous;
+  // With the write-ahead log, reads of the read connections don't hold back
+  // commits of the writer connection and the other way round.
+  std::string journalMode;
+  // Databases created with a different page size are re-encrypted with
+  // `sqlcipher_export` on open. Backups are copied page by page with
+  // sqlite3_backup, which needs the same page size on both ends, also across
+  // devices, so all presets keep SQLCipher's default.
+  int cipherPageSize;
+
+  // Android devices reporting isLowRamDevice use lowMemory, all other
+  // devices use standard.
+  static const SQLitePerformanceProfile lowMemory;
+  static const SQLitePerformanceProfile standard;
+  // Not selected on any platform, it's only used by the benchmarks. A larger
+  // cache speeds up queries that revisit pages, like search and loading
+  // threads, but loading all messages scans tables larger than the cache
+  // once, and wasn't faster than with standard.
+  static const SQLitePerformanceProfile desktop;
+  static const std::vector<SQLitePerformanceProfile> &getPresets();
+
+  // Has to run after the key is set and before the database is first read.
+  std::string getCipherSettingsSQL(const std::string &schemaName) const;
+  std::string getConnectionSettingsSQL() const;
+};
+
+// Defined inline, so they're initialized before static variables copying
+// them in any file including this header, like
+// SQLiteQueryExecutor::performanceProfile, whatever the order files are
+// initialized in.
+inline const SQLitePerformanceProfile SQLitePerformanceProfile::lowMemory{
+    "lowMemory", 1024, false, "FULL", "WAL", 4096};
+
+inline const SQLitePerformanceProfile SQLitePerformanceProfile::standard{
+    "standard", 4096, true, "FULL", "WAL", 4096};
+
+inline const SQLitePerformanceProfile SQLitePerformanceProfile::desktop{
+    "desktop", 32768, true, "FULL", "WAL", 4096};
+
+} // namespace comm
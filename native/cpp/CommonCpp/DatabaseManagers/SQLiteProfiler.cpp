@@ -0,0 +1,291 @@
+#include "SQLiteProfiler.h"
+
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace comm {
+
+std::atomic<bool> SQLiteProfiler::enabled{false};
+std::mutex SQLiteProfiler::aggregatesMutex;
+std::unordered_map<std::string, SQLiteProfiler::Aggregate>
+    SQLiteProfiler::aggregates;
+
+thread_local std::
+    unordered_map<sqlite3_stmt *, SQLiteProfiler::RunningStatement>
+        SQLiteProfiler::runningStatements;
+thread_local std::unordered_map<
+    std::string,
+    SQLiteProfiler::AggregateEntry *>
+    SQLiteProfiler::unpreparedStatementAggregates;
+thread_local sqlite3_stmt *SQLiteProfiler::lastStatement{nullptr};
+thread_local SQLiteProfiler::RunningStatement
+    *SQLiteProfiler::lastRunningStatement{nullptr};
+
+// Above this many distinct SQL texts, new ones are normalized before they are
+// stored, so that queries built for many different numbers of keys don't grow
+// the aggregates without bound.
+const std::size_t maxExactSQLAggregatesCount = 1024;
+
+std::string SQLiteProfiler::normalizeSQL(const char *sql) {
+  std::string normalized;
+  for (const char *character = sql; *character; character++) {
+    normalized += *character;
+    if (*character == '?') {
+      // "?, ?, ?" -> "?"
+      while (!std::strncmp(character + 1, ", ?", 3)) {
+        character += 3;
+      }
+    } else if (
+        *character == ')' && normalized.size() >= 8 &&
+        !normalized.compare(normalized.size() - 8, 8, "(?), (?)")) {
+      // "(?), (?)" -> "(?)"
+      normalized.resize(normalized.size() - 5);
+    }
+  }
+  return normalized;
+}
+
+SQLiteProfiler::RunningStatement &
+SQLiteProfiler::getRunningStatement(sqlite3_stmt *statement) {
+  // Row events of a statement come one after another, so the last statement
+  // is looked up first.
+  if (statement != SQLiteProfiler::lastStatement) {
+    SQLiteProfiler::lastRunningStatement =
+        &SQLiteProfiler::runningStatements[statement];
+    SQLiteProfiler::lastStatement = statement;
+  }
+  return *SQLiteProfiler::lastRunningStatement;
+}
+
+SQLiteProfiler::AggregateEntry *SQLiteProfiler::getAggregate(const char *sql) {
+  std::lock_guard<std::mutex> lock(SQLiteProfiler::aggregatesMutex);
+  auto aggregate = SQLiteProfiler::aggregates.find(sql);
+  if (aggregate == SQLiteProfiler::aggregates.end()) {
+    std::string key =
+        SQLiteProfiler::aggregates.size() < maxExactSQLAggregatesCount
+        ? std::string{sql}
+        : SQLiteProfiler::normalizeSQL(sql);
+    aggregate = SQLiteProfiler::aggregates.try_emplace(std::move(key)).first;
+  }
+  return &*aggregate;
+}
+
+int SQLiteProfiler::traceCallback(
+    unsigned int traceType,
+    void *context,
+    void *statement,
+    void *traceData) {
+  if (!SQLiteProfiler::enabled.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+  auto *sqlStatement = static_cast<sqlite3_stmt *>(statement);
+  RunningStatement &runningStatement =
+      SQLiteProfiler::getRunningStatement(sqlStatement);
+  if (traceType == SQLITE_TRACE_ROW) {
+    runningStatement.rowsReturned++;
+    return 0;
+  }
+
+  std::uint64_t timeNs = *static_cast<sqlite3_int64 *>(traceData);
+  std::uint64_t rowsReturned = runningStatement.rowsReturned;
+  runningStatement.rowsReturned = 0;
+  std::uint64_t rowsChanged = 0;
+  if (!sqlite3_stmt_readonly(sqlStatement)) {
+    rowsChanged = sqlite3_changes(sqlite3_db_handle(sqlStatement));
+  }
+  AggregateEntry *aggregateEntry = runningStatement.aggregate;
+  if (!aggregateEntry) {
+    // Nothing tells when the statement is finalized, and SQLite may reuse its
+    // pointer for another one afterwards, so it's forgotten right away.
+    SQLiteProfiler::onStatementFinalized(sqlStatement);
+    const char *sql = sqlite3_sql(sqlStatement);
+    auto &aggregates = SQLiteProfiler::unpreparedStatementAggregates;
+    auto aggregate = aggregates.find(sql);
+    if (aggregate == aggregates.end()) {
+      if (aggregates.size() >= maxExactSQLAggregatesCount) {
+        aggregates.clear();
+      }
+      aggregate =
+          aggregates.emplace(sql, SQLiteProfiler::getAggregate(sql)).first;
+    }
+    aggregateEntry = aggregate->second;
+  }
+
+  // Bucket n holds times from 2^n up to 2^(n + 1) nanoseconds.
+  std::size_t histogramBucket = 0;
+  while (histogramBucket < 63 && (timeNs >> histogramBucket) > 1) {
+    histogramBucket++;
+  }
+
+  Aggregate &aggregate = aggregateEntry->second;
+  aggregate.callsCount.fetch_add(1, std::memory_order_relaxed);
+  aggregate.totalTimeNs.fetch_add(timeNs, std::memory_order_relaxed);
+  aggregate.rowsReturned.fetch_add(rowsReturned, std::memory_order_relaxed);
+  aggregate.rowsChanged.fetch_add(rowsChanged, std::memory_order_relaxed);
+  aggregate.timeHistogram[histogramBucket].fetch_add(
+      1, std::memory_order_relaxed);
+  std::atomic<std::uint64_t> &maxTimeNs =
+      aggregate.maxTimesNs[histogramBucket];
+  std::uint64_t currentMaxTimeNs = maxTimeNs.load(std::memory_order_relaxed);
+  while (currentMaxTimeNs < timeNs &&
+         !maxTimeNs.compare_exchange_weak(
+             currentMaxTimeNs, timeNs, std::memory_order_relaxed)) {
+  }
+  return 0;
+}
+
+std::uint64_t SQLiteProfiler::getPercentile(
+    const std::array<std::uint64_t, 64> &timeHistogram,
+    const std::array<std::uint64_t, 64> &maxTimesNs,
+    std::uint64_t callsCount,
+    std::uint64_t percentile) {
+  std::uint64_t callsBelow = 0;
+  std::uint64_t threshold = (callsCount * percentile + 99) / 100;
+  for (std::size_t bucket = 0; bucket < timeHistogram.size(); bucket++) {
+    callsBelow += timeHistogram[bucket];
+    if (callsBelow >= threshold) {
+      return maxTimesNs[bucket];
+    }
+  }
+  return 0;
+}
+
+void SQLiteProfiler::setEnabled(bool enabled) {
+  SQLiteProfiler::enabled.store(enabled);
+}
+
+bool SQLiteProfiler::isEnabled() {
+  return SQLiteProfiler::enabled.load();
+}
+
+void SQLiteProfiler::attach(sqlite3 *db) {
+  sqlite3_trace_v2(
+      db,
+      SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW,
+      SQLiteProfiler::traceCallback,
+      nullptr);
+}
+
+void SQLiteProfiler::onStatementPrepared(sqlite3_stmt *statement) {
+  if (!SQLiteProfiler::enabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+  SQLiteProfiler::getRunningStatement(statement) = RunningStatement{
+      SQLiteProfiler::getAggregate(sqlite3_sql(statement)), 0};
+}
+
+void SQLiteProfiler::onStatementFinalized(sqlite3_stmt *statement) {
+  if (SQLiteProfiler::lastStatement == statement) {
+    SQLiteProfiler::lastStatement = nullptr;
+    SQLiteProfiler::lastRunningStatement = nullptr;
+  }
+  SQLiteProfiler::runningStatements.erase(statement);
+}
+
+std::vector<SQLiteStatementProfile> SQLiteProfiler::getProfiles() {
+  struct NormalizedAggregate {
+    std::uint64_t callsCount{0};
+    std::uint64_t totalTimeNs{0};
+    std::uint64_t rowsReturned{0};
+    std::uint64_t rowsChanged{0};
+    std::array<std::uint64_t, 64> timeHistogram{};
+    std::array<std::uint64_t, 64> maxTimesNs{};
+  };
+  std::unordered_map<std::string, NormalizedAggregate> normalizedAggregates;
+  {
+    std::lock_guard<std::mutex> lock(SQLiteProfiler::aggregatesMutex);
+    for (const auto &[sql, aggregate] : SQLiteProfiler::aggregates) {
+      std::uint64_t callsCount = aggregate.callsCount.load();
+      if (!callsCount) {
+        continue;
+      }
+      NormalizedAggregate &normalizedAggregate =
+          normalizedAggregates[SQLiteProfiler::normalizeSQL(sql.c_str())];
+      normalizedAggregate.callsCount += callsCount;
+      normalizedAggregate.totalTimeNs += aggregate.totalTimeNs.load();
+      normalizedAggregate.rowsReturned += aggregate.rowsReturned.load();
+      normalizedAggregate.rowsChanged += aggregate.rowsChanged.load();
+      for (std::size_t bucket = 0; bucket < aggregate.timeHistogram.size();
+           bucket++) {
+        normalizedAggregate.timeHistogram[bucket] +=
+            aggregate.timeHistogram[bucket].load();
+        normalizedAggregate.maxTimesNs[bucket] = std::max(
+            normalizedAggregate.maxTimesNs[bucket],
+            aggregate.maxTimesNs[bucket].load());
+      }
+    }
+  }
+
+  std::vector<SQLiteStatementProfile> profiles;
+  profiles.reserve(normalizedAggregates.size());
+  for (const auto &[sql, aggregate] : normalizedAggregates) {
+    profiles.push_back(
+        {sql,
+         aggregate.callsCount,
+         aggregate.totalTimeNs,
+         SQLiteProfiler::getPercentile(
+             aggregate.timeHistogram,
+             aggregate.maxTimesNs,
+             aggregate.callsCount,
+             50),
+         SQLiteProfiler::getPercentile(
+             aggregate.timeHistogram,
+             aggregate.maxTimesNs,
+             aggregate.callsCount,
+             90),
+         SQLiteProfiler::getPercentile(
+             aggregate.timeHistogram,
+             aggregate.maxTimesNs,
+             aggregate.callsCount,
+             99),
+         aggregate.rowsReturned,
+         aggregate.rowsChanged});
+  }
+  std::sort(
+      profiles.begin(),
+      profiles.end(),
+      [](const SQLiteStatementProfile &a, const SQLiteStatementProfile &b) {
+        return a.totalTimeNs > b.totalTimeNs;
+      });
+  return profiles;
+}
+
+void SQLiteProfiler::logProfiles(std::size_t statementsCount) {
+  std::vector<SQLiteStatementProfile> profiles = SQLiteProfiler::getProfiles();
+  std::stringstream profilesStream;
+  profilesStream << "SQLite profile of " << profiles.size()
+                 << " statements, top " << statementsCount
+                 << " by total time:" << std::endl;
+  for (std::size_t i = 0; i < profiles.size() && i < statementsCount; i++) {
+    const auto &profile = profiles[i];
+    profilesStream << profile.callsCount << " calls, "
+                   << profile.totalTimeNs / 1000 << "us total, p50/p90/p99 "
+                   << profile.p50TimeNs / 1000 << "/"
+                   << profile.p90TimeNs / 1000 << "/"
+                   << profile.p99TimeNs / 1000 << "us, "
+                   << profile.rowsReturned << " rows returned, "
+                   << profile.rowsChanged << " rows changed: " << profile.sql
+                   << std::endl;
+  }
+  Logger::log(profilesStream.str());
+}
+
+void SQLiteProfiler::reset() {
+  std::lock_guard<std::mutex> lock(SQLiteProfiler::aggregatesMutex);
+  for (auto &[sql, aggregate] : SQLiteProfiler::aggregates) {
+    aggregate.callsCount.store(0);
+    aggregate.totalTimeNs.store(0);
+    aggregate.rowsReturned.store(0);
+    aggregate.rowsChanged.store(0);
+    for (auto &bucket : aggregate.timeHistogram) {
+      bucket.store(0);
+    }
+    for (auto &maxTimeNs : aggregate.maxTimesNs) {
+      maxTimeNs.store(0);
+    }
+  }
+}
+
+} // namespace comm
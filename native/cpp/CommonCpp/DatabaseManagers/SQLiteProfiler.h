@@ -0,0 +1,104 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace comm {
+
+struct SQLiteStatementProfile {
+  std::string sql;
+  std::uint64_t callsCount;
+  std::uint64_t totalTimeNs;
+  // Percentiles are approximated by the longest time recorded in the power of
+  // two histogram bucket they fall in, so they are precise up to a factor of
+  // two.
+  std::uint64_t p50TimeNs;
+  std::uint64_t p90TimeNs;
+  std::uint64_t p99TimeNs;
+  std::uint64_t rowsReturned;
+  std::uint64_t rowsChanged;
+};
+
+// Aggregates statistics of every statement run on the connections it is
+// attached to. Statements are grouped by their SQL text with placeholder
+// lists and multi-row VALUES collapsed, so queries built for a different
+// number of keys or rows are counted together.
+//
+// To keep the tracing cheap, statistics are collected per exact SQL text and
+// only grouped by normalized text when profiles are read. Statements prepared
+// by the connection manager are bound to their aggregate once, when they are
+// prepared, so tracing them only looks up the statement pointer and updates
+// counters atomically. Other statements, e.g. ones run with sqlite3_exec, are
+// looked up by their SQL text every time they run.
+class SQLiteProfiler {
+  struct Aggregate {
+    std::atomic<std::uint64_t> callsCount{0};
+    std::atomic<std::uint64_t> totalTimeNs{0};
+    std::atomic<std::uint64_t> rowsReturned{0};
+    std::atomic<std::uint64_t> rowsChanged{0};
+    std::array<std::atomic<std::uint32_t>, 64> timeHistogram{};
+    // Longest time recorded in every bucket of the histogram.
+    std::array<std::atomic<std::uint64_t>, 64> maxTimesNs{};
+  };
+  // Aggregates are never removed, only zeroed on reset, so that threads can
+  // keep pointers to them.
+  using AggregateEntry = std::pair<const std::string, Aggregate>;
+
+  struct RunningStatement {
+    // Null until the statement finishes running if it wasn't prepared by the
+    // connection manager.
+    AggregateEntry *aggregate{nullptr};
+    std::uint64_t rowsReturned{0};
+  };
+
+  static std::atomic<bool> enabled;
+  static std::mutex aggregatesMutex;
+  static std::unordered_map<std::string, Aggregate> aggregates;
+  // Statements prepared or run on the current thread. Each connection is only
+  // used by a single thread.
+  static thread_local std::unordered_map<sqlite3_stmt *, RunningStatement>
+      runningStatements;
+  // Aggregates of statements that weren't prepared by the connection manager,
+  // by their SQL text.
+  static thread_local std::unordered_map<std::string, AggregateEntry *>
+      unpreparedStatementAggregates;
+  static thread_local sqlite3_stmt *lastStatement;
+  static thread_local RunningStatement *lastRunningStatement;
+
+  static RunningStatement &getRunningStatement(sqlite3_stmt *statement);
+  static AggregateEntry *getAggregate(const char *sql);
+  static int traceCallback(
+      unsigned int traceType,
+      void *context,
+      void *statement,
+      void *traceData);
+  static std::uint64_t getPercentile(
+      const std::array<std::uint64_t, 64> &timeHistogram,
+      const std::array<std::uint64_t, 64> &maxTimesNs,
+      std::uint64_t callsCount,
+      std::uint64_t percentile);
+
+public:
+  static std::string normalizeSQL(const char *sql);
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+  // Called by the connection manager for every connection it opens.
+  static void attach(sqlite3 *db);
+  // Called by the connection manager for every statement it prepares, and
+  // before it finalizes one, as SQLite may reuse the pointer of a finalized
+  // statement for another one.
+  static void onStatementPrepared(sqlite3_stmt *statement);
+  static void onStatementFinalized(sqlite3_stmt *statement);
+  // Sorted by total time, descending.
+  static std::vector<SQLiteStatementProfile> getProfiles();
+  static void logProfiles(std::size_t statementsCount);
+  static void reset();
+};
+
+} // namespace comm
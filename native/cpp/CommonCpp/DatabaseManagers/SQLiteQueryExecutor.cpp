@@ -1,14 +1,21 @@
 #include "SQLiteQueryExecutor.h"
 #include "Logger.h"
+#include "SQLitePerformanceProfile.h"
+#include "SQLiteProfiler.h"
 
 #include "entities/CommunityInfo.h"
 #include "entities/EntityQueryHelpers.h"
 #include "entities/KeyserverInfo.h"
 #include "entities/Metadata.h"
 #include "entities/UserInfo.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <thread>
+#include <unordered_map>
 
 #ifndef EMSCRIPTEN
 #include "CommSecureStore.h"
@@ -17,12 +24,28 @@
 #endif
 
 #define ACCOUNT_ID 1
+#define BUSY_TIMEOUT_MS 30000
+#define AUTO_VACUUM_INCREMENTAL 2
+#define INCREMENTAL_VACUUM_PAGES 256
+#define ANALYSIS_LIMIT 1000
+#define ANALYZE_INTERVAL_S (7 * 24 * 60 * 60)
+// How fast VACUUM rewrites the database, measured on a desktop and divided
+// by 16 to account for slower storage of phones and for encryption.
+#define VACUUM_BYTES_PER_MS (10 * 1024)
+// Media of a page are fetched with an IN list of its message IDs, which has to
+// stay below SQLITE_LIMIT_VARIABLE_NUMBER, 999 in older SQLite versions.
+#define MAX_MESSAGES_PAGE_SIZE 500
+#define MESSAGE_SEARCH_INDEX_RESET_PENDING "message_search_index_reset_pending"
 
 namespace comm {
 
 std::string SQLiteQueryExecutor::sqliteFilePath;
 std::string SQLiteQueryExecutor::encryptionKey;
+SQLitePerformanceProfile SQLiteQueryExecutor::performanceProfile =
+    SQLitePerformanceProfile::standard;
 std::once_flag SQLiteQueryExecutor::initialized;
+std::atomic<bool> SQLiteQueryExecutor::migrated{false};
+std::mutex SQLiteQueryExecutor::migrationMutex;
 int SQLiteQueryExecutor::sqlcipherEncryptionKeySize = 64;
 // Should match constant defined in `native_rust_library/src/constants.rs`
 std::string SQLiteQueryExecutor::secureStoreEncryptionKeyID =
@@ -34,6 +57,22 @@ std::string SQLiteQueryExecutor::backupLogsEncryptionKey;
 
 #ifndef EMSCRIPTEN
 NativeSQLiteConnectionManager SQLiteQueryExecutor::connectionManager;
+thread_local bool SQLiteQueryExecutor::readOnlyThread = false;
+thread_local std::unique_ptr<SQLiteConnectionManager>
+    SQLiteQueryExecutor::readConnectionManager;
+thread_local std::uint64_t SQLiteQueryExecutor::readConnectionGeneration = 0;
+std::atomic<std::uint64_t> SQLiteQueryExecutor::connectionsGeneration{0};
+std::mutex SQLiteQueryExecutor::readConnectionsMutex;
+std::string SQLiteQueryExecutor::readConnectionsFilePath;
+std::string SQLiteQueryExecutor::readConnectionsEncryptionKey;
+std::atomic<std::thread::id> SQLiteQueryExecutor::writerThreadID;
+int SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKeySize = 32;
+std::string
+    SQLiteQueryExecutor::secureStoreClientDBStoreSnapshotEncryptionKeyID =
+        "comm.clientDBStoreSnapshotEncryptionKey";
+std::mutex SQLiteQueryExecutor::clientDBStoreSnapshotMutex;
+std::string SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKey;
+std::uint64_t SQLiteQueryExecutor::clientDBStoreSnapshotEpoch = 0;
 #else
 SQLiteConnectionManager SQLiteQueryExecutor::connectionManager;
 #endif
@@ -512,6 +551,380 @@ bool create_communities_table(sqlite3 *db) {
   return create_table(db, query, "communities");
 }
 
+// Tables whose rows `getClientDBStore` returns. Every change to them bumps
+// the generation of the store, which invalidates its snapshot.
+const std::vector<std::string> CLIENT_DB_STORE_TABLES = {
+    "drafts",
+    "messages",
+    "media",
+    "threads",
+    "message_store_threads",
+    "reports",
+    "users",
+    "keyservers",
+    "communities"};
+
+// Set once the store generation was bumped in the transaction open on the
+// connection of the current thread, so that it's bumped once per transaction
+// rather than for every row. Cleared by the commit and rollback hooks, which
+// also run for statements outside of a transaction.
+thread_local bool client_db_store_generation_bumped = false;
+
+void client_db_store_generation_outdated(
+    sqlite3_context *context,
+    int,
+    sqlite3_value **) {
+  sqlite3_result_int(context, !client_db_store_generation_bumped);
+  client_db_store_generation_bumped = true;
+}
+
+int on_client_db_store_commit(void *) {
+  client_db_store_generation_bumped = false;
+  return 0;
+}
+
+void on_client_db_store_rollback(void *) {
+  client_db_store_generation_bumped = false;
+}
+
+// The generation starts from a random value, so that a store recreated from
+// scratch doesn't take over a snapshot of the previous one.
+const std::string bumpClientDBStoreGenerationSQL =
+    "INSERT OR REPLACE INTO metadata (name, data) "
+    "VALUES ('client_db_store_generation', "
+    "  COALESCE((SELECT data FROM metadata "
+    "    WHERE name = 'client_db_store_generation'), "
+    "    random() & 281474976710655) + 1);";
+
+bool table_exists(sqlite3 *db, const std::string &table) {
+  sqlite3_stmt *table_stmt;
+  sqlite3_prepare_v2(
+      db,
+      "SELECT 1 FROM main.sqlite_master WHERE type = 'table' AND name = ?;",
+      -1,
+      &table_stmt,
+      nullptr);
+  sqlite3_bind_text(table_stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+  bool exists = sqlite3_step(table_stmt) == SQLITE_ROW;
+  sqlite3_finalize(table_stmt);
+  return exists;
+}
+
+// Every write to a store table bumps the generation through temporary
+// triggers of the writer connection, whether or not it runs in a
+// transaction. Triggers also make DELETE without WHERE visit every row, so
+// removing all rows is covered as well. Tables that don't exist yet are
+// skipped, so this is repeated once migrations are done.
+void create_client_db_store_generation_triggers(sqlite3 *db) {
+  sqlite3_create_function(
+      db,
+      "client_db_store_generation_outdated",
+      0,
+      SQLITE_UTF8,
+      nullptr,
+      client_db_store_generation_outdated,
+      nullptr,
+      nullptr);
+  sqlite3_commit_hook(db, on_client_db_store_commit, nullptr);
+  sqlite3_rollback_hook(db, on_client_db_store_rollback, nullptr);
+
+  std::string createTriggersSQL;
+  for (const std::string &table : CLIENT_DB_STORE_TABLES) {
+    if (!table_exists(db, table)) {
+      continue;
+    }
+    for (const std::string operation : {"INSERT", "UPDATE", "DELETE"}) {
+      createTriggersSQL += "CREATE TEMP TRIGGER IF NOT EXISTS " + table +
+          "_client_db_store_generation_after_" + operation + " AFTER " +
+          operation + " ON main." + table +
+          " WHEN client_db_store_generation_outdated() BEGIN " +
+          bumpClientDBStoreGenerationSQL + " END;";
+    }
+  }
+  char *error;
+  sqlite3_exec(db, createTriggersSQL.c_str(), nullptr, nullptr, &error);
+  if (error) {
+    std::string errorMessage{error};
+    sqlite3_free(error);
+    throw std::runtime_error(
+        "Failed to create client DB store generation triggers. Details: " +
+        errorMessage);
+  }
+}
+
+// Pages of messages are ordered by time and then id, so the (thread, time)
+// index is replaced with one covering the id as well.
+bool create_messages_idx_thread_time_id(sqlite3 *db) {
+  char *error;
+  sqlite3_exec(
+      db,
+      "DROP INDEX IF EXISTS messages_idx_thread_time;"
+      "CREATE INDEX IF NOT EXISTS messages_idx_thread_time_id "
+      "ON messages (thread, time, id);",
+      nullptr,
+      nullptr,
+      &error);
+
+  if (!error) {
+    return true;
+  }
+
+  std::ostringstream stringStream;
+  stringStream << "Error creating (thread, time, id) index on messages table: "
+               << error;
+  Logger::log(stringStream.str());
+  sqlite3_free(error);
+  return false;
+}
+
+// Full-text index of the content of text messages. It doesn't store the
+// content itself but refers to `messages` by rowid, and is kept in sync by
+// triggers. Messages at or past the rowid stored in `message_search_backfill`
+// aren't indexed yet, so triggers leave them to `indexMessagesForSearch`.
+// REPLACE and UPDATE OR REPLACE don't fire delete triggers for the rows they
+// remove, so the BEFORE triggers take care of those.
+const std::string messageSearchIndexSQL =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS message_search USING fts5("
+    "  content,"
+    "  content = 'messages',"
+    "  prefix = '2 3',"
+    "  tokenize = 'unicode61 remove_diacritics 2'"
+    ");"
+
+    "CREATE TABLE IF NOT EXISTS message_search_backfill ("
+    "  next_rowid INTEGER NOT NULL"
+    ");"
+
+    "CREATE TRIGGER IF NOT EXISTS messages_search_before_insert "
+    "BEFORE INSERT ON messages BEGIN "
+    "  INSERT INTO message_search (message_search, rowid, content) "
+    "  SELECT 'delete', rowid, content FROM messages "
+    "  WHERE id = new.id AND type = 0 AND content IS NOT NULL "
+    "    AND NOT EXISTS (SELECT 1 FROM message_search_backfill "
+    "      WHERE next_rowid <= messages.rowid); "
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS messages_search_after_insert "
+    "AFTER INSERT ON messages "
+    "WHEN new.type = 0 AND new.content IS NOT NULL "
+    "  AND NOT EXISTS (SELECT 1 FROM message_search_backfill "
+    "    WHERE next_rowid <= new.rowid) "
+    "BEGIN "
+    "  INSERT INTO message_search (rowid, content) "
+    "  VALUES (new.rowid, new.content); "
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS messages_search_after_delete "
+    "AFTER DELETE ON messages "
+    "WHEN old.type = 0 AND old.content IS NOT NULL "
+    "  AND NOT EXISTS (SELECT 1 FROM message_search_backfill "
+    "    WHERE next_rowid <= old.rowid) "
+    "BEGIN "
+    "  INSERT INTO message_search (message_search, rowid, content) "
+    "  VALUES ('delete', old.rowid, old.content); "
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS messages_search_before_rekey "
+    "BEFORE UPDATE OF id ON messages BEGIN "
+    "  INSERT INTO message_search (message_search, rowid, content) "
+    "  SELECT 'delete', rowid, content FROM messages "
+    "  WHERE id = new.id AND rowid != old.rowid "
+    "    AND type = 0 AND content IS NOT NULL "
+    "    AND NOT EXISTS (SELECT 1 FROM message_search_backfill "
+    "      WHERE next_rowid <= messages.rowid); "
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS messages_search_after_update "
+    "AFTER UPDATE OF type, content ON messages "
+    "WHEN NOT EXISTS (SELECT 1 FROM message_search_backfill "
+    "  WHERE next_rowid <= old.rowid) "
+    "BEGIN "
+    "  INSERT INTO message_search (message_search, rowid, content) "
+    "  SELECT 'delete', old.rowid, old.content "
+    "  WHERE old.type = 0 AND old.content IS NOT NULL; "
+    "  INSERT INTO message_search (rowid, content) "
+    "  SELECT new.rowid, new.content "
+    "  WHERE new.type = 0 AND new.content IS NOT NULL; "
+    "END;";
+
+// Empties the index and makes `indexMessagesForSearch` rebuild it from all
+// messages.
+const std::string resetMessageSearchIndexSQL =
+    "INSERT INTO message_search (message_search) VALUES ('delete-all');"
+    "DELETE FROM message_search_backfill;"
+    "INSERT INTO message_search_backfill (next_rowid) VALUES (0);";
+
+bool create_message_search_index(sqlite3 *db) {
+  char *error;
+  sqlite3_exec(db, messageSearchIndexSQL.c_str(), nullptr, nullptr, &error);
+
+  if (!error) {
+    return true;
+  }
+
+  std::ostringstream stringStream;
+  stringStream << "Error creating message search index: " << error;
+  Logger::log(stringStream.str());
+  sqlite3_free(error);
+  return false;
+}
+
+// Existing messages are indexed in chunks after the migration, so that it
+// doesn't hold up the app start.
+bool create_message_search_index_with_backfill(sqlite3 *db) {
+  if (!create_message_search_index(db)) {
+    return false;
+  }
+
+  char *error;
+  sqlite3_exec(
+      db,
+      "INSERT INTO message_search_backfill (next_rowid) VALUES (0);",
+      nullptr,
+      nullptr,
+      &error);
+
+  if (!error) {
+    return true;
+  }
+
+  std::ostringstream stringStream;
+  stringStream << "Error scheduling message search index backfill: " << error;
+  Logger::log(stringStream.str());
+  sqlite3_free(error);
+  return false;
+}
+
+// The latest message of a thread is the one with the greatest (time, id).
+std::string get_thread_summary_message_removal_sql(
+    const std::string &thread,
+    const std::string &id,
+    const std::string &excludedID) {
+  return "UPDATE thread_summaries "
+         "SET messages_count = messages_count - 1 "
+         "WHERE thread = " +
+      thread +
+      ";"
+      "DELETE FROM thread_summaries "
+      "WHERE thread = " +
+      thread +
+      " AND messages_count = 0;"
+      "UPDATE thread_summaries "
+      "SET (last_message_id, last_message_time, last_message_type) = ("
+      "  SELECT id, time, type FROM messages "
+      "  WHERE thread = " +
+      thread + " AND id != " + excludedID +
+      "  ORDER BY time DESC, id DESC "
+      "  LIMIT 1) "
+      "WHERE thread = " +
+      thread + " AND last_message_id = " + id + ";";
+}
+
+std::string get_thread_summary_message_addition_sql() {
+  static const std::string isNewer =
+      "(new.time > last_message_time OR "
+      "  (new.time = last_message_time AND new.id >= last_message_id))";
+  // Conflict clauses in triggers are overridden by the one of the statement
+  // firing them, so INSERT OR IGNORE could turn into REPLACE.
+  return "INSERT INTO thread_summaries "
+         "SELECT new.thread, new.id, new.time, new.type, 0 "
+         "WHERE NOT EXISTS (SELECT 1 FROM thread_summaries "
+         "  WHERE thread = new.thread);"
+         "UPDATE thread_summaries "
+         "SET messages_count = messages_count + 1,"
+         "  last_message_id = CASE WHEN " +
+      isNewer +
+      " THEN new.id ELSE last_message_id END,"
+      "  last_message_time = CASE WHEN " +
+      isNewer +
+      " THEN new.time ELSE last_message_time END,"
+      "  last_message_type = CASE WHEN " +
+      isNewer +
+      " THEN new.type ELSE last_message_type END "
+      "WHERE thread = new.thread;";
+}
+
+// Summaries only exist for threads with messages, and are kept up to date by
+// triggers on `messages`. REPLACE and UPDATE OR REPLACE don't fire delete
+// triggers for the rows they remove, so the BEFORE triggers account for
+// those.
+std::string get_thread_summaries_sql() {
+  static const std::string replacedThread =
+      "(SELECT thread FROM messages WHERE id = new.id)";
+  return "CREATE TABLE IF NOT EXISTS thread_summaries ("
+         "  thread TEXT PRIMARY KEY NOT NULL,"
+         "  last_message_id TEXT NOT NULL,"
+         "  last_message_time INTEGER NOT NULL,"
+         "  last_message_type INTEGER NOT NULL,"
+         "  messages_count INTEGER NOT NULL"
+         ") WITHOUT ROWID;"
+
+         "CREATE TRIGGER IF NOT EXISTS thread_summaries_before_message_insert "
+         "BEFORE INSERT ON messages "
+         "WHEN EXISTS (SELECT 1 FROM messages WHERE id = new.id) "
+         "BEGIN " +
+      get_thread_summary_message_removal_sql(
+             replacedThread, "new.id", "new.id") +
+      " END;"
+
+      "CREATE TRIGGER IF NOT EXISTS thread_summaries_after_message_insert "
+      "AFTER INSERT ON messages "
+      "BEGIN " +
+      get_thread_summary_message_addition_sql() +
+      " END;"
+
+      "CREATE TRIGGER IF NOT EXISTS thread_summaries_after_message_delete "
+      "AFTER DELETE ON messages "
+      "BEGIN " +
+      get_thread_summary_message_removal_sql(
+             "old.thread", "old.id", "old.id") +
+      " END;"
+
+      "CREATE TRIGGER IF NOT EXISTS thread_summaries_before_message_rekey "
+      "BEFORE UPDATE OF id ON messages "
+      "WHEN EXISTS (SELECT 1 FROM messages "
+      "  WHERE id = new.id AND rowid != old.rowid) "
+      "BEGIN " +
+      get_thread_summary_message_removal_sql(
+             replacedThread, "new.id", "new.id") +
+      " END;"
+
+      "CREATE TRIGGER IF NOT EXISTS thread_summaries_after_message_update "
+      "AFTER UPDATE OF id, thread, type, time ON messages "
+      "BEGIN " +
+      get_thread_summary_message_removal_sql(
+             "old.thread", "old.id", "old.id") +
+      get_thread_summary_message_addition_sql() + " END;";
+}
+
+bool create_thread_summaries_table(sqlite3 *db) {
+  std::string query = get_thread_summaries_sql() +
+      "INSERT INTO thread_summaries "
+      "SELECT thread, '', 0, 0, COUNT(*) "
+      "FROM messages "
+      "GROUP BY thread;"
+
+      "UPDATE thread_summaries "
+      "SET (last_message_id, last_message_time, last_message_type) = ("
+      "  SELECT id, time, type FROM messages "
+      "  WHERE thread = thread_summaries.thread "
+      "  ORDER BY time DESC, id DESC "
+      "  LIMIT 1);";
+
+  char *error;
+  sqlite3_exec(db, query.c_str(), nullptr, nullptr, &error);
+
+  if (!error) {
+    return true;
+  }
+
+  std::ostringstream stringStream;
+  stringStream << "Error creating thread summaries table: " << error;
+  Logger::log(stringStream.str());
+  sqlite3_free(error);
+  return false;
+}
+
 bool create_schema(sqlite3 *db) {
   char *error;
   sqlite3_exec(
@@ -608,14 +1021,15 @@ bool create_schema(sqlite3 *db) {
       "CREATE INDEX IF NOT EXISTS media_idx_container"
       "  ON media (container);"
 
-      "CREATE INDEX IF NOT EXISTS messages_idx_thread_time"
-      "  ON messages (thread, time);",
+      "CREATE INDEX IF NOT EXISTS messages_idx_thread_time_id"
+      "  ON messages (thread, time, id);",
       nullptr,
       nullptr,
       &error);
 
   if (!error) {
-    return true;
+    return create_message_search_index(db) &&
+        create_thread_summaries_table(db);
   }
 
   std::ostringstream stringStream;
@@ -655,6 +1069,17 @@ int get_database_version(sqlite3 *db) {
   return current_user_version;
 }
 
+int get_integer_pragma(sqlite3 *db, const std::string &pragma) {
+  std::string query = "PRAGMA " + pragma + ";";
+  sqlite3_stmt *pragma_stmt;
+  sqlite3_prepare_v2(db, query.c_str(), -1, &pragma_stmt, nullptr);
+  sqlite3_step(pragma_stmt);
+
+  int value = sqlite3_column_int(pragma_stmt, 0);
+  sqlite3_finalize(pragma_stmt);
+  return value;
+}
+
 bool set_database_version(sqlite3 *db, int db_version) {
   std::stringstream update_version;
   update_version << "PRAGMA user_version=" << db_version << ";";
@@ -676,13 +1101,53 @@ bool set_database_version(sqlite3 *db, int db_version) {
   return false;
 }
 
+void run_performance_profile_settings(sqlite3 *db, const std::string &sql) {
+  char *error;
+  sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error);
+  if (error) {
+    std::ostringstream errorStream;
+    errorStream << "Failed to apply performance profile "
+                << SQLiteQueryExecutor::performanceProfile.name << ": "
+                << error;
+    sqlite3_free(error);
+    throw std::runtime_error(errorStream.str());
+  }
+}
+
+// Cipher settings describe the database file, so they have to match the ones
+// it was encrypted with and come right after the key.
+void set_cipher_settings(sqlite3 *db) {
+  run_performance_profile_settings(
+      db, SQLiteQueryExecutor::performanceProfile.getCipherSettingsSQL("main"));
+}
+
+void configure_connection(sqlite3 *db) {
+  // With the write-ahead log, readers and the writer don't wait for each
+  // other, but switching the journal mode and checkpoints still need locks
+  // other connections may hold for a moment.
+  sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+  run_performance_profile_settings(
+      db, SQLiteQueryExecutor::performanceProfile.getConnectionSettingsSQL());
+}
+
+// Set up of the writer connection once its encryption key is set, however
+// it was opened.
+void configure_writer_connection(sqlite3 *db) {
+#ifndef EMSCRIPTEN
+  configure_connection(db);
+#endif
+  create_client_db_store_generation_triggers(db);
+}
+
 // We don't want to run `PRAGMA key = ...;`
 // on main web database. The context is here:
 // https://linear.app/comm/issue/ENG-6398/issues-with-sqlcipher-on-web
 void default_on_db_open_callback(sqlite3 *db) {
 #ifndef EMSCRIPTEN
   set_encryption_key(db);
+  set_cipher_settings(db);
 #endif
+  configure_writer_connection(db);
 }
 
 // This is a temporary solution. In future we want to keep
@@ -706,6 +1171,17 @@ void attempt_delete_file(
   }
 }
 
+// A write-ahead log left behind would be applied to the database created
+// under the same path.
+void attempt_delete_write_ahead_log(const std::string &db_path) {
+  for (const char *suffix : {"-wal", "-shm"}) {
+    if (file_exists(db_path + suffix)) {
+      attempt_delete_file(
+          db_path + suffix, "Failed to delete write-ahead log of database.");
+    }
+  }
+}
+
 void attempt_rename_file(
     const std::string &old_path,
     const std::string &new_path,
@@ -719,7 +1195,8 @@ bool is_database_queryable(
     sqlite3 *db,
     bool use_encryption_key,
     const std::string &path = SQLiteQueryExecutor::sqliteFilePath,
-    const std::string &encryptionKey = SQLiteQueryExecutor::encryptionKey) {
+    const std::string &encryptionKey = SQLiteQueryExecutor::encryptionKey,
+    bool use_cipher_settings = true) {
   char *err_msg;
   sqlite3_open(path.c_str(), &db);
   // According to SQLCipher documentation running some SELECT is the only way to
@@ -727,12 +1204,26 @@ bool is_database_queryable(
   if (use_encryption_key) {
     set_encryption_key(db, encryptionKey);
   }
+  if (use_encryption_key && use_cipher_settings) {
+    set_cipher_settings(db);
+  }
   sqlite3_exec(
       db, "SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, &err_msg);
   sqlite3_close(db);
   return !err_msg;
 }
 
+bool is_connection_queryable(sqlite3 *db) {
+  char *err_msg;
+  sqlite3_exec(
+      db, "SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, &err_msg);
+  if (!err_msg) {
+    return true;
+  }
+  sqlite3_free(err_msg);
+  return false;
+}
+
 void validate_encryption() {
   std::string temp_encrypted_db_path =
       SQLiteQueryExecutor::sqliteFilePath + "_temp_encrypted";
@@ -771,13 +1262,27 @@ void validate_encryption() {
     return;
   }
 
-  if (!is_database_queryable(db, false)) {
+  // Cipher settings can't be changed in place, so a database encrypted with
+  // settings other than the current performance profile's goes through the
+  // same export as an unencrypted one.
+  bool encrypted_with_other_settings = is_database_queryable(
+      db,
+      true,
+      SQLiteQueryExecutor::sqliteFilePath,
+      SQLiteQueryExecutor::encryptionKey,
+      false);
+  if (encrypted_with_other_settings) {
+    Logger::log(
+        "Database exists but it is encrypted with different cipher settings. "
+        "Attempting re-encryption process.");
+  } else if (!is_database_queryable(db, false)) {
     Logger::log(
         "Database exists but it is encrypted with key that was lost. "
         "Attempting database deletion. New encrypted one will be created.");
     attempt_delete_file(
         SQLiteQueryExecutor::sqliteFilePath.c_str(),
         "Failed to delete database encrypted with lost key.");
+    attempt_delete_write_ahead_log(SQLiteQueryExecutor::sqliteFilePath);
     return;
   } else {
     Logger::log(
@@ -785,13 +1290,17 @@ void validate_encryption() {
         "process.");
   }
   sqlite3_open(SQLiteQueryExecutor::sqliteFilePath.c_str(), &db);
+  if (encrypted_with_other_settings) {
+    set_encryption_key(db);
+  }
 
   std::string createEncryptedCopySQL = "ATTACH DATABASE '" +
       temp_encrypted_db_path +
       "' AS encrypted_comm "
       "KEY \"x'" +
-      SQLiteQueryExecutor::encryptionKey +
-      "'\";"
+      SQLiteQueryExecutor::encryptionKey + "'\";" +
+      SQLiteQueryExecutor::performanceProfile.getCipherSettingsSQL(
+          "encrypted_comm") +
       "SELECT sqlcipher_export('encrypted_comm');"
       "DETACH DATABASE encrypted_comm;";
 
@@ -809,7 +1318,7 @@ void validate_encryption() {
 
   attempt_delete_file(
       SQLiteQueryExecutor::sqliteFilePath,
-      "Failed to delete unencrypted database.");
+      "Failed to delete original database.");
   attempt_rename_file(
       temp_encrypted_db_path,
       SQLiteQueryExecutor::sqliteFilePath,
@@ -845,7 +1354,10 @@ std::vector<std::pair<unsigned int, SQLiteMigration>> migrations{
      {32, {create_users_table, true}},
      {33, {create_keyservers_table, true}},
      {34, {enable_rollback_journal_mode, false}},
-     {35, {create_communities_table, true}}}};
+     {35, {create_communities_table, true}},
+     {36, {create_messages_idx_thread_time_id, true}},
+     {37, {create_message_search_index_with_backfill, true}},
+     {38, {create_thread_summaries_table, true}}}};
 
 enum class MigrationResult { SUCCESS, FAILURE, NOT_APPLIED };
 
@@ -908,6 +1420,12 @@ bool set_up_database(sqlite3 *db) {
     sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
     return true;
   }
+  // Auto vacuum can be set without rebuilding the database only before any
+  // table is created.
+  if (db_version == 0) {
+    sqlite3_exec(
+        db, "PRAGMA auto_vacuum = INCREMENTAL;", nullptr, nullptr, nullptr);
+  }
   if (db_version != 0 || !create_schema(db) ||
       !set_database_version(db, latest_version)) {
     sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
@@ -917,17 +1435,49 @@ bool set_up_database(sqlite3 *db) {
   return true;
 }
 
-void SQLiteQueryExecutor::migrate() {
-// We don't want to run `PRAGMA key = ...;`
-// on main web database. The context is here:
-// https://linear.app/comm/issue/ENG-6398/issues-with-sqlcipher-on-web
+// Opens the database with the encryption key set. In the common case of a
+// correctly encrypted database this is the only time the file gets opened,
+// otherwise `validate_encryption` handles the database first.
+sqlite3 *open_validated_database() {
+  sqlite3 *db;
 #ifndef EMSCRIPTEN
+  std::string temp_encrypted_db_path =
+      SQLiteQueryExecutor::sqliteFilePath + "_temp_encrypted";
+  if (!file_exists(temp_encrypted_db_path) &&
+      file_exists(SQLiteQueryExecutor::sqliteFilePath)) {
+    sqlite3_open(SQLiteQueryExecutor::sqliteFilePath.c_str(), &db);
+    set_encryption_key(db);
+    set_cipher_settings(db);
+    if (is_connection_queryable(db)) {
+      Logger::log(
+          "Database exists under default path and it is correctly encrypted.");
+      configure_writer_connection(db);
+      return db;
+    }
+    sqlite3_close(db);
+  }
   validate_encryption();
 #endif
 
-  sqlite3 *db;
   sqlite3_open(SQLiteQueryExecutor::sqliteFilePath.c_str(), &db);
   default_on_db_open_callback(db);
+  return db;
+}
+
+long long get_elapsed_ms(std::chrono::steady_clock::time_point &since) {
+  auto now = std::chrono::steady_clock::now();
+  auto elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - since);
+  since = now;
+  return elapsed.count();
+}
+
+void SQLiteQueryExecutor::migrate() {
+  auto phaseStart = std::chrono::steady_clock::now();
+  std::stringstream timings;
+
+  sqlite3 *db = open_validated_database();
+  timings << "open " << get_elapsed_ms(phaseStart) << "ms";
 
   std::stringstream db_path;
   db_path << "db path: " << SQLiteQueryExecutor::sqliteFilePath.c_str()
@@ -938,7 +1488,9 @@ void SQLiteQueryExecutor::migrate() {
   std::stringstream version_msg;
   version_msg << "db version: " << db_version << std::endl;
   Logger::log(version_msg.str());
+  timings << ", version check " << get_elapsed_ms(phaseStart) << "ms";
 
+  bool schemaChanged = false;
   if (db_version == 0) {
     auto db_created = set_up_database(db);
     if (!db_created) {
@@ -947,44 +1499,86 @@ void SQLiteQueryExecutor::migrate() {
       throw std::runtime_error("Database structure creation error");
     }
     Logger::log("Database structure created.");
+    schemaChanged = true;
+    timings << ", schema creation " << get_elapsed_ms(phaseStart) << "ms";
+  } else if (db_version != migrations.back().first) {
+    for (const auto &[idx, migration] : migrations) {
+      const auto &[applyMigration, shouldBeInTransaction] = migration;
+
+      MigrationResult migrationResult;
+      if (shouldBeInTransaction) {
+        migrationResult =
+            applyMigrationWithTransaction(db, applyMigration, idx);
+      } else {
+        migrationResult =
+            applyMigrationWithoutTransaction(db, applyMigration, idx);
+      }
 
-    sqlite3_close(db);
-    return;
-  }
-
-  for (const auto &[idx, migration] : migrations) {
-    const auto &[applyMigration, shouldBeInTransaction] = migration;
+      if (migrationResult == MigrationResult::NOT_APPLIED) {
+        continue;
+      }
 
-    MigrationResult migrationResult;
-    if (shouldBeInTransaction) {
-      migrationResult = applyMigrationWithTransaction(db, applyMigration, idx);
-    } else {
-      migrationResult =
-          applyMigrationWithoutTransaction(db, applyMigration, idx);
+      std::stringstream migration_msg;
+      if (migrationResult == MigrationResult::FAILURE) {
+        migration_msg << "migration " << idx << " failed." << std::endl;
+        Logger::log(migration_msg.str());
+        sqlite3_close(db);
+        throw std::runtime_error(migration_msg.str());
+      }
+      if (migrationResult == MigrationResult::SUCCESS) {
+        migration_msg << "migration " << idx << " succeeded." << std::endl;
+        Logger::log(migration_msg.str());
+        schemaChanged = true;
+      }
     }
+    timings << ", migrations " << get_elapsed_ms(phaseStart) << "ms";
+  }
 
-    if (migrationResult == MigrationResult::NOT_APPLIED) {
-      continue;
-    }
+#ifndef EMSCRIPTEN
+  // Migration 34 switches the database back to the rollback journal.
+  if (schemaChanged) {
+    configure_connection(db);
+  }
+#endif
 
-    std::stringstream migration_msg;
-    if (migrationResult == MigrationResult::FAILURE) {
-      migration_msg << "migration " << idx << " failed." << std::endl;
-      Logger::log(migration_msg.str());
-      sqlite3_close(db);
-      throw std::runtime_error(migration_msg.str());
-    }
-    if (migrationResult == MigrationResult::SUCCESS) {
-      migration_msg << "migration " << idx << " succeeded." << std::endl;
-      Logger::log(migration_msg.str());
+  // The connection migrations ran on becomes the writer connection, unless
+  // one is already open. Statements cached by that one were prepared against
+  // the old schema.
+  if (!SQLiteQueryExecutor::connectionManager.getConnection()) {
+    SQLiteQueryExecutor::connectionManager.adoptConnection(db);
+  } else {
+    sqlite3_close(db);
+    if (schemaChanged) {
+      SQLiteQueryExecutor::connectionManager.clearStatementCache();
     }
   }
-
-  sqlite3_close(db);
+  if (schemaChanged) {
+    create_client_db_store_generation_triggers(
+        SQLiteQueryExecutor::connectionManager.getConnection());
+  }
+#ifndef EMSCRIPTEN
+  SQLiteQueryExecutor::invalidateReadConnections();
+#endif
+  SQLiteQueryExecutor::migrated.store(true);
+  timings << ", connection setup " << get_elapsed_ms(phaseStart) << "ms";
+  Logger::log("Database startup: " + timings.str());
 }
 
 SQLiteQueryExecutor::SQLiteQueryExecutor() {
-  SQLiteQueryExecutor::migrate();
+#ifndef EMSCRIPTEN
+  // Migrations and backup logs monitoring are the writer's responsibility.
+  if (SQLiteQueryExecutor::readOnlyThread) {
+    return;
+  }
+#endif
+  // The schema is shared by all threads, so only the first executor brings
+  // it up to date.
+  if (!SQLiteQueryExecutor::migrated.load()) {
+    std::lock_guard<std::mutex> lock(SQLiteQueryExecutor::migrationMutex);
+    if (!SQLiteQueryExecutor::migrated.load()) {
+      SQLiteQueryExecutor::migrate();
+    }
+  }
 #ifndef EMSCRIPTEN
   std::string currentBackupID = this->getMetadata("backupID");
   if (!StaffUtils::isStaffRelease() || !currentBackupID.size()) {
@@ -1000,6 +1594,18 @@ SQLiteQueryExecutor::SQLiteQueryExecutor(std::string sqliteFilePath) {
 }
 
 sqlite3 *SQLiteQueryExecutor::getConnection() {
+#ifndef EMSCRIPTEN
+  if (SQLiteQueryExecutor::readOnlyThread) {
+    return SQLiteQueryExecutor::getReadConnectionManager().getConnection();
+  }
+  std::thread::id writerThreadID = SQLiteQueryExecutor::writerThreadID.load();
+  if (writerThreadID != std::thread::id() &&
+      writerThreadID != std::this_thread::get_id()) {
+    throw std::runtime_error(
+        "Programmer error: attempt to use the writer connection outside of "
+        "the database thread.");
+  }
+#endif
   if (SQLiteQueryExecutor::connectionManager.getConnection()) {
     return SQLiteQueryExecutor::connectionManager.getConnection();
   }
@@ -1008,7 +1614,23 @@ sqlite3 *SQLiteQueryExecutor::getConnection() {
   return SQLiteQueryExecutor::connectionManager.getConnection();
 }
 
+SQLiteConnectionManager &SQLiteQueryExecutor::getConnectionManager() {
+#ifndef EMSCRIPTEN
+  if (SQLiteQueryExecutor::readOnlyThread) {
+    return SQLiteQueryExecutor::getReadConnectionManager();
+  }
+#endif
+  SQLiteQueryExecutor::getConnection();
+  return SQLiteQueryExecutor::connectionManager;
+}
+
 void SQLiteQueryExecutor::closeConnection() {
+#ifndef EMSCRIPTEN
+  if (SQLiteQueryExecutor::readOnlyThread) {
+    SQLiteQueryExecutor::readConnectionManager.reset();
+    return;
+  }
+#endif
   SQLiteQueryExecutor::connectionManager.closeConnection();
 }
 
@@ -1022,7 +1644,9 @@ std::string SQLiteQueryExecutor::getDraft(std::string key) const {
       "FROM drafts "
       "WHERE key = ?;";
   std::unique_ptr<Draft> draft = getEntityByPrimaryKey<Draft>(
-      SQLiteQueryExecutor::getConnection(), getDraftByPrimaryKeySQL, key);
+      SQLiteQueryExecutor::getConnectionManager(),
+      getDraftByPrimaryKeySQL,
+      key);
   return (draft == nullptr) ? "" : draft->text;
 }
 
@@ -1033,16 +1657,14 @@ SQLiteQueryExecutor::getThread(std::string threadID) const {
       "FROM threads "
       "WHERE id = ?;";
   return getEntityByPrimaryKey<Thread>(
-      SQLiteQueryExecutor::getConnection(), getThreadByPrimaryKeySQL, threadID);
+      SQLiteQueryExecutor::getConnectionManager(),
+      getThreadByPrimaryKeySQL,
+      threadID);
 }
 
 void SQLiteQueryExecutor::updateDraft(std::string key, std::string text) const {
-  static std::string replaceDraftSQL =
-      "REPLACE INTO drafts (key, text) "
-      "VALUES (?, ?);";
   Draft draft = {key, text};
-  replaceEntity<Draft>(
-      SQLiteQueryExecutor::getConnection(), replaceDraftSQL, draft);
+  replaceEntity<Draft>(SQLiteQueryExecutor::getConnectionManager(), draft);
 }
 
 bool SQLiteQueryExecutor::moveDraft(std::string oldKey, std::string newKey)
@@ -1056,7 +1678,10 @@ bool SQLiteQueryExecutor::moveDraft(std::string oldKey, std::string newKey)
       "SET key = ? "
       "WHERE key = ?;";
   rekeyAllEntities(
-      SQLiteQueryExecutor::getConnection(), rekeyDraftSQL, oldKey, newKey);
+      SQLiteQueryExecutor::getConnectionManager(),
+      rekeyDraftSQL,
+      oldKey,
+      newKey);
   return true;
 }
 
@@ -1065,12 +1690,13 @@ std::vector<Draft> SQLiteQueryExecutor::getAllDrafts() const {
       "SELECT * "
       "FROM drafts;";
   return getAllEntities<Draft>(
-      SQLiteQueryExecutor::getConnection(), getAllDraftsSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllDraftsSQL);
 }
 
 void SQLiteQueryExecutor::removeAllDrafts() const {
   static std::string removeAllDraftsSQL = "DELETE FROM drafts;";
-  removeAllEntities(SQLiteQueryExecutor::getConnection(), removeAllDraftsSQL);
+  removeAllEntities(
+      SQLiteQueryExecutor::getConnectionManager(), removeAllDraftsSQL);
 }
 
 void SQLiteQueryExecutor::removeDrafts(
@@ -1079,24 +1705,36 @@ void SQLiteQueryExecutor::removeDrafts(
     return;
   }
 
-  std::stringstream removeDraftsByKeysSQLStream;
-  removeDraftsByKeysSQLStream << "DELETE FROM drafts "
-                                 "WHERE key IN "
-                              << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeDraftsByKeysSQLPrefix =
+      "DELETE FROM drafts "
+      "WHERE key IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeDraftsByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeDraftsByKeysSQLPrefix,
       ids);
 }
 
 void SQLiteQueryExecutor::removeAllMessages() const {
   static std::string removeAllMessagesSQL = "DELETE FROM messages;";
-  removeAllEntities(SQLiteQueryExecutor::getConnection(), removeAllMessagesSQL);
+  removeAllEntities(
+      SQLiteQueryExecutor::getConnectionManager(), removeAllMessagesSQL);
 }
 
 std::vector<std::pair<Message, std::vector<Media>>>
 SQLiteQueryExecutor::getAllMessages() const {
+  std::vector<std::pair<Message, std::vector<Media>>> allMessages;
+  this->getAllMessagesInChunks(
+      std::numeric_limits<std::size_t>::max(),
+      [&allMessages](std::vector<MessageEntity> &&chunk) {
+        allMessages = std::move(chunk);
+      });
+  return allMessages;
+}
+
+void SQLiteQueryExecutor::getAllMessagesInChunks(
+    std::size_t chunkSize,
+    const std::function<void(std::vector<MessageEntity> &&)> &onChunk) const {
   static std::string getAllMessagesSQL =
       "SELECT * "
       "FROM messages "
@@ -1104,28 +1742,307 @@ SQLiteQueryExecutor::getAllMessages() const {
       "   ON messages.id = media.container "
       "ORDER BY messages.id;";
   SQLiteStatementWrapper preparedSQL(
-      SQLiteQueryExecutor::getConnection(),
+      SQLiteQueryExecutor::getConnectionManager(),
       getAllMessagesSQL,
       "Failed to retrieve all messages.");
 
   std::string prevMsgIdx{};
-  std::vector<std::pair<Message, std::vector<Media>>> allMessages;
+  std::vector<MessageEntity> chunk;
 
-  for (int stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
+  int stepResult;
+  for (stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
        stepResult = sqlite3_step(preparedSQL)) {
+    // Rows of the same message differ only in media, so the message itself
+    // is materialized only for its first row.
+    if (getStringViewFromSQLRow(preparedSQL, 0) == prevMsgIdx) {
+      chunk.back().second.push_back(Media::fromSQLResult(preparedSQL, 8));
+      continue;
+    }
+    // A chunk is only handed over once the next message starts, so that all
+    // media rows of its last message have already been collected.
+    if (chunk.size() >= chunkSize) {
+      onChunk(std::move(chunk));
+      chunk = std::vector<MessageEntity>{};
+    }
     Message message = Message::fromSQLResult(preparedSQL, 0);
-    if (message.id == prevMsgIdx) {
-      allMessages.back().second.push_back(Media::fromSQLResult(preparedSQL, 8));
-    } else {
-      prevMsgIdx = message.id;
-      std::vector<Media> mediaForMsg;
-      if (sqlite3_column_type(preparedSQL, 8) != SQLITE_NULL) {
-        mediaForMsg.push_back(Media::fromSQLResult(preparedSQL, 8));
+    prevMsgIdx = message.id;
+    std::vector<Media> mediaForMsg;
+    if (sqlite3_column_type(preparedSQL, 8) != SQLITE_NULL) {
+      mediaForMsg.push_back(Media::fromSQLResult(preparedSQL, 8));
+    }
+    chunk.push_back(std::make_pair(std::move(message), std::move(mediaForMsg)));
+  }
+  preparedSQL.checkDone(stepResult);
+  if (!chunk.empty()) {
+    onChunk(std::move(chunk));
+  }
+}
+
+std::vector<std::pair<Message, std::vector<Media>>>
+SQLiteQueryExecutor::getMessagesPageWithMedia(
+    const std::string &getMessagesPageSQL,
+    std::string threadID,
+    int64_t time,
+    std::string id,
+    int limit) const {
+  if (limit < 0) {
+    throw std::runtime_error(
+        "Invalid limit of messages: " + std::to_string(limit));
+  }
+  SQLiteStatementWrapper preparedSQL(
+      SQLiteQueryExecutor::getConnectionManager(),
+      getMessagesPageSQL,
+      "Failed to retrieve messages for thread.");
+  bindStringToSQL(threadID, preparedSQL, 1);
+  bindInt64ToSQL(time, preparedSQL, 2);
+  bindInt64ToSQL(time, preparedSQL, 3);
+  bindStringToSQL(id, preparedSQL, 4);
+  bindIntToSQL(std::min(limit, MAX_MESSAGES_PAGE_SIZE), preparedSQL, 5);
+
+  std::vector<std::pair<Message, std::vector<Media>>> messages;
+  std::unordered_map<std::string, size_t> messageIndexes;
+  int stepResult;
+  for (stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
+       stepResult = sqlite3_step(preparedSQL)) {
+    Message message = Message::fromSQLResult(preparedSQL, 0);
+    messageIndexes[message.id] = messages.size();
+    messages.push_back(
+        std::make_pair(std::move(message), std::vector<Media>{}));
+  }
+  preparedSQL.checkDone(stepResult);
+  if (!messages.size()) {
+    return messages;
+  }
+
+  std::vector<std::string> messageIDs;
+  for (const auto &[message, _] : messages) {
+    messageIDs.push_back(message.id);
+  }
+  static std::string getMediaForMessagesSQLPrefix =
+      "SELECT * "
+      "FROM media "
+      "WHERE container IN ";
+  std::vector<Media> medias = getAllEntitiesByKeys<Media>(
+      SQLiteQueryExecutor::getConnectionManager(),
+      getMediaForMessagesSQLPrefix,
+      messageIDs);
+  for (auto &media : medias) {
+    size_t messageIndex = messageIndexes[media.container];
+    messages[messageIndex].second.push_back(std::move(media));
+  }
+  return messages;
+}
+
+// Messages sharing a time are ordered by id, so pages neither skip nor
+// repeat them. The cursor is matched as `time < ? OR (time = ? AND id < ?)`,
+// with the time bound spelled out separately so that it's a range on the
+// (thread, time, id) index rather than a filter over the whole thread.
+std::vector<std::pair<Message, std::vector<Media>>>
+SQLiteQueryExecutor::getMessagesForThread(
+    std::string threadID,
+    int64_t beforeTime,
+    std::string beforeID,
+    int limit) const {
+  static std::string getMessagesBeforeTimeSQL =
+      "SELECT * "
+      "FROM messages "
+      "WHERE thread = ? AND time <= ? AND (time < ? OR id < ?) "
+      "ORDER BY time DESC, id DESC "
+      "LIMIT ?;";
+  return this->getMessagesPageWithMedia(
+      getMessagesBeforeTimeSQL, threadID, beforeTime, beforeID, limit);
+}
+
+std::vector<std::pair<Message, std::vector<Media>>>
+SQLiteQueryExecutor::getMessagesForThreadAfter(
+    std::string threadID,
+    int64_t afterTime,
+    std::string afterID,
+    int limit) const {
+  static std::string getMessagesAfterTimeSQL =
+      "SELECT * "
+      "FROM messages "
+      "WHERE thread = ? AND time >= ? AND (time > ? OR id > ?) "
+      "ORDER BY time ASC, id ASC "
+      "LIMIT ?;";
+  return this->getMessagesPageWithMedia(
+      getMessagesAfterTimeSQL, threadID, afterTime, afterID, limit);
+}
+
+// Quotes every word of the query, so that FTS5 syntax typed by the user is
+// searched for literally, and matches the last one by prefix, as it may still
+// be being typed.
+std::string get_message_search_match_expression(const std::string &query) {
+  std::string matchExpression;
+  std::istringstream queryStream(query);
+  std::string word;
+  while (queryStream >> word) {
+    if (matchExpression.size()) {
+      matchExpression += " ";
+    }
+    matchExpression += "\"";
+    for (char character : word) {
+      matchExpression += character;
+      if (character == '"') {
+        matchExpression += '"';
       }
-      allMessages.push_back(std::make_pair(std::move(message), mediaForMsg));
     }
+    matchExpression += "\"";
+  }
+  if (matchExpression.size()) {
+    matchExpression += "*";
+  }
+  return matchExpression;
+}
+
+std::vector<std::string> SQLiteQueryExecutor::searchMessages(
+    std::string query,
+    std::optional<std::string> threadID,
+    int limit,
+    int offset) const {
+  static std::string searchMessagesSQL =
+      "SELECT messages.id "
+      "FROM message_search "
+      "INNER JOIN messages ON messages.rowid = message_search.rowid "
+      "WHERE message_search MATCH ? "
+      "ORDER BY message_search.rank "
+      "LIMIT ? OFFSET ?;";
+  static std::string searchMessagesInThreadSQL =
+      "SELECT messages.id "
+      "FROM message_search "
+      "INNER JOIN messages ON messages.rowid = message_search.rowid "
+      "WHERE message_search MATCH ? AND messages.thread = ? "
+      "ORDER BY message_search.rank "
+      "LIMIT ? OFFSET ?;";
+
+  std::string matchExpression = get_message_search_match_expression(query);
+  if (!matchExpression.size()) {
+    return {};
   }
-  return allMessages;
+
+  SQLiteStatementWrapper preparedSQL(
+      SQLiteQueryExecutor::getConnectionManager(),
+      threadID.has_value() ? searchMessagesInThreadSQL : searchMessagesSQL,
+      "Failed to search messages.");
+  int bindIndex = 1;
+  bindStringToSQL(matchExpression, preparedSQL, bindIndex++);
+  if (threadID.has_value()) {
+    bindStringToSQL(threadID.value(), preparedSQL, bindIndex++);
+  }
+  bindIntToSQL(limit, preparedSQL, bindIndex++);
+  bindIntToSQL(offset, preparedSQL, bindIndex++);
+
+  std::vector<std::string> messageIDs;
+  int stepResult;
+  for (stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
+       stepResult = sqlite3_step(preparedSQL)) {
+    messageIDs.push_back(getStringFromSQLRow(preparedSQL, 0));
+  }
+  preparedSQL.checkDone(stepResult);
+  return messageIDs;
+}
+
+bool SQLiteQueryExecutor::indexMessagesForSearch(int messagesCount) const {
+  static std::string getBackfillStartSQL =
+      "SELECT next_rowid "
+      "FROM message_search_backfill;";
+  static std::string getBackfillEndSQL =
+      "SELECT rowid "
+      "FROM messages "
+      "WHERE rowid >= ? "
+      "ORDER BY rowid "
+      "LIMIT 1 OFFSET ?;";
+  static std::string indexMessagesSQL =
+      "INSERT INTO message_search (rowid, content) "
+      "SELECT rowid, content "
+      "FROM messages "
+      "WHERE rowid >= ? AND rowid < ? AND type = 0 AND content IS NOT NULL;";
+  static std::string updateBackfillSQL =
+      "UPDATE message_search_backfill "
+      "SET next_rowid = ?;";
+  static std::string finishBackfillSQL = "DELETE FROM message_search_backfill;";
+
+  this->beginTransaction();
+  try {
+    int64_t backfillStart;
+    {
+      SQLiteStatementWrapper preparedSQL(
+          SQLiteQueryExecutor::getConnectionManager(),
+          getBackfillStartSQL,
+          "Failed to get message search index backfill state.");
+      int stepResult = sqlite3_step(preparedSQL);
+      if (stepResult != SQLITE_ROW) {
+        preparedSQL.checkDone(stepResult);
+        this->commitTransaction();
+        return true;
+      }
+      backfillStart = getInt64FromSQLRow(preparedSQL, 0);
+    }
+
+    // Chunks are counted in messages rather than rowids, as rowids of
+    // replaced messages leave gaps.
+    std::optional<int64_t> backfillEnd;
+    {
+      SQLiteStatementWrapper preparedSQL(
+          SQLiteQueryExecutor::getConnectionManager(),
+          getBackfillEndSQL,
+          "Failed to get message search index backfill chunk.");
+      bindInt64ToSQL(backfillStart, preparedSQL, 1);
+      bindIntToSQL(messagesCount, preparedSQL, 2);
+      int stepResult = sqlite3_step(preparedSQL);
+      if (stepResult == SQLITE_ROW) {
+        backfillEnd = getInt64FromSQLRow(preparedSQL, 0);
+      } else {
+        preparedSQL.checkDone(stepResult);
+      }
+    }
+
+    {
+      SQLiteStatementWrapper preparedSQL(
+          SQLiteQueryExecutor::getConnectionManager(),
+          indexMessagesSQL,
+          "Failed to index messages for search.");
+      bindInt64ToSQL(backfillStart, preparedSQL, 1);
+      bindInt64ToSQL(
+          backfillEnd.value_or(std::numeric_limits<int64_t>::max()),
+          preparedSQL,
+          2);
+      preparedSQL.checkDone(sqlite3_step(preparedSQL));
+    }
+
+    if (backfillEnd.has_value()) {
+      SQLiteStatementWrapper preparedSQL(
+          SQLiteQueryExecutor::getConnectionManager(),
+          updateBackfillSQL,
+          "Failed to update message search index backfill state.");
+      bindInt64ToSQL(backfillEnd.value(), preparedSQL, 1);
+      preparedSQL.checkDone(sqlite3_step(preparedSQL));
+    } else {
+      SQLiteStatementWrapper preparedSQL(
+          SQLiteQueryExecutor::getConnectionManager(),
+          finishBackfillSQL,
+          "Failed to finish message search index backfill.");
+      preparedSQL.checkDone(sqlite3_step(preparedSQL));
+    }
+    this->commitTransaction();
+    return !backfillEnd.has_value();
+  } catch (...) {
+    this->rollbackTransaction();
+    throw;
+  }
+}
+
+void SQLiteQueryExecutor::resetMessageSearchIndex() const {
+  executeQuery(
+      SQLiteQueryExecutor::getConnection(), resetMessageSearchIndexSQL);
+}
+
+std::vector<ThreadSummary> SQLiteQueryExecutor::getThreadSummaries() const {
+  static std::string getThreadSummariesSQL =
+      "SELECT * "
+      "FROM thread_summaries;";
+  return getAllEntities<ThreadSummary>(
+      SQLiteQueryExecutor::getConnectionManager(), getThreadSummariesSQL);
 }
 
 void SQLiteQueryExecutor::removeMessages(
@@ -1134,13 +2051,12 @@ void SQLiteQueryExecutor::removeMessages(
     return;
   }
 
-  std::stringstream removeMessagesByKeysSQLStream;
-  removeMessagesByKeysSQLStream << "DELETE FROM messages "
-                                   "WHERE id IN "
-                                << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeMessagesByKeysSQLPrefix =
+      "DELETE FROM messages "
+      "WHERE id IN ";
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeMessagesByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeMessagesByKeysSQLPrefix,
       ids);
 }
 
@@ -1150,26 +2066,24 @@ void SQLiteQueryExecutor::removeMessagesForThreads(
     return;
   }
 
-  std::stringstream removeMessagesByKeysSQLStream;
-  removeMessagesByKeysSQLStream << "DELETE FROM messages "
-                                   "WHERE thread IN "
-                                << getSQLStatementArray(threadIDs.size())
-                                << ";";
+  static std::string removeMessagesByKeysSQLPrefix =
+      "DELETE FROM messages "
+      "WHERE thread IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeMessagesByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeMessagesByKeysSQLPrefix,
       threadIDs);
 }
 
 void SQLiteQueryExecutor::replaceMessage(const Message &message) const {
-  static std::string replaceMessageSQL =
-      "REPLACE INTO messages "
-      "(id, local_id, thread, user, type, future_type, content, time) "
-      "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+  replaceEntity<Message>(SQLiteQueryExecutor::getConnectionManager(), message);
+}
 
-  replaceEntity<Message>(
-      SQLiteQueryExecutor::getConnection(), replaceMessageSQL, message);
+void SQLiteQueryExecutor::replaceMessages(
+    const std::vector<Message> &messages) const {
+  replaceEntities<Message>(
+      SQLiteQueryExecutor::getConnectionManager(), messages);
 }
 
 void SQLiteQueryExecutor::rekeyMessage(std::string from, std::string to) const {
@@ -1178,12 +2092,13 @@ void SQLiteQueryExecutor::rekeyMessage(std::string from, std::string to) const {
       "SET id = ? "
       "WHERE id = ?";
   rekeyAllEntities(
-      SQLiteQueryExecutor::getConnection(), rekeyMessageSQL, from, to);
+      SQLiteQueryExecutor::getConnectionManager(), rekeyMessageSQL, from, to);
 }
 
 void SQLiteQueryExecutor::removeAllMedia() const {
   static std::string removeAllMediaSQL = "DELETE FROM media;";
-  removeAllEntities(SQLiteQueryExecutor::getConnection(), removeAllMediaSQL);
+  removeAllEntities(
+      SQLiteQueryExecutor::getConnectionManager(), removeAllMediaSQL);
 }
 
 void SQLiteQueryExecutor::removeMediaForMessages(
@@ -1192,24 +2107,23 @@ void SQLiteQueryExecutor::removeMediaForMessages(
     return;
   }
 
-  std::stringstream removeMediaByKeysSQLStream;
-  removeMediaByKeysSQLStream << "DELETE FROM media "
-                                "WHERE container IN "
-                             << getSQLStatementArray(msg_ids.size()) << ";";
+  static std::string removeMediaByKeysSQLPrefix =
+      "DELETE FROM media "
+      "WHERE container IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeMediaByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeMediaByKeysSQLPrefix,
       msg_ids);
 }
 
 void SQLiteQueryExecutor::removeMediaForMessage(std::string msg_id) const {
   static std::string removeMediaByKeySQL =
       "DELETE FROM media "
-      "WHERE container IN (?);";
+      "WHERE container IN ";
   std::vector<std::string> keys = {msg_id};
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(), removeMediaByKeySQL, keys);
+      SQLiteQueryExecutor::getConnectionManager(), removeMediaByKeySQL, keys);
 }
 
 void SQLiteQueryExecutor::removeMediaForThreads(
@@ -1218,24 +2132,23 @@ void SQLiteQueryExecutor::removeMediaForThreads(
     return;
   }
 
-  std::stringstream removeMediaByKeysSQLStream;
-  removeMediaByKeysSQLStream << "DELETE FROM media "
-                                "WHERE thread IN "
-                             << getSQLStatementArray(thread_ids.size()) << ";";
+  static std::string removeMediaByKeysSQLPrefix =
+      "DELETE FROM media "
+      "WHERE thread IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeMediaByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeMediaByKeysSQLPrefix,
       thread_ids);
 }
 
 void SQLiteQueryExecutor::replaceMedia(const Media &media) const {
-  static std::string replaceMediaSQL =
-      "REPLACE INTO media "
-      "(id, container, thread, uri, type, extras) "
-      "VALUES (?, ?, ?, ?, ?, ?)";
-  replaceEntity<Media>(
-      SQLiteQueryExecutor::getConnection(), replaceMediaSQL, media);
+  replaceEntity<Media>(SQLiteQueryExecutor::getConnectionManager(), media);
+}
+
+void SQLiteQueryExecutor::replaceMedias(
+    const std::vector<Media> &medias) const {
+  replaceEntities<Media>(SQLiteQueryExecutor::getConnectionManager(), medias);
 }
 
 void SQLiteQueryExecutor::rekeyMediaContainers(std::string from, std::string to)
@@ -1243,21 +2156,17 @@ void SQLiteQueryExecutor::rekeyMediaContainers(std::string from, std::string to)
   static std::string rekeyMediaContainersSQL =
       "UPDATE media SET container = ? WHERE container = ?;";
   rekeyAllEntities(
-      SQLiteQueryExecutor::getConnection(), rekeyMediaContainersSQL, from, to);
+      SQLiteQueryExecutor::getConnectionManager(),
+      rekeyMediaContainersSQL,
+      from,
+      to);
 }
 
 void SQLiteQueryExecutor::replaceMessageStoreThreads(
     const std::vector<MessageStoreThread> &threads) const {
-  static std::string replaceMessageStoreThreadSQL =
-      "REPLACE INTO message_store_threads "
-      "(id, start_reached) "
-      "VALUES (?, ?);";
-
   for (auto &thread : threads) {
     replaceEntity<MessageStoreThread>(
-        SQLiteQueryExecutor::getConnection(),
-        replaceMessageStoreThreadSQL,
-        thread);
+        SQLiteQueryExecutor::getConnectionManager(), thread);
   }
 }
 
@@ -1265,7 +2174,8 @@ void SQLiteQueryExecutor::removeAllMessageStoreThreads() const {
   static std::string removeAllMessageStoreThreadsSQL =
       "DELETE FROM message_store_threads;";
   removeAllEntities(
-      SQLiteQueryExecutor::getConnection(), removeAllMessageStoreThreadsSQL);
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeAllMessageStoreThreadsSQL);
 }
 
 void SQLiteQueryExecutor::removeMessageStoreThreads(
@@ -1274,15 +2184,13 @@ void SQLiteQueryExecutor::removeMessageStoreThreads(
     return;
   }
 
-  std::stringstream removeMessageStoreThreadsByKeysSQLStream;
-  removeMessageStoreThreadsByKeysSQLStream
-      << "DELETE FROM message_store_threads "
-         "WHERE id IN "
-      << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeMessageStoreThreadsByKeysSQLPrefix =
+      "DELETE FROM message_store_threads "
+      "WHERE id IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeMessageStoreThreadsByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeMessageStoreThreadsByKeysSQLPrefix,
       ids);
 }
 
@@ -1292,7 +2200,8 @@ SQLiteQueryExecutor::getAllMessageStoreThreads() const {
       "SELECT * "
       "FROM message_store_threads;";
   return getAllEntities<MessageStoreThread>(
-      SQLiteQueryExecutor::getConnection(), getAllMessageStoreThreadsSQL);
+      SQLiteQueryExecutor::getConnectionManager(),
+      getAllMessageStoreThreadsSQL);
 }
 
 std::vector<Thread> SQLiteQueryExecutor::getAllThreads() const {
@@ -1300,7 +2209,7 @@ std::vector<Thread> SQLiteQueryExecutor::getAllThreads() const {
       "SELECT * "
       "FROM threads;";
   return getAllEntities<Thread>(
-      SQLiteQueryExecutor::getConnection(), getAllThreadsSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllThreadsSQL);
 };
 
 void SQLiteQueryExecutor::removeThreads(std::vector<std::string> ids) const {
@@ -1308,46 +2217,107 @@ void SQLiteQueryExecutor::removeThreads(std::vector<std::string> ids) const {
     return;
   }
 
-  std::stringstream removeThreadsByKeysSQLStream;
-  removeThreadsByKeysSQLStream << "DELETE FROM threads "
-                                  "WHERE id IN "
-                               << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeThreadsByKeysSQLPrefix =
+      "DELETE FROM threads "
+      "WHERE id IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeThreadsByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeThreadsByKeysSQLPrefix,
       ids);
 };
 
 void SQLiteQueryExecutor::replaceThread(const Thread &thread) const {
-  static std::string replaceThreadSQL =
-      "REPLACE INTO threads ("
-      " id, type, name, description, color, creation_time, parent_thread_id,"
-      " containing_thread_id, community, members, roles, current_user,"
-      " source_message_id, replies_count, avatar, pinned_count) "
-      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
-
-  replaceEntity<Thread>(
-      SQLiteQueryExecutor::getConnection(), replaceThreadSQL, thread);
+  replaceEntity<Thread>(SQLiteQueryExecutor::getConnectionManager(), thread);
 };
 
+// Invalid JSON fails the statement. The message of the connection says which
+// JSON was malformed.
+void check_thread_patch_step(sqlite3 *db, int stepResult) {
+  if (stepResult != SQLITE_DONE) {
+    std::stringstream error_message;
+    error_message << "Failed to patch thread. Details: " << sqlite3_errmsg(db)
+                  << std::endl;
+    throw std::runtime_error(error_message.str());
+  }
+}
+
+bool SQLiteQueryExecutor::patchThread(const ThreadPatch &patch) const {
+  // Members are an array, so every member is patched on its own. SQLite
+  // doesn't guarantee the order in which json_group_array aggregates rows
+  // coming from an ordered subquery, so the patched members are read in the
+  // order of the array and put back together here.
+  static std::string getPatchedMembersSQL =
+      "SELECT "
+      "  CASE WHEN member_patch.value IS NULL THEN member.value "
+      "    ELSE json_patch(member.value, member_patch.value) "
+      "  END "
+      "FROM threads, json_each(threads.members) AS member "
+      "LEFT JOIN json_each(?2) AS member_patch "
+      "  ON member_patch.key = json_extract(member.value, '$.id') "
+      "WHERE threads.id = ?1 "
+      "ORDER BY member.key;";
+  static std::string patchThreadSQL =
+      "UPDATE threads "
+      "SET "
+      "  current_user = CASE WHEN ?2 IS NULL THEN current_user "
+      "    ELSE json_patch(current_user, ?2) END, "
+      "  roles = CASE WHEN ?3 IS NULL THEN roles "
+      "    ELSE json_patch(roles, ?3) END, "
+      "  members = CASE WHEN ?4 IS NULL THEN members ELSE ?4 END "
+      "WHERE id = ?1;";
+
+  std::unique_ptr<std::string> patchedMembers;
+  if (patch.members) {
+    SQLiteStatementWrapper preparedSQL(
+        SQLiteQueryExecutor::getConnectionManager(),
+        getPatchedMembersSQL,
+        "Failed to patch thread.");
+    bindStringToSQL(patch.id, preparedSQL, 1);
+    bindStringPtrToSQL(patch.members, preparedSQL, 2);
+
+    // Members are objects, so their JSON text can be joined as is.
+    patchedMembers = std::make_unique<std::string>("[");
+    int stepResult;
+    for (stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
+         stepResult = sqlite3_step(preparedSQL)) {
+      if (patchedMembers->size() > 1) {
+        *patchedMembers += ",";
+      }
+      *patchedMembers += getStringViewFromSQLRow(preparedSQL, 0);
+    }
+    check_thread_patch_step(SQLiteQueryExecutor::getConnection(), stepResult);
+    *patchedMembers += "]";
+  }
+
+  SQLiteStatementWrapper preparedSQL(
+      SQLiteQueryExecutor::getConnectionManager(),
+      patchThreadSQL,
+      "Failed to patch thread.");
+  bindStringToSQL(patch.id, preparedSQL, 1);
+  bindStringPtrToSQL(patch.current_user, preparedSQL, 2);
+  bindStringPtrToSQL(patch.roles, preparedSQL, 3);
+  bindStringPtrToSQL(patchedMembers, preparedSQL, 4);
+
+  check_thread_patch_step(
+      SQLiteQueryExecutor::getConnection(), sqlite3_step(preparedSQL));
+  return sqlite3_changes(SQLiteQueryExecutor::getConnection()) > 0;
+}
+
 void SQLiteQueryExecutor::removeAllThreads() const {
   static std::string removeAllThreadsSQL = "DELETE FROM threads;";
-  removeAllEntities(SQLiteQueryExecutor::getConnection(), removeAllThreadsSQL);
+  removeAllEntities(
+      SQLiteQueryExecutor::getConnectionManager(), removeAllThreadsSQL);
 };
 
 void SQLiteQueryExecutor::replaceReport(const Report &report) const {
-  static std::string replaceReportSQL =
-      "REPLACE INTO reports (id, report) "
-      "VALUES (?, ?);";
-
-  replaceEntity<Report>(
-      SQLiteQueryExecutor::getConnection(), replaceReportSQL, report);
+  replaceEntity<Report>(SQLiteQueryExecutor::getConnectionManager(), report);
 }
 
 void SQLiteQueryExecutor::removeAllReports() const {
   static std::string removeAllReportsSQL = "DELETE FROM reports;";
-  removeAllEntities(SQLiteQueryExecutor::getConnection(), removeAllReportsSQL);
+  removeAllEntities(
+      SQLiteQueryExecutor::getConnectionManager(), removeAllReportsSQL);
 }
 
 void SQLiteQueryExecutor::removeReports(
@@ -1356,13 +2326,12 @@ void SQLiteQueryExecutor::removeReports(
     return;
   }
 
-  std::stringstream removeReportsByKeysSQLStream;
-  removeReportsByKeysSQLStream << "DELETE FROM reports "
-                                  "WHERE id IN "
-                               << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeReportsByKeysSQLPrefix =
+      "DELETE FROM reports "
+      "WHERE id IN ";
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeReportsByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeReportsByKeysSQLPrefix,
       ids);
 }
 
@@ -1371,32 +2340,27 @@ std::vector<Report> SQLiteQueryExecutor::getAllReports() const {
       "SELECT * "
       "FROM reports;";
   return getAllEntities<Report>(
-      SQLiteQueryExecutor::getConnection(), getAllReportsSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllReportsSQL);
 }
 
 void SQLiteQueryExecutor::setPersistStorageItem(
     std::string key,
     std::string item) const {
-  static std::string replacePersistStorageItemSQL =
-      "REPLACE INTO persist_storage (key, item) "
-      "VALUES (?, ?);";
   PersistItem entry{
       key,
       item,
   };
   replaceEntity<PersistItem>(
-      SQLiteQueryExecutor::getConnection(),
-      replacePersistStorageItemSQL,
-      entry);
+      SQLiteQueryExecutor::getConnectionManager(), entry);
 }
 
 void SQLiteQueryExecutor::removePersistStorageItem(std::string key) const {
   static std::string removePersistStorageItemByKeySQL =
       "DELETE FROM persist_storage "
-      "WHERE key IN (?);";
+      "WHERE key IN ";
   std::vector<std::string> keys = {key};
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
+      SQLiteQueryExecutor::getConnectionManager(),
       removePersistStorageItemByKeySQL,
       keys);
 }
@@ -1407,23 +2371,21 @@ std::string SQLiteQueryExecutor::getPersistStorageItem(std::string key) const {
       "FROM persist_storage "
       "WHERE key = ?;";
   std::unique_ptr<PersistItem> entry = getEntityByPrimaryKey<PersistItem>(
-      SQLiteQueryExecutor::getConnection(),
+      SQLiteQueryExecutor::getConnectionManager(),
       getPersistStorageItemByPrimaryKeySQL,
       key);
   return (entry == nullptr) ? "" : entry->item;
 }
 
 void SQLiteQueryExecutor::replaceUser(const UserInfo &user_info) const {
-  static std::string replaceUserSQL =
-      "REPLACE INTO users (id, user_info) "
-      "VALUES (?, ?);";
   replaceEntity<UserInfo>(
-      SQLiteQueryExecutor::getConnection(), replaceUserSQL, user_info);
+      SQLiteQueryExecutor::getConnectionManager(), user_info);
 }
 
 void SQLiteQueryExecutor::removeAllUsers() const {
   static std::string removeAllUsersSQL = "DELETE FROM users;";
-  removeAllEntities(SQLiteQueryExecutor::getConnection(), removeAllUsersSQL);
+  removeAllEntities(
+      SQLiteQueryExecutor::getConnectionManager(), removeAllUsersSQL);
 }
 
 void SQLiteQueryExecutor::removeUsers(
@@ -1432,31 +2394,25 @@ void SQLiteQueryExecutor::removeUsers(
     return;
   }
 
-  std::stringstream removeUsersByKeysSQLStream;
-  removeUsersByKeysSQLStream << "DELETE FROM users "
-                                "WHERE id IN "
-                             << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeUsersByKeysSQLPrefix =
+      "DELETE FROM users "
+      "WHERE id IN ";
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeUsersByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeUsersByKeysSQLPrefix,
       ids);
 }
 
 void SQLiteQueryExecutor::replaceKeyserver(
     const KeyserverInfo &keyserver_info) const {
-  static std::string replaceKeyserverSQL =
-      "REPLACE INTO keyservers (id, keyserver_info) "
-      "VALUES (?, ?);";
   replaceEntity<KeyserverInfo>(
-      SQLiteQueryExecutor::getConnection(),
-      replaceKeyserverSQL,
-      keyserver_info);
+      SQLiteQueryExecutor::getConnectionManager(), keyserver_info);
 }
 
 void SQLiteQueryExecutor::removeAllKeyservers() const {
   static std::string removeAllKeyserversSQL = "DELETE FROM keyservers;";
   removeAllEntities(
-      SQLiteQueryExecutor::getConnection(), removeAllKeyserversSQL);
+      SQLiteQueryExecutor::getConnectionManager(), removeAllKeyserversSQL);
 }
 
 void SQLiteQueryExecutor::removeKeyservers(
@@ -1465,14 +2421,13 @@ void SQLiteQueryExecutor::removeKeyservers(
     return;
   }
 
-  std::stringstream removeKeyserversByKeysSQLStream;
-  removeKeyserversByKeysSQLStream << "DELETE FROM keyservers "
-                                     "WHERE id IN "
-                                  << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeKeyserversByKeysSQLPrefix =
+      "DELETE FROM keyservers "
+      "WHERE id IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeKeyserversByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeKeyserversByKeysSQLPrefix,
       ids);
 }
 
@@ -1481,7 +2436,7 @@ std::vector<KeyserverInfo> SQLiteQueryExecutor::getAllKeyservers() const {
       "SELECT * "
       "FROM keyservers;";
   return getAllEntities<KeyserverInfo>(
-      SQLiteQueryExecutor::getConnection(), getAllKeyserversSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllKeyserversSQL);
 }
 
 std::vector<UserInfo> SQLiteQueryExecutor::getAllUsers() const {
@@ -1489,24 +2444,19 @@ std::vector<UserInfo> SQLiteQueryExecutor::getAllUsers() const {
       "SELECT * "
       "FROM users;";
   return getAllEntities<UserInfo>(
-      SQLiteQueryExecutor::getConnection(), getAllUsersSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllUsersSQL);
 }
 
 void SQLiteQueryExecutor::replaceCommunity(
     const CommunityInfo &community_info) const {
-  static std::string replaceCommunitySQL =
-      "REPLACE INTO communities (id, community_info) "
-      "VALUES (?, ?);";
   replaceEntity<CommunityInfo>(
-      SQLiteQueryExecutor::getConnection(),
-      replaceCommunitySQL,
-      community_info);
+      SQLiteQueryExecutor::getConnectionManager(), community_info);
 }
 
 void SQLiteQueryExecutor::removeAllCommunities() const {
   static std::string removeAllCommunitiesSQL = "DELETE FROM communities;";
   removeAllEntities(
-      SQLiteQueryExecutor::getConnection(), removeAllCommunitiesSQL);
+      SQLiteQueryExecutor::getConnectionManager(), removeAllCommunitiesSQL);
 }
 
 void SQLiteQueryExecutor::removeCommunities(
@@ -1515,14 +2465,13 @@ void SQLiteQueryExecutor::removeCommunities(
     return;
   }
 
-  std::stringstream removeCommunitiesByKeysSQLStream;
-  removeCommunitiesByKeysSQLStream << "DELETE FROM communities "
-                                      "WHERE id IN "
-                                   << getSQLStatementArray(ids.size()) << ";";
+  static std::string removeCommunitiesByKeysSQLPrefix =
+      "DELETE FROM communities "
+      "WHERE id IN ";
 
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(),
-      removeCommunitiesByKeysSQLStream.str(),
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeCommunitiesByKeysSQLPrefix,
       ids);
 }
 
@@ -1531,13 +2480,22 @@ std::vector<CommunityInfo> SQLiteQueryExecutor::getAllCommunities() const {
       "SELECT * "
       "FROM communities;";
   return getAllEntities<CommunityInfo>(
-      SQLiteQueryExecutor::getConnection(), getAllCommunitiesSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllCommunitiesSQL);
 }
 
 void SQLiteQueryExecutor::beginTransaction() const {
   executeQuery(SQLiteQueryExecutor::getConnection(), "BEGIN TRANSACTION;");
 }
 
+void SQLiteQueryExecutor::beginReadTransaction() const {
+  // Transactions are deferred, so the snapshot they read is only taken by
+  // their first read. Reading the schema takes it immediately.
+  executeQuery(
+      SQLiteQueryExecutor::getConnection(),
+      "BEGIN TRANSACTION;"
+      "SELECT count(*) FROM sqlite_master;");
+}
+
 void SQLiteQueryExecutor::commitTransaction() const {
   executeQuery(SQLiteQueryExecutor::getConnection(), "COMMIT;");
 }
@@ -1546,13 +2504,32 @@ void SQLiteQueryExecutor::rollbackTransaction() const {
   executeQuery(SQLiteQueryExecutor::getConnection(), "ROLLBACK;");
 }
 
+void SQLiteQueryExecutor::createSavepoint(const std::string &name) const {
+  executeQuery(SQLiteQueryExecutor::getConnection(), "SAVEPOINT " + name + ";");
+}
+
+void SQLiteQueryExecutor::releaseSavepoint(const std::string &name) const {
+  executeQuery(SQLiteQueryExecutor::getConnection(), "RELEASE " + name + ";");
+}
+
+void SQLiteQueryExecutor::rollbackToSavepoint(const std::string &name) const {
+  // The rollback hook isn't called for savepoints, but the generation bump
+  // may be rolled back with them.
+  client_db_store_generation_bumped = false;
+  // ROLLBACK TO leaves the savepoint on the stack.
+  executeQuery(
+      SQLiteQueryExecutor::getConnection(),
+      "ROLLBACK TO " + name + ";"
+      "RELEASE " + name + ";");
+}
+
 std::vector<OlmPersistSession>
 SQLiteQueryExecutor::getOlmPersistSessionsData() const {
   static std::string getAllOlmPersistSessionsSQL =
       "SELECT * "
       "FROM olm_persist_sessions;";
   return getAllEntities<OlmPersistSession>(
-      SQLiteQueryExecutor::getConnection(), getAllOlmPersistSessionsSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllOlmPersistSessionsSQL);
 }
 
 std::optional<std::string>
@@ -1561,7 +2538,7 @@ SQLiteQueryExecutor::getOlmPersistAccountData() const {
       "SELECT * "
       "FROM olm_persist_account;";
   std::vector<OlmPersistAccount> result = getAllEntities<OlmPersistAccount>(
-      SQLiteQueryExecutor::getConnection(), getAllOlmPersistAccountSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllOlmPersistAccountSQL);
   if (result.size() > 1) {
     throw std::system_error(
         ECANCELED,
@@ -1575,28 +2552,16 @@ SQLiteQueryExecutor::getOlmPersistAccountData() const {
 
 void SQLiteQueryExecutor::storeOlmPersistAccount(
     const std::string &accountData) const {
-  static std::string replaceOlmPersistAccountSQL =
-      "REPLACE INTO olm_persist_account (id, account_data) "
-      "VALUES (?, ?);";
-
   OlmPersistAccount persistAccount = {ACCOUNT_ID, accountData};
 
   replaceEntity<OlmPersistAccount>(
-      SQLiteQueryExecutor::getConnection(),
-      replaceOlmPersistAccountSQL,
-      persistAccount);
+      SQLiteQueryExecutor::getConnectionManager(), persistAccount);
 }
 
 void SQLiteQueryExecutor::storeOlmPersistSession(
     const OlmPersistSession &session) const {
-  static std::string replaceOlmPersistSessionSQL =
-      "REPLACE INTO olm_persist_sessions (target_user_id, session_data) "
-      "VALUES (?, ?);";
-
   replaceEntity<OlmPersistSession>(
-      SQLiteQueryExecutor::getConnection(),
-      replaceOlmPersistSessionSQL,
-      session);
+      SQLiteQueryExecutor::getConnectionManager(), session);
 }
 
 void SQLiteQueryExecutor::storeOlmPersistData(crypto::Persist persist) const {
@@ -1629,24 +2594,22 @@ std::string SQLiteQueryExecutor::getCurrentUserID() const {
 
 void SQLiteQueryExecutor::setMetadata(std::string entry_name, std::string data)
     const {
-  std::string replaceMetadataSQL =
-      "REPLACE INTO metadata (name, data) "
-      "VALUES (?, ?);";
   Metadata entry{
       entry_name,
       data,
   };
-  replaceEntity<Metadata>(
-      SQLiteQueryExecutor::getConnection(), replaceMetadataSQL, entry);
+  replaceEntity<Metadata>(SQLiteQueryExecutor::getConnectionManager(), entry);
 }
 
 void SQLiteQueryExecutor::clearMetadata(std::string entry_name) const {
   static std::string removeMetadataByKeySQL =
       "DELETE FROM metadata "
-      "WHERE name IN (?);";
+      "WHERE name IN ";
   std::vector<std::string> keys = {entry_name};
   removeEntitiesByKeys(
-      SQLiteQueryExecutor::getConnection(), removeMetadataByKeySQL, keys);
+      SQLiteQueryExecutor::getConnectionManager(),
+      removeMetadataByKeySQL,
+      keys);
 }
 
 std::string SQLiteQueryExecutor::getMetadata(std::string entry_name) const {
@@ -1655,7 +2618,7 @@ std::string SQLiteQueryExecutor::getMetadata(std::string entry_name) const {
       "FROM metadata "
       "WHERE name = ?;";
   std::unique_ptr<Metadata> entry = getEntityByPrimaryKey<Metadata>(
-      SQLiteQueryExecutor::getConnection(),
+      SQLiteQueryExecutor::getConnectionManager(),
       getMetadataByPrimaryKeySQL,
       entry_name);
   return (entry == nullptr) ? "" : entry->data;
@@ -1676,6 +2639,10 @@ void SQLiteQueryExecutor::replaceThreadWeb(const WebThread &thread) const {
   this->replaceThread(thread.toThread());
 };
 
+bool SQLiteQueryExecutor::patchThreadWeb(const WebThreadPatch &patch) const {
+  return this->patchThread(patch.toThreadPatch());
+};
+
 std::vector<MessageWithMedias> SQLiteQueryExecutor::getAllMessagesWeb() const {
   auto allMessages = this->getAllMessages();
 
@@ -1688,6 +2655,62 @@ std::vector<MessageWithMedias> SQLiteQueryExecutor::getAllMessagesWeb() const {
   return allMessageWithMedias;
 }
 
+std::vector<MessageWithMedias> SQLiteQueryExecutor::getMessagesForThreadWeb(
+    std::string threadID,
+    std::string beforeTime,
+    std::string beforeID,
+    int limit) const {
+  auto messages = this->getMessagesForThread(
+      threadID, std::stoll(beforeTime), beforeID, limit);
+
+  std::vector<MessageWithMedias> messagesWithMedias;
+  for (auto &messageWithMedia : messages) {
+    messagesWithMedias.push_back(
+        {std::move(messageWithMedia.first), messageWithMedia.second});
+  }
+  return messagesWithMedias;
+}
+
+std::vector<MessageWithMedias>
+SQLiteQueryExecutor::getMessagesForThreadAfterWeb(
+    std::string threadID,
+    std::string afterTime,
+    std::string afterID,
+    int limit) const {
+  auto messages = this->getMessagesForThreadAfter(
+      threadID, std::stoll(afterTime), afterID, limit);
+
+  std::vector<MessageWithMedias> messagesWithMedias;
+  for (auto &messageWithMedia : messages) {
+    messagesWithMedias.push_back(
+        {std::move(messageWithMedia.first), messageWithMedia.second});
+  }
+  return messagesWithMedias;
+}
+
+std::vector<WebThreadSummary>
+SQLiteQueryExecutor::getThreadSummariesWeb() const {
+  auto summaries = this->getThreadSummaries();
+  std::vector<WebThreadSummary> webSummaries;
+  webSummaries.reserve(summaries.size());
+  for (const auto &summary : summaries) {
+    webSummaries.emplace_back(summary);
+  }
+  return webSummaries;
+}
+
+std::vector<std::string> SQLiteQueryExecutor::searchMessagesWeb(
+    std::string query,
+    NullableString threadID,
+    int limit,
+    int offset) const {
+  std::optional<std::string> threadIDValue;
+  if (!threadID.isNull) {
+    threadIDValue = threadID.value;
+  }
+  return this->searchMessages(query, threadIDValue, limit, offset);
+}
+
 void SQLiteQueryExecutor::replaceMessageWeb(const WebMessage &message) const {
   this->replaceMessage(message.toMessage());
 };
@@ -1702,6 +2725,10 @@ NullableString SQLiteQueryExecutor::getOlmPersistAccountDataWeb() const {
 #else
 void SQLiteQueryExecutor::clearSensitiveData() {
   SQLiteQueryExecutor::closeConnection();
+  SQLiteQueryExecutor::discardClientDBStoreSnapshot();
+  // A snapshot write that is already encrypting the store may still leave a
+  // file behind, which the new key can't decrypt.
+  SQLiteQueryExecutor::generateFreshClientDBStoreSnapshotEncryptionKey();
   if (file_exists(SQLiteQueryExecutor::sqliteFilePath) &&
       std::remove(SQLiteQueryExecutor::sqliteFilePath.c_str())) {
     std::ostringstream errorStream;
@@ -1709,13 +2736,93 @@ void SQLiteQueryExecutor::clearSensitiveData() {
                 << strerror(errno);
     throw std::system_error(errno, std::generic_category(), errorStream.str());
   }
+  attempt_delete_write_ahead_log(SQLiteQueryExecutor::sqliteFilePath);
   SQLiteQueryExecutor::generateFreshEncryptionKey();
   SQLiteQueryExecutor::migrate();
 }
 
+// Read connections are opened read-only rather than made so with
+// `PRAGMA query_only`, which would also forbid writing to their temp
+// database, e.g. staging keys of a bulk read.
+sqlite3 *open_read_only_connection(
+    const std::string &filePath,
+    const std::string &encryptionKey) {
+  sqlite3 *db;
+  int openResult =
+      sqlite3_open_v2(filePath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+  if (openResult != SQLITE_OK) {
+    sqlite3_close(db);
+    throw std::runtime_error(
+        "Failed to open read-only database connection. Details: " +
+        std::string{sqlite3_errstr(openResult)});
+  }
+  try {
+    set_encryption_key(db, encryptionKey);
+    set_cipher_settings(db);
+    configure_connection(db);
+  } catch (const std::exception &) {
+    sqlite3_close(db);
+    throw;
+  }
+  return db;
+}
+
+void SQLiteQueryExecutor::setCurrentThreadReadOnly() {
+  SQLiteQueryExecutor::readOnlyThread = true;
+}
+
+void SQLiteQueryExecutor::setCurrentThreadWriter() {
+  SQLiteQueryExecutor::writerThreadID.store(std::this_thread::get_id());
+}
+
+SQLiteConnectionManager &SQLiteQueryExecutor::getReadConnectionManager() {
+  auto &readConnectionManager = SQLiteQueryExecutor::readConnectionManager;
+  if (readConnectionManager &&
+      SQLiteQueryExecutor::readConnectionGeneration ==
+          SQLiteQueryExecutor::connectionsGeneration.load()) {
+    return *readConnectionManager;
+  }
+
+  std::string filePath;
+  std::string key;
+  std::uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(SQLiteQueryExecutor::readConnectionsMutex);
+    filePath = SQLiteQueryExecutor::readConnectionsFilePath;
+    key = SQLiteQueryExecutor::readConnectionsEncryptionKey;
+    generation = SQLiteQueryExecutor::connectionsGeneration.load();
+  }
+  if (!generation) {
+    throw std::runtime_error(
+        "Attempt to read from database before it was initialized.");
+  }
+
+  readConnectionManager.reset();
+  auto newReadConnectionManager = std::make_unique<SQLiteConnectionManager>();
+  newReadConnectionManager->adoptConnection(
+      open_read_only_connection(filePath, key));
+  readConnectionManager = std::move(newReadConnectionManager);
+  SQLiteQueryExecutor::readConnectionGeneration = generation;
+  return *readConnectionManager;
+}
+
+void SQLiteQueryExecutor::invalidateReadConnections() {
+  std::lock_guard<std::mutex> lock(SQLiteQueryExecutor::readConnectionsMutex);
+  SQLiteQueryExecutor::readConnectionsFilePath =
+      SQLiteQueryExecutor::sqliteFilePath;
+  SQLiteQueryExecutor::readConnectionsEncryptionKey =
+      SQLiteQueryExecutor::encryptionKey;
+  SQLiteQueryExecutor::connectionsGeneration++;
+}
+
 void SQLiteQueryExecutor::initialize(std::string &databasePath) {
   std::call_once(SQLiteQueryExecutor::initialized, [&databasePath]() {
     SQLiteQueryExecutor::sqliteFilePath = databasePath;
+    // Has to happen before any connection is opened.
+    if (StaffUtils::isStaffRelease()) {
+      SQLiteProfiler::setEnabled(true);
+    }
+    SQLiteQueryExecutor::initializeClientDBStoreSnapshotEncryptionKey();
     folly::Optional<std::string> maybeEncryptionKey =
         CommSecureStore::get(SQLiteQueryExecutor::secureStoreEncryptionKeyID);
     folly::Optional<std::string> maybeBackupLogsEncryptionKey =
@@ -1768,6 +2875,7 @@ void SQLiteQueryExecutor::createMainCompaction(std::string backupID) const {
   sqlite3 *backupDB;
   sqlite3_open(tempBackupPath.c_str(), &backupDB);
   set_encryption_key(backupDB);
+  set_cipher_settings(backupDB);
 
   sqlite3_backup *backupObj = sqlite3_backup_init(
       backupDB, "main", SQLiteQueryExecutor::getConnection(), "main");
@@ -1793,11 +2901,22 @@ void SQLiteQueryExecutor::createMainCompaction(std::string backupID) const {
     throw std::runtime_error(error_message.str());
   }
 
+  // The backup copies the header of the database, which marks it as using
+  // the write-ahead log. The backup file has to be self-contained, and web
+  // can't open databases using one.
+  executeQuery(backupDB, "PRAGMA journal_mode=DELETE;");
+
   std::string removeDeviceSpecificDataSQL =
       "DELETE FROM olm_persist_account;"
       "DELETE FROM olm_persist_sessions;"
       "DELETE FROM metadata;";
   executeQuery(backupDB, removeDeviceSpecificDataSQL);
+  // VACUUM may renumber rowids the search index refers to, so the index is
+  // rebuilt from scratch on the restored device.
+  executeQuery(backupDB, resetMessageSearchIndexSQL);
+  // The backup is rebuilt anyway, so databases restored from it use
+  // incremental auto vacuum, whenever the one backed up was created.
+  executeQuery(backupDB, "PRAGMA auto_vacuum = INCREMENTAL;");
   executeQuery(backupDB, "VACUUM;");
   sqlite3_close(backupDB);
 
@@ -1815,7 +2934,7 @@ void SQLiteQueryExecutor::createMainCompaction(std::string backupID) const {
   std::string getAllBlobServiceMediaSQL =
       "SELECT * FROM media WHERE uri LIKE 'comm-blob-service://%';";
   std::vector<Media> blobServiceMedia = getAllEntities<Media>(
-      SQLiteQueryExecutor::getConnection(), getAllBlobServiceMediaSQL);
+      SQLiteQueryExecutor::getConnectionManager(), getAllBlobServiceMediaSQL);
 
   for (const auto &media : blobServiceMedia) {
     std::string blobServiceURI = media.uri;
@@ -1856,6 +2975,136 @@ void SQLiteQueryExecutor::generateFreshBackupLogsEncryptionKey() {
   SQLiteQueryExecutor::backupLogsEncryptionKey = backupLogsEncryptionKey;
 }
 
+void SQLiteQueryExecutor::initializeClientDBStoreSnapshotEncryptionKey() {
+  folly::Optional<std::string> maybeEncryptionKey = CommSecureStore::get(
+      SQLiteQueryExecutor::secureStoreClientDBStoreSnapshotEncryptionKeyID);
+  if (!maybeEncryptionKey) {
+    SQLiteQueryExecutor::generateFreshClientDBStoreSnapshotEncryptionKey();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(
+      SQLiteQueryExecutor::clientDBStoreSnapshotMutex);
+  SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKey =
+      maybeEncryptionKey.value();
+}
+
+void SQLiteQueryExecutor::generateFreshClientDBStoreSnapshotEncryptionKey() {
+  std::string encryptionKey = comm::crypto::Tools::generateRandomHexString(
+      SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKeySize);
+  CommSecureStore::set(
+      SQLiteQueryExecutor::secureStoreClientDBStoreSnapshotEncryptionKeyID,
+      encryptionKey);
+  std::lock_guard<std::mutex> lock(
+      SQLiteQueryExecutor::clientDBStoreSnapshotMutex);
+  SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKey = encryptionKey;
+}
+
+void SQLiteQueryExecutor::discardClientDBStoreSnapshot() {
+  std::lock_guard<std::mutex> lock(
+      SQLiteQueryExecutor::clientDBStoreSnapshotMutex);
+  SQLiteQueryExecutor::clientDBStoreSnapshotEpoch++;
+  ClientDBStoreSnapshot::remove(
+      SQLiteQueryExecutor::getClientDBStoreSnapshotPath());
+}
+
+std::string SQLiteQueryExecutor::getClientDBStoreSnapshotPath() {
+  return SQLiteQueryExecutor::sqliteFilePath + "_store_snapshot";
+}
+
+std::optional<std::uint64_t>
+SQLiteQueryExecutor::getClientDBStoreGeneration() const {
+  std::string generation = this->getMetadata("client_db_store_generation");
+  if (!generation.size()) {
+    return std::nullopt;
+  }
+  try {
+    return std::stoull(generation);
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+}
+
+std::unique_ptr<ClientDBStore> SQLiteQueryExecutor::getClientDBStoreSnapshot(
+    std::size_t messagesChunkSize,
+    const std::function<void(std::vector<MessageEntity> &&)> &onMessages)
+    const {
+  std::optional<std::uint64_t> generation = this->getClientDBStoreGeneration();
+  if (!generation.has_value()) {
+    return nullptr;
+  }
+  std::string encryptionKey;
+  {
+    std::lock_guard<std::mutex> lock(
+        SQLiteQueryExecutor::clientDBStoreSnapshotMutex);
+    encryptionKey = SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKey;
+  }
+  return ClientDBStoreSnapshot::read(
+      SQLiteQueryExecutor::getClientDBStoreSnapshotPath(),
+      encryptionKey,
+      generation.value(),
+      messagesChunkSize,
+      onMessages);
+}
+
+// Messages are encrypted and written as they are read, so that only a chunk
+// of them is held in memory, and the read transaction lasts until the whole
+// snapshot is written.
+void SQLiteQueryExecutor::writeClientDBStoreSnapshot() const {
+  static const std::size_t messagesChunkSize = 1000;
+  std::string snapshotPath =
+      SQLiteQueryExecutor::getClientDBStoreSnapshotPath();
+  std::optional<std::uint64_t> generation;
+  ClientDBStore store;
+  std::string encryptionKey;
+  std::uint64_t epoch;
+  {
+    std::lock_guard<std::mutex> lock(
+        SQLiteQueryExecutor::clientDBStoreSnapshotMutex);
+    encryptionKey = SQLiteQueryExecutor::clientDBStoreSnapshotEncryptionKey;
+    epoch = SQLiteQueryExecutor::clientDBStoreSnapshotEpoch;
+  }
+
+  this->beginReadTransaction();
+  try {
+    generation = this->getClientDBStoreGeneration();
+    if (!generation.has_value() ||
+        ClientDBStoreSnapshot::getGeneration(snapshotPath) == generation) {
+      this->commitTransaction();
+      return;
+    }
+    store.drafts = this->getAllDrafts();
+    store.threads = this->getAllThreads();
+    store.messageStoreThreads = this->getAllMessageStoreThreads();
+    store.reports = this->getAllReports();
+    store.users = this->getAllUsers();
+    store.keyservers = this->getAllKeyservers();
+    store.communities = this->getAllCommunities();
+    ClientDBStoreSnapshot::writeTemporary(
+        snapshotPath,
+        encryptionKey,
+        generation.value(),
+        store,
+        [this](const ClientDBStoreSnapshot::MessagesChunkCallback &onChunk) {
+          this->getAllMessagesInChunks(messagesChunkSize, onChunk);
+        });
+    this->commitTransaction();
+  } catch (...) {
+    this->rollbackTransaction();
+    throw;
+  }
+
+  // Sensitive data may have been cleared while the store was being read and
+  // encrypted, so the snapshot is only committed if it hasn't been discarded
+  // in the meantime.
+  std::lock_guard<std::mutex> lock(
+      SQLiteQueryExecutor::clientDBStoreSnapshotMutex);
+  if (epoch != SQLiteQueryExecutor::clientDBStoreSnapshotEpoch) {
+    ClientDBStoreSnapshot::remove(snapshotPath);
+    return;
+  }
+  ClientDBStoreSnapshot::commitTemporary(snapshotPath);
+}
+
 void SQLiteQueryExecutor::captureBackupLogs() const {
   std::string backupID = this->getMetadata("backupID");
   if (!backupID.size()) {
@@ -1874,6 +3123,131 @@ void SQLiteQueryExecutor::captureBackupLogs() const {
   }
   this->setMetadata("logID", std::to_string(std::stoi(logID) + 1));
 }
+
+// Databases created before incremental auto vacuum was set up switch to it
+// only once the whole database is rebuilt.
+void rebuild_with_incremental_auto_vacuum(
+    const SQLiteQueryExecutor &executor,
+    sqlite3 *db,
+    DatabaseMaintenanceReport &report) {
+  int pagesCount = get_integer_pragma(db, "page_count");
+  // VACUUM may renumber rowids the search index refers to, so the index is
+  // rebuilt from scratch once VACUUM succeeded. The reset is recorded first,
+  // so it isn't lost if the app is killed in between.
+  executor.setMetadata(MESSAGE_SEARCH_INDEX_RESET_PENDING, "1");
+  executeQuery(db, "PRAGMA auto_vacuum = INCREMENTAL;");
+  executeQuery(db, "VACUUM;");
+  // VACUUM wrote the whole database to the write-ahead log, which would
+  // otherwise keep its size until the next checkpoint resets it.
+  executeQuery(db, "PRAGMA wal_checkpoint(TRUNCATE);");
+  report.pagesReclaimed += pagesCount - get_integer_pragma(db, "page_count");
+  report.autoVacuumConverted = true;
+}
+
+void reset_message_search_index_if_pending(
+    const SQLiteQueryExecutor &executor,
+    DatabaseMaintenanceReport &report) {
+  if (!executor.getMetadata(MESSAGE_SEARCH_INDEX_RESET_PENDING).size()) {
+    return;
+  }
+  executor.beginTransaction();
+  try {
+    executor.resetMessageSearchIndex();
+    executor.clearMetadata(MESSAGE_SEARCH_INDEX_RESET_PENDING);
+    executor.commitTransaction();
+  } catch (...) {
+    executor.rollbackTransaction();
+    throw;
+  }
+  report.messageSearchIndexReset = true;
+}
+
+DatabaseMaintenanceReport
+SQLiteQueryExecutor::performMaintenance(int timeBudgetMs) const {
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(timeBudgetMs);
+  sqlite3 *db = SQLiteQueryExecutor::getConnection();
+  DatabaseMaintenanceReport report;
+
+  // Rebuilding the database can't be split up into slices, so it's done
+  // here only if VACUUM is estimated to fit in the time budget. Larger
+  // databases are left to `convertToIncrementalAutoVacuum`.
+  int autoVacuum = get_integer_pragma(db, "auto_vacuum");
+  int64_t databaseSize = static_cast<int64_t>(get_integer_pragma(
+                             db, "page_count")) *
+      get_integer_pragma(db, "page_size");
+  auto estimatedVacuumEnd = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(databaseSize / VACUUM_BYTES_PER_MS);
+  if (autoVacuum != AUTO_VACUUM_INCREMENTAL &&
+      estimatedVacuumEnd <= deadline) {
+    rebuild_with_incremental_auto_vacuum(*this, db, report);
+    autoVacuum = AUTO_VACUUM_INCREMENTAL;
+  } else if (autoVacuum != AUTO_VACUUM_INCREMENTAL) {
+    report.autoVacuumConversionPending = true;
+  }
+
+  reset_message_search_index_if_pending(*this, report);
+
+  int freePagesCount = 0;
+  if (autoVacuum == AUTO_VACUUM_INCREMENTAL) {
+    freePagesCount = get_integer_pragma(db, "freelist_count");
+  }
+  while (freePagesCount > 0 && std::chrono::steady_clock::now() < deadline) {
+    executeQuery(
+        db,
+        "PRAGMA incremental_vacuum(" +
+            std::to_string(INCREMENTAL_VACUUM_PAGES) + ");");
+    int remainingFreePagesCount = get_integer_pragma(db, "freelist_count");
+    report.pagesReclaimed += freePagesCount - remainingFreePagesCount;
+    freePagesCount = remainingFreePagesCount;
+  }
+
+  if (!freePagesCount && std::chrono::steady_clock::now() < deadline) {
+    // Statistics are gathered from a sample of every index, which keeps
+    // ANALYZE and the one run by `optimize` short on large tables.
+    executeQuery(
+        db,
+        "PRAGMA analysis_limit = " + std::to_string(ANALYSIS_LIMIT) + ";");
+    executeQuery(db, "PRAGMA optimize;");
+    report.optimized = true;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    std::string lastAnalyzeTime = this->getMetadata("last_analyze_time");
+    bool analyzeDue = !lastAnalyzeTime.size() ||
+        now - std::stoll(lastAnalyzeTime) >= ANALYZE_INTERVAL_S;
+    // `optimize` may have used up the budget, then ANALYZE is left to the
+    // next slice.
+    if (analyzeDue && std::chrono::steady_clock::now() < deadline) {
+      executeQuery(db, "ANALYZE;");
+      this->setMetadata("last_analyze_time", std::to_string(now));
+      report.analyzed = true;
+    }
+    report.completed = !analyzeDue || report.analyzed;
+  }
+
+  report.timeSpentMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return report;
+}
+
+DatabaseMaintenanceReport
+SQLiteQueryExecutor::convertToIncrementalAutoVacuum() const {
+  auto start = std::chrono::steady_clock::now();
+  sqlite3 *db = SQLiteQueryExecutor::getConnection();
+  DatabaseMaintenanceReport report;
+  if (get_integer_pragma(db, "auto_vacuum") != AUTO_VACUUM_INCREMENTAL) {
+    rebuild_with_incremental_auto_vacuum(*this, db, report);
+  }
+  reset_message_search_index_if_pending(*this, report);
+  report.completed = true;
+  report.timeSpentMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return report;
+}
 #endif
 
 void SQLiteQueryExecutor::restoreFromMainCompaction(
@@ -1936,6 +3310,7 @@ void SQLiteQueryExecutor::restoreFromMainCompaction(
 #else
   sqlite3_open(mainCompactionPath.c_str(), &backupDB);
   set_encryption_key(backupDB, mainCompactionEncryptionKey);
+  set_cipher_settings(backupDB);
 #endif
 
   sqlite3_backup *backupObj = sqlite3_backup_init(
@@ -1952,6 +3327,10 @@ void SQLiteQueryExecutor::restoreFromMainCompaction(
   int backupResult = sqlite3_backup_step(backupObj, -1);
   sqlite3_backup_finish(backupObj);
   sqlite3_close(backupDB);
+  SQLiteQueryExecutor::connectionManager.clearStatementCache();
+#ifndef EMSCRIPTEN
+  SQLiteQueryExecutor::invalidateReadConnections();
+#endif
   if (backupResult == SQLITE_BUSY || backupResult == SQLITE_LOCKED) {
     throw std::runtime_error(
         "Programmer error. Database in transaction during restore attempt.");
@@ -1971,11 +3350,16 @@ void SQLiteQueryExecutor::restoreFromMainCompaction(
   attempt_delete_file(
       mainCompactionPath,
       "Failed to delete main compaction file after successful restore.");
+#ifndef EMSCRIPTEN
+  SQLiteQueryExecutor::discardClientDBStoreSnapshot();
+#endif
 }
 
 void SQLiteQueryExecutor::restoreFromBackupLog(
     const std::vector<std::uint8_t> &backupLog) const {
-  SQLiteQueryExecutor::connectionManager.restoreFromBackupLog(backupLog);
+  this->runInTransaction([&backupLog]() {
+    SQLiteQueryExecutor::connectionManager.restoreFromBackupLog(backupLog);
+  });
 }
 
 } // namespace comm
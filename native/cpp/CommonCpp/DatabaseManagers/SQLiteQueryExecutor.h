@@ -1,34 +1,87 @@
 #pragma once
 
 #include "../CryptoTools/Persist.h"
+#include "ClientDBStoreSnapshot.h"
 #include "DatabaseQueryExecutor.h"
 #include "NativeSQLiteConnectionManager.h"
+#include "SQLitePerformanceProfile.h"
 #include "entities/CommunityInfo.h"
 #include "entities/Draft.h"
 #include "entities/KeyserverInfo.h"
 #include "entities/UserInfo.h"
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 namespace comm {
 
 class SQLiteQueryExecutor : public DatabaseQueryExecutor {
   static void migrate();
   static sqlite3 *getConnection();
+  static SQLiteConnectionManager &getConnectionManager();
   static void closeConnection();
 
   static std::once_flag initialized;
+  // Set once the schema is up to date, so that executors created later on
+  // other threads skip migrations.
+  static std::atomic<bool> migrated;
+  static std::mutex migrationMutex;
   static int sqlcipherEncryptionKeySize;
   static std::string secureStoreEncryptionKeyID;
   static int backupLogsEncryptionKeySize;
   static std::string secureStoreBackupLogsEncryptionKeyID;
   static std::string backupLogsEncryptionKey;
 
+  std::vector<std::pair<Message, std::vector<Media>>> getMessagesPageWithMedia(
+      const std::string &getMessagesPageSQL,
+      std::string threadID,
+      int64_t time,
+      std::string id,
+      int limit) const;
+
 #ifndef EMSCRIPTEN
   static NativeSQLiteConnectionManager connectionManager;
   static void generateFreshEncryptionKey();
   static void generateFreshBackupLogsEncryptionKey();
+
+  static int clientDBStoreSnapshotEncryptionKeySize;
+  static std::string secureStoreClientDBStoreSnapshotEncryptionKeyID;
+  // Guards the snapshot key and epoch, and is held while a snapshot file is
+  // committed or removed.
+  static std::mutex clientDBStoreSnapshotMutex;
+  static std::string clientDBStoreSnapshotEncryptionKey;
+  // Bumped whenever the snapshot is discarded. A snapshot taken before that
+  // isn't committed, as it may hold data of a user who logged out.
+  static std::uint64_t clientDBStoreSnapshotEpoch;
+  static std::string getClientDBStoreSnapshotPath();
+  static void initializeClientDBStoreSnapshotEncryptionKey();
+  static void generateFreshClientDBStoreSnapshotEncryptionKey();
+  static void discardClientDBStoreSnapshot();
+  std::optional<std::uint64_t> getClientDBStoreGeneration() const;
+
+  // Threads marked as read-only query the database through their own
+  // read-only connection instead of the shared writer connection. Those
+  // connections are reopened lazily whenever the writer bumps the generation
+  // (the database file, its key or its schema changed).
+  static thread_local bool readOnlyThread;
+  static thread_local std::unique_ptr<SQLiteConnectionManager>
+      readConnectionManager;
+  static thread_local std::uint64_t readConnectionGeneration;
+  static std::atomic<std::uint64_t> connectionsGeneration;
+  static std::mutex readConnectionsMutex;
+  static std::string readConnectionsFilePath;
+  static std::string readConnectionsEncryptionKey;
+  static SQLiteConnectionManager &getReadConnectionManager();
+  static void invalidateReadConnections();
+  // SQLite is built with SQLITE_THREADSAFE=2, so neither the writer
+  // connection nor the statements cached for it in `connectionManager` are
+  // guarded by a lock, and they must only be used by one thread. Once the
+  // database thread is set, that's the only thread using them. Before that
+  // tasks run on their callers one at a time.
+  static std::atomic<std::thread::id> writerThreadID;
 #else
   static SQLiteConnectionManager connectionManager;
 #endif
@@ -36,6 +89,9 @@ class SQLiteQueryExecutor : public DatabaseQueryExecutor {
 public:
   static std::string sqliteFilePath;
   static std::string encryptionKey;
+  // Applied to connections when they're opened, so it has to be set before
+  // `initialize`.
+  static SQLitePerformanceProfile performanceProfile;
 
   SQLiteQueryExecutor();
   ~SQLiteQueryExecutor();
@@ -50,10 +106,33 @@ public:
   void removeAllMessages() const override;
   std::vector<std::pair<Message, std::vector<Media>>>
   getAllMessages() const override;
+  void getAllMessagesInChunks(
+      std::size_t chunkSize,
+      const std::function<void(std::vector<MessageEntity> &&)> &onChunk)
+      const override;
+  std::vector<std::pair<Message, std::vector<Media>>> getMessagesForThread(
+      std::string threadID,
+      int64_t beforeTime,
+      std::string beforeID,
+      int limit) const override;
+  std::vector<std::pair<Message, std::vector<Media>>> getMessagesForThreadAfter(
+      std::string threadID,
+      int64_t afterTime,
+      std::string afterID,
+      int limit) const override;
+  std::vector<std::string> searchMessages(
+      std::string query,
+      std::optional<std::string> threadID,
+      int limit,
+      int offset) const override;
+  bool indexMessagesForSearch(int messagesCount) const override;
+  void resetMessageSearchIndex() const override;
+  std::vector<ThreadSummary> getThreadSummaries() const override;
   void removeMessages(const std::vector<std::string> &ids) const override;
   void removeMessagesForThreads(
       const std::vector<std::string> &threadIDs) const override;
   void replaceMessage(const Message &message) const override;
+  void replaceMessages(const std::vector<Message> &messages) const override;
   void rekeyMessage(std::string from, std::string to) const override;
   void replaceMessageStoreThreads(
       const std::vector<MessageStoreThread> &threads) const override;
@@ -68,10 +147,12 @@ public:
   void removeMediaForThreads(
       const std::vector<std::string> &thread_ids) const override;
   void replaceMedia(const Media &media) const override;
+  void replaceMedias(const std::vector<Media> &medias) const override;
   void rekeyMediaContainers(std::string from, std::string to) const override;
   std::vector<Thread> getAllThreads() const override;
   void removeThreads(std::vector<std::string> ids) const override;
   void replaceThread(const Thread &thread) const override;
+  bool patchThread(const ThreadPatch &patch) const override;
   void removeAllThreads() const override;
   void replaceReport(const Report &report) const override;
   void removeReports(const std::vector<std::string> &ids) const override;
@@ -93,8 +174,12 @@ public:
   void removeAllCommunities() const override;
   std::vector<CommunityInfo> getAllCommunities() const override;
   void beginTransaction() const override;
+  void beginReadTransaction() const override;
   void commitTransaction() const override;
   void rollbackTransaction() const override;
+  void createSavepoint(const std::string &name) const override;
+  void releaseSavepoint(const std::string &name) const override;
+  void rollbackToSavepoint(const std::string &name) const override;
   std::vector<OlmPersistSession> getOlmPersistSessionsData() const override;
   std::optional<std::string> getOlmPersistAccountData() const override;
   void storeOlmPersistSession(const OlmPersistSession &session) const override;
@@ -116,14 +201,40 @@ public:
 #ifdef EMSCRIPTEN
   std::vector<WebThread> getAllThreadsWeb() const override;
   void replaceThreadWeb(const WebThread &thread) const override;
+  bool patchThreadWeb(const WebThreadPatch &patch) const override;
   std::vector<MessageWithMedias> getAllMessagesWeb() const override;
+  std::vector<MessageWithMedias> getMessagesForThreadWeb(
+      std::string threadID,
+      std::string beforeTime,
+      std::string beforeID,
+      int limit) const override;
+  std::vector<MessageWithMedias> getMessagesForThreadAfterWeb(
+      std::string threadID,
+      std::string afterTime,
+      std::string afterID,
+      int limit) const override;
+  std::vector<std::string> searchMessagesWeb(
+      std::string query,
+      NullableString threadID,
+      int limit,
+      int offset) const override;
+  std::vector<WebThreadSummary> getThreadSummariesWeb() const override;
   void replaceMessageWeb(const WebMessage &message) const override;
   NullableString getOlmPersistAccountDataWeb() const override;
 #else
   static void clearSensitiveData();
   static void initialize(std::string &databasePath);
+  static void setCurrentThreadReadOnly();
+  static void setCurrentThreadWriter();
   void createMainCompaction(std::string backupID) const override;
   void captureBackupLogs() const override;
+  std::unique_ptr<ClientDBStore> getClientDBStoreSnapshot(
+      std::size_t messagesChunkSize,
+      const std::function<void(std::vector<MessageEntity> &&)> &onMessages)
+      const override;
+  void writeClientDBStoreSnapshot() const override;
+  DatabaseMaintenanceReport performMaintenance(int timeBudgetMs) const override;
+  DatabaseMaintenanceReport convertToIncrementalAutoVacuum() const override;
 #endif
 };
 
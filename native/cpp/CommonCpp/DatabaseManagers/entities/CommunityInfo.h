@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,24 @@ struct CommunityInfo {
   std::string id;
   std::string community_info;
 
-  static CommunityInfo fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return CommunityInfo{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static CommunityInfo fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    return bindStringToSQL(community_info, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<CommunityInfo> {
+  static constexpr EntitySchema schema{
+      "communities",
+      entityColumn("id", &CommunityInfo::id),
+      entityColumn("community_info", &CommunityInfo::community_info)};
 };
 
+inline CommunityInfo
+CommunityInfo::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<CommunityInfo>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int CommunityInfo::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<CommunityInfo>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,23 @@ struct Draft {
   std::string key;
   std::string text;
 
-  static Draft fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return Draft{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static Draft fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(key, sql, idx);
-    return bindStringToSQL(text, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<Draft> {
+  static constexpr EntitySchema schema{
+      "drafts",
+      entityColumn("key", &Draft::key),
+      entityColumn("text", &Draft::text)};
 };
 
+inline Draft Draft::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<Draft>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int Draft::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<Draft>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
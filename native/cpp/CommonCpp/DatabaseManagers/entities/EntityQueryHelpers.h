@@ -1,33 +1,208 @@
 #pragma once
 
+#include "../SQLiteConnectionManager.h"
+#include "EntitySchema.h"
 #include "SQLiteDataConverters.h"
 #include "SQLiteStatementWrapper.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 namespace comm {
 
+// Query texts are built once per batch size and reused afterwards. The cache
+// is per thread since read-only threads build them concurrently with the
+// database thread. Batch sizes are rounded to powers of two by the callers,
+// so only a handful of texts is ever built for a given prefix.
+inline std::string &
+getCachedBatchSQL(const std::string &batchSQLPrefix, size_t batchSize) {
+  thread_local std::
+      unordered_map<std::string, std::unordered_map<size_t, std::string>>
+          batchSQLCache;
+  return batchSQLCache[batchSQLPrefix][batchSize];
+}
+
+// An IN list gets a power-of-two number of placeholders, spare ones being
+// bound to the last key again. Repeating a key doesn't change what the list
+// matches, and it keeps the number of distinct statements small.
+inline size_t getKeysPlaceholdersCount(
+    SQLiteConnectionManager &connectionManager,
+    size_t keysCount) {
+  size_t placeholdersCount = 1;
+  while (placeholdersCount < keysCount) {
+    placeholdersCount *= 2;
+  }
+  int variablesLimit = sqlite3_limit(
+      connectionManager.getConnection(), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+  if (placeholdersCount > static_cast<size_t>(variablesLimit)) {
+    return keysCount;
+  }
+  return placeholdersCount;
+}
+
+// "<prefix>(?, ?, ...);"
+inline const std::string &
+getKeysSQL(const std::string &keysSQLPrefix, size_t placeholdersCount) {
+  std::string &keysSQL = getCachedBatchSQL(keysSQLPrefix, placeholdersCount);
+  if (keysSQL.empty()) {
+    keysSQL.reserve(keysSQLPrefix.size() + 3 * placeholdersCount + 1);
+    keysSQL.append(keysSQLPrefix);
+    keysSQL.append("(?");
+    for (size_t i = 1; i < placeholdersCount; i++) {
+      keysSQL.append(", ?");
+    }
+    keysSQL.append(");");
+  }
+  return keysSQL;
+}
+
+inline void bindKeysToSQL(
+    const std::vector<std::string> &keys,
+    sqlite3_stmt *sql,
+    size_t placeholdersCount) {
+  for (size_t i = 0; i < placeholdersCount; i++) {
+    int bindResult =
+        bindStringToSQL(keys[std::min(i, keys.size() - 1)], sql, i + 1);
+    if (bindResult != SQLITE_OK) {
+      std::stringstream error_message;
+      error_message << "Failed to bind key to SQL statement. Details: "
+                    << sqlite3_errstr(bindResult) << std::endl;
+      throw std::runtime_error(error_message.str());
+    }
+  }
+}
+
+// Above this many keys, bulk operations stage them in a temporary table
+// instead of inlining them. One statement (and plan) then serves any number
+// of keys, and SQLITE_LIMIT_VARIABLE_NUMBER no longer applies. Shorter lists
+// stay inline since staging costs a few extra statements.
+const size_t maxInlineKeysCount = 32;
+
+// "<prefix>temp.bulk_keys;"
+inline const std::string &getKeysTableSQL(const std::string &keysSQLPrefix) {
+  thread_local std::unordered_map<std::string, std::string> keysTableSQLCache;
+  std::string &keysTableSQL = keysTableSQLCache[keysSQLPrefix];
+  if (keysTableSQL.empty()) {
+    keysTableSQL = keysSQLPrefix + "temp.bulk_keys;";
+  }
+  return keysTableSQL;
+}
+
+inline void clearKeysTable(SQLiteConnectionManager &connectionManager) {
+  static const std::string clearKeysTableSQL = "DELETE FROM temp.bulk_keys;";
+  SQLiteStatementWrapper preparedSQL(
+      connectionManager, clearKeysTableSQL, "Failed to clear bulk keys.");
+  preparedSQL.checkDone(sqlite3_step(preparedSQL));
+}
+
+// Fills temp.bulk_keys with the given keys. The table lives in the temp
+// database of the connection, so it is neither persisted nor captured by
+// backup logs, and read-only connections can use it as well. It's created on
+// first use, which also covers connections reopened after a restore.
+inline void stageKeys(
+    SQLiteConnectionManager &connectionManager,
+    const std::vector<std::string> &keys) {
+  static const std::string createKeysTableSQL =
+      "CREATE TEMP TABLE IF NOT EXISTS bulk_keys ("
+      "  key TEXT PRIMARY KEY NOT NULL"
+      ");";
+  static const std::string insertKeySQL =
+      "INSERT OR IGNORE INTO temp.bulk_keys (key) VALUES (?);";
+  {
+    SQLiteStatementWrapper preparedSQL(
+        connectionManager,
+        createKeysTableSQL,
+        "Failed to create bulk keys table.");
+    preparedSQL.checkDone(sqlite3_step(preparedSQL));
+  }
+  clearKeysTable(connectionManager);
+
+  SQLiteStatementWrapper preparedSQL(
+      connectionManager, insertKeySQL, "Failed to stage bulk keys.");
+  for (const std::string &key : keys) {
+    int bindResult = bindStringToSQL(key, preparedSQL, 1);
+    if (bindResult != SQLITE_OK) {
+      std::stringstream error_message;
+      error_message << "Failed to bind key to SQL statement. Details: "
+                    << sqlite3_errstr(bindResult) << std::endl;
+      throw std::runtime_error(error_message.str());
+    }
+    preparedSQL.checkDone(sqlite3_step(preparedSQL));
+    sqlite3_reset(preparedSQL);
+  }
+}
+
 template <typename T>
-std::vector<T> getAllEntities(sqlite3 *db, std::string getAllEntitiesSQL) {
+std::vector<T> getAllEntities(
+    SQLiteConnectionManager &connectionManager,
+    const std::string &getAllEntitiesSQL) {
   SQLiteStatementWrapper preparedSQL(
-      db, getAllEntitiesSQL, "Failed to retrieve entities.");
+      connectionManager, getAllEntitiesSQL, "Failed to retrieve entities.");
   std::vector<T> allEntities;
 
-  for (int stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
+  int stepResult;
+  for (stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
        stepResult = sqlite3_step(preparedSQL)) {
     allEntities.emplace_back(T::fromSQLResult(preparedSQL, 0));
   }
+  preparedSQL.checkDone(stepResult);
   return allEntities;
 }
 
+template <typename T>
+std::vector<T> getAllEntitiesByKeys(
+    SQLiteConnectionManager &connectionManager,
+    const std::string &getAllEntitiesByKeysSQLPrefix,
+    const std::vector<std::string> &keys) {
+  if (keys.empty()) {
+    return {};
+  }
+
+  bool keysStaged = keys.size() > maxInlineKeysCount;
+  size_t placeholdersCount = 0;
+  if (keysStaged) {
+    stageKeys(connectionManager, keys);
+  } else {
+    placeholdersCount =
+        getKeysPlaceholdersCount(connectionManager, keys.size());
+  }
+
+  std::vector<T> entities;
+  {
+    SQLiteStatementWrapper preparedSQL(
+        connectionManager,
+        keysStaged
+            ? getKeysTableSQL(getAllEntitiesByKeysSQLPrefix)
+            : getKeysSQL(getAllEntitiesByKeysSQLPrefix, placeholdersCount),
+        "Failed to retrieve entities by keys.");
+    if (!keysStaged) {
+      bindKeysToSQL(keys, preparedSQL, placeholdersCount);
+    }
+
+    int stepResult;
+    for (stepResult = sqlite3_step(preparedSQL); stepResult == SQLITE_ROW;
+         stepResult = sqlite3_step(preparedSQL)) {
+      entities.emplace_back(T::fromSQLResult(preparedSQL, 0));
+    }
+    preparedSQL.checkDone(stepResult);
+  }
+  if (keysStaged) {
+    clearKeysTable(connectionManager);
+  }
+  return entities;
+}
+
 template <typename T>
 std::unique_ptr<T> getEntityByPrimaryKey(
-    sqlite3 *db,
-    std::string getEntityByPrimaryKeySQL,
+    SQLiteConnectionManager &connectionManager,
+    const std::string &getEntityByPrimaryKeySQL,
     std::string primaryKey) {
   SQLiteStatementWrapper preparedSQL(
-      db, getEntityByPrimaryKeySQL, "Failed to fetch row by primary key.");
+      connectionManager,
+      getEntityByPrimaryKeySQL,
+      "Failed to fetch row by primary key.");
   int bindResult = bindStringToSQL(primaryKey, preparedSQL, 1);
   if (bindResult != SQLITE_OK) {
     std::stringstream error_message;
@@ -37,15 +212,9 @@ std::unique_ptr<T> getEntityByPrimaryKey(
   }
 
   int stepResult = sqlite3_step(preparedSQL);
-  if (stepResult == SQLITE_DONE) {
-    return nullptr;
-  }
-
   if (stepResult != SQLITE_ROW) {
-    std::stringstream error_message;
-    error_message << "Failed to fetch row by primary key. Details: "
-                  << sqlite3_errstr(stepResult) << std::endl;
-    throw std::runtime_error(error_message.str());
+    preparedSQL.checkDone(stepResult);
+    return nullptr;
   }
 
   T entity = T::fromSQLResult(preparedSQL, 0);
@@ -53,9 +222,11 @@ std::unique_ptr<T> getEntityByPrimaryKey(
 }
 
 template <typename T>
-void replaceEntity(sqlite3 *db, std::string replaceEntitySQL, const T &entity) {
+void replaceEntity(
+    SQLiteConnectionManager &connectionManager,
+    const T &entity) {
   SQLiteStatementWrapper preparedSQL(
-      db, replaceEntitySQL, "Failed to replace entity.");
+      connectionManager, EntitySQL<T>::replace(), "Failed to replace entity.");
   // "REPLACE INTO ..." query is assumed since
   // it was used by orm previously
   int bindResult = entity.bindToSQL(preparedSQL, 1);
@@ -66,42 +237,130 @@ void replaceEntity(sqlite3 *db, std::string replaceEntitySQL, const T &entity) {
     throw std::runtime_error(error_message.str());
   }
 
-  sqlite3_step(preparedSQL);
+  preparedSQL.checkDone(sqlite3_step(preparedSQL));
 }
 
-void removeAllEntities(sqlite3 *db, std::string removeAllEntitiesSQL) {
+// Preparing statements with thousands of rows costs more than it saves, so
+// rows per statement are capped below SQLITE_LIMIT_VARIABLE_NUMBER as well.
+const size_t maxRowsPerReplaceStatement = 256;
+
+// "REPLACE INTO ... VALUES (?, ...), (?, ...), ...;"
+template <typename T>
+const std::string &getReplaceEntitiesSQL(size_t rowsCount) {
+  const std::string &replaceEntitiesSQLPrefix = EntitySQL<T>::replacePrefix();
+  std::string &replaceEntitiesSQL =
+      getCachedBatchSQL(replaceEntitiesSQLPrefix, rowsCount);
+  if (replaceEntitiesSQL.empty()) {
+    const std::string &rowPlaceholders = EntitySQL<T>::rowPlaceholders();
+    replaceEntitiesSQL.reserve(
+        replaceEntitiesSQLPrefix.size() +
+        rowsCount * (rowPlaceholders.size() + 2));
+    replaceEntitiesSQL.append(replaceEntitiesSQLPrefix);
+    replaceEntitiesSQL.append(rowPlaceholders);
+    for (size_t i = 1; i < rowsCount; i++) {
+      replaceEntitiesSQL.append(", ");
+      replaceEntitiesSQL.append(rowPlaceholders);
+    }
+    replaceEntitiesSQL.append(";");
+  }
+  return replaceEntitiesSQL;
+}
+
+// Replaces entities using multi-row "VALUES (...), (...)" statements. The
+// remainder of a batch is split into power-of-two sized statements, so the
+// number of distinct statements kept in the connection statement cache stays
+// small.
+template <typename T>
+void replaceEntities(
+    SQLiteConnectionManager &connectionManager,
+    const std::vector<T> &entities) {
+  constexpr int columnsCount = EntitySQL<T>::columnsCount;
+  int variablesLimit = sqlite3_limit(
+      connectionManager.getConnection(), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+  size_t maxRowsPerStatement = std::min(
+      static_cast<size_t>(std::max(variablesLimit / columnsCount, 1)),
+      maxRowsPerReplaceStatement);
+
+  size_t replacedCount = 0;
+  while (replacedCount < entities.size()) {
+    size_t remainingCount = entities.size() - replacedCount;
+    size_t rowsCount = maxRowsPerStatement;
+    if (remainingCount < maxRowsPerStatement) {
+      rowsCount = 1;
+      while (rowsCount * 2 <= remainingCount) {
+        rowsCount *= 2;
+      }
+    }
+
+    SQLiteStatementWrapper preparedSQL(
+        connectionManager,
+        getReplaceEntitiesSQL<T>(rowsCount),
+        "Failed to replace entities.");
+    for (size_t i = 0; i < rowsCount; i++) {
+      int bindResult = entities[replacedCount + i].bindToSQL(
+          preparedSQL, i * columnsCount + 1);
+      if (bindResult != SQLITE_OK) {
+        std::stringstream error_message;
+        error_message << "Failed to bind entity to SQL statement. Details: "
+                      << sqlite3_errstr(bindResult) << std::endl;
+        throw std::runtime_error(error_message.str());
+      }
+    }
+
+    preparedSQL.checkDone(sqlite3_step(preparedSQL));
+    replacedCount += rowsCount;
+  }
+}
+
+void removeAllEntities(
+    SQLiteConnectionManager &connectionManager,
+    const std::string &removeAllEntitiesSQL) {
   SQLiteStatementWrapper preparedSQL(
-      db, removeAllEntitiesSQL, "Failed to remove all entities.");
-  sqlite3_step(preparedSQL);
+      connectionManager,
+      removeAllEntitiesSQL,
+      "Failed to remove all entities.");
+  preparedSQL.checkDone(sqlite3_step(preparedSQL));
 }
 
 void removeEntitiesByKeys(
-    sqlite3 *db,
-    std::string removeEntitiesByKeysSQL,
+    SQLiteConnectionManager &connectionManager,
+    const std::string &removeEntitiesByKeysSQLPrefix,
     const std::vector<std::string> &keys) {
-  SQLiteStatementWrapper preparedSQL(
-      db, removeEntitiesByKeysSQL, "Failed to remove entities by keys.");
-  for (int i = 0; i < keys.size(); i++) {
-    int bindResult = bindStringToSQL(keys[i], preparedSQL, i + 1);
-    if (bindResult != SQLITE_OK) {
-      std::stringstream error_message;
-      error_message << "Failed to bind key to SQL statement. Details: "
-                    << sqlite3_errstr(bindResult) << std::endl;
-      sqlite3_finalize(preparedSQL);
-      throw std::runtime_error(error_message.str());
+  if (keys.empty()) {
+    return;
+  }
+
+  if (keys.size() > maxInlineKeysCount) {
+    stageKeys(connectionManager, keys);
+    {
+      SQLiteStatementWrapper preparedSQL(
+          connectionManager,
+          getKeysTableSQL(removeEntitiesByKeysSQLPrefix),
+          "Failed to remove entities by keys.");
+      preparedSQL.checkDone(sqlite3_step(preparedSQL));
     }
+    clearKeysTable(connectionManager);
+    return;
   }
 
-  sqlite3_step(preparedSQL);
+  size_t placeholdersCount =
+      getKeysPlaceholdersCount(connectionManager, keys.size());
+  SQLiteStatementWrapper preparedSQL(
+      connectionManager,
+      getKeysSQL(removeEntitiesByKeysSQLPrefix, placeholdersCount),
+      "Failed to remove entities by keys.");
+  bindKeysToSQL(keys, preparedSQL, placeholdersCount);
+
+  preparedSQL.checkDone(sqlite3_step(preparedSQL));
 }
 
 void rekeyAllEntities(
-    sqlite3 *db,
-    std::string rekeyAllEntitiesSQL,
+    SQLiteConnectionManager &connectionManager,
+    const std::string &rekeyAllEntitiesSQL,
     std::string from,
     std::string to) {
   SQLiteStatementWrapper preparedSQL(
-      db, rekeyAllEntitiesSQL, "Failed to rekey all entities.");
+      connectionManager, rekeyAllEntitiesSQL, "Failed to rekey all entities.");
 
   bindStringToSQL(to, preparedSQL, 1);
   int bindResult = bindStringToSQL(from, preparedSQL, 2);
@@ -113,17 +372,7 @@ void rekeyAllEntities(
     throw std::runtime_error(error_message.str());
   }
 
-  sqlite3_step(preparedSQL);
-}
-
-std::string getSQLStatementArray(int length) {
-  std::stringstream array;
-  array << "(";
-  for (int i = 0; i < length - 1; i++) {
-    array << "?, ";
-  }
-  array << "?)";
-  return array.str();
+  preparedSQL.checkDone(sqlite3_step(preparedSQL));
 }
 
 void executeQuery(sqlite3 *db, std::string querySQL) {
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "SQLiteDataConverters.h"
+#include <sqlite3.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+namespace comm {
+
+// reading a column of a result row into an entity member
+inline void
+getColumnFromSQLRow(sqlite3_stmt *sqlRow, int idx, std::string &value) {
+  value.assign(getStringViewFromSQLRow(sqlRow, idx));
+}
+
+inline void getColumnFromSQLRow(
+    sqlite3_stmt *sqlRow,
+    int idx,
+    std::unique_ptr<std::string> &value) {
+  value = getStringPtrFromSQLRow(sqlRow, idx);
+}
+
+inline void getColumnFromSQLRow(sqlite3_stmt *sqlRow, int idx, int &value) {
+  value = getIntFromSQLRow(sqlRow, idx);
+}
+
+inline void getColumnFromSQLRow(
+    sqlite3_stmt *sqlRow,
+    int idx,
+    std::unique_ptr<int> &value) {
+  value = getIntPtrFromSQLRow(sqlRow, idx);
+}
+
+inline void getColumnFromSQLRow(sqlite3_stmt *sqlRow, int idx, int64_t &value) {
+  value = getInt64FromSQLRow(sqlRow, idx);
+}
+
+// binding an entity member to a statement parameter
+inline int
+bindColumnToSQL(const std::string &value, sqlite3_stmt *sql, int idx) {
+  return bindStringToSQL(value, sql, idx);
+}
+
+inline int bindColumnToSQL(
+    const std::unique_ptr<std::string> &value,
+    sqlite3_stmt *sql,
+    int idx) {
+  return bindStringPtrToSQL(value, sql, idx);
+}
+
+inline int bindColumnToSQL(int value, sqlite3_stmt *sql, int idx) {
+  return bindIntToSQL(value, sql, idx);
+}
+
+inline int
+bindColumnToSQL(const std::unique_ptr<int> &value, sqlite3_stmt *sql, int idx) {
+  return bindIntPtrToSQL(value, sql, idx);
+}
+
+inline int bindColumnToSQL(int64_t value, sqlite3_stmt *sql, int idx) {
+  return bindInt64ToSQL(value, sql, idx);
+}
+
+// SQL text of a length known up front, assembled at compile time.
+template <std::size_t N> class SQLText {
+  char text[N + 1]{};
+  std::size_t length{0};
+
+public:
+  constexpr void append(std::string_view part) {
+    for (char character : part) {
+      text[length++] = character;
+    }
+  }
+
+  constexpr std::string_view view() const {
+    return std::string_view(text, length);
+  }
+
+  std::string str() const {
+    return std::string(text, length);
+  }
+};
+
+template <typename T, typename Field> struct EntityColumn {
+  std::string_view name;
+  Field T::*member;
+};
+
+template <typename T, typename Field>
+constexpr EntityColumn<T, Field>
+entityColumn(std::string_view name, Field T::*member) {
+  return EntityColumn<T, Field>{name, member};
+}
+
+// Describes how an entity is stored: the table and, in order, its columns
+// together with the members they are read into and bound from. Column
+// indexes are derived from the position in the descriptor, so reading,
+// binding and the generated SQL can't disagree about them.
+template <typename T, typename... Fields> class EntitySchema {
+public:
+  static constexpr std::size_t columnsCount = sizeof...(Fields);
+
+  std::string_view table;
+  std::array<std::string_view, columnsCount> columnNames;
+  std::tuple<Fields T::*...> members;
+
+  constexpr EntitySchema(
+      std::string_view table,
+      EntityColumn<T, Fields>... columns)
+      : table{table},
+        columnNames{columns.name...},
+        members{columns.member...} {
+  }
+
+  T fromSQLResult(sqlite3_stmt *sqlRow, int idx) const {
+    T entity{};
+    this->getColumnsFromSQLRow(
+        entity, sqlRow, idx, std::index_sequence_for<Fields...>{});
+    return entity;
+  }
+
+  // Returns the result of the first failed bind, or SQLITE_OK.
+  int bindToSQL(const T &entity, sqlite3_stmt *sql, int idx) const {
+    return this->bindColumnsToSQL(
+        entity, sql, idx, std::index_sequence_for<Fields...>{});
+  }
+
+  // Calls `visit` with every member of the entity, in the columns order.
+  template <typename Entity, typename Visitor>
+  void forEachMember(Entity &entity, Visitor &&visit) const {
+    std::apply(
+        [&entity, &visit](auto... members) { (visit(entity.*members), ...); },
+        this->members);
+  }
+
+  // "id, local_id, ..."
+  constexpr std::size_t columnsListLength() const {
+    std::size_t length = 2 * (columnsCount - 1);
+    for (std::string_view name : columnNames) {
+      length += name.size();
+    }
+    return length;
+  }
+
+  template <std::size_t N>
+  constexpr void appendColumnsList(SQLText<N> &text) const {
+    for (std::size_t i = 0; i < columnsCount; i++) {
+      if (i) {
+        text.append(", ");
+      }
+      text.append(columnNames[i]);
+    }
+  }
+
+  // "(?, ?, ...)"
+  constexpr std::size_t rowPlaceholdersLength() const {
+    return 3 * columnsCount;
+  }
+
+  template <std::size_t N>
+  constexpr void appendRowPlaceholders(SQLText<N> &text) const {
+    text.append("(?");
+    for (std::size_t i = 1; i < columnsCount; i++) {
+      text.append(", ?");
+    }
+    text.append(")");
+  }
+
+private:
+  template <std::size_t... I>
+  void getColumnsFromSQLRow(
+      T &entity,
+      sqlite3_stmt *sqlRow,
+      int idx,
+      std::index_sequence<I...>) const {
+    (getColumnFromSQLRow(
+         sqlRow, idx + static_cast<int>(I), entity.*std::get<I>(members)),
+     ...);
+  }
+
+  template <std::size_t... I>
+  int bindColumnsToSQL(
+      const T &entity,
+      sqlite3_stmt *sql,
+      int idx,
+      std::index_sequence<I...>) const {
+    int bindResult = SQLITE_OK;
+    (((bindResult = bindColumnToSQL(
+           entity.*std::get<I>(members), sql, idx + static_cast<int>(I))) ==
+      SQLITE_OK) &&
+     ...);
+    return bindResult;
+  }
+};
+
+// Specialized next to every entity with a static constexpr `schema` member.
+template <typename T> struct EntitySchemaOf;
+
+// SQL text generated from the schema of an entity at compile time.
+template <typename T> class EntitySQL {
+  static constexpr const auto &schema = EntitySchemaOf<T>::schema;
+
+  static constexpr std::string_view replacePrefixStart = "REPLACE INTO ";
+  static constexpr std::string_view replacePrefixEnd = ") VALUES ";
+  static constexpr std::size_t replacePrefixLength = replacePrefixStart.size() +
+      schema.table.size() + 2 + schema.columnsListLength() +
+      replacePrefixEnd.size();
+
+  static constexpr auto replacePrefixText = [] {
+    SQLText<replacePrefixLength> text;
+    text.append(replacePrefixStart);
+    text.append(schema.table);
+    text.append(" (");
+    schema.appendColumnsList(text);
+    text.append(replacePrefixEnd);
+    return text;
+  }();
+
+  static constexpr auto rowPlaceholdersText = [] {
+    SQLText<schema.rowPlaceholdersLength()> text;
+    schema.appendRowPlaceholders(text);
+    return text;
+  }();
+
+  static constexpr auto replaceText = [] {
+    SQLText<replacePrefixLength + schema.rowPlaceholdersLength() + 1> text;
+    text.append(replacePrefixText.view());
+    text.append(rowPlaceholdersText.view());
+    text.append(";");
+    return text;
+  }();
+
+public:
+  static constexpr std::size_t columnsCount = schema.columnsCount;
+
+  // "REPLACE INTO table (id, ...) VALUES "
+  static const std::string &replacePrefix() {
+    static const std::string sql = replacePrefixText.str();
+    return sql;
+  }
+
+  // "(?, ?, ...)"
+  static const std::string &rowPlaceholders() {
+    static const std::string sql = rowPlaceholdersText.str();
+    return sql;
+  }
+
+  // "REPLACE INTO table (id, ...) VALUES (?, ...);"
+  static const std::string &replace() {
+    static const std::string sql = replaceText.str();
+    return sql;
+  }
+};
+
+} // namespace comm
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,24 @@ struct KeyserverInfo {
   std::string id;
   std::string keyserver_info;
 
-  static KeyserverInfo fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return KeyserverInfo{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static KeyserverInfo fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    return bindStringToSQL(keyserver_info, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<KeyserverInfo> {
+  static constexpr EntitySchema schema{
+      "keyservers",
+      entityColumn("id", &KeyserverInfo::id),
+      entityColumn("keyserver_info", &KeyserverInfo::keyserver_info)};
 };
 
+inline KeyserverInfo
+KeyserverInfo::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<KeyserverInfo>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int KeyserverInfo::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<KeyserverInfo>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
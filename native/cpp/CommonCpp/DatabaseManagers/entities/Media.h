@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -14,24 +14,27 @@ struct Media {
   std::string type;
   std::string extras;
 
-  static Media fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return Media{
-        getStringFromSQLRow(sqlRow, idx),
-        getStringFromSQLRow(sqlRow, idx + 1),
-        getStringFromSQLRow(sqlRow, idx + 2),
-        getStringFromSQLRow(sqlRow, idx + 3),
-        getStringFromSQLRow(sqlRow, idx + 4),
-        getStringFromSQLRow(sqlRow, idx + 5)};
-  }
-
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    bindStringToSQL(container, sql, idx + 1);
-    bindStringToSQL(thread, sql, idx + 2);
-    bindStringToSQL(uri, sql, idx + 3);
-    bindStringToSQL(type, sql, idx + 4);
-    return bindStringToSQL(extras, sql, idx + 5);
-  }
+  static Media fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
 };
 
+template <> struct EntitySchemaOf<Media> {
+  static constexpr EntitySchema schema{
+      "media",
+      entityColumn("id", &Media::id),
+      entityColumn("container", &Media::container),
+      entityColumn("thread", &Media::thread),
+      entityColumn("uri", &Media::uri),
+      entityColumn("type", &Media::type),
+      entityColumn("extras", &Media::extras)};
+};
+
+inline Media Media::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<Media>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int Media::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<Media>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "EntitySchema.h"
 #include "Media.h"
 #include "Nullable.h"
 #include <sqlite3.h>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace comm {
@@ -19,30 +21,31 @@ struct Message {
   std::unique_ptr<std::string> content;
   int64_t time;
 
-  static Message fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return Message{
-        getStringFromSQLRow(sqlRow, idx),
-        getStringPtrFromSQLRow(sqlRow, idx + 1),
-        getStringFromSQLRow(sqlRow, idx + 2),
-        getStringFromSQLRow(sqlRow, idx + 3),
-        getIntFromSQLRow(sqlRow, idx + 4),
-        getIntPtrFromSQLRow(sqlRow, idx + 5),
-        getStringPtrFromSQLRow(sqlRow, idx + 6),
-        getInt64FromSQLRow(sqlRow, idx + 7)};
-  }
+  static Message fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    bindStringPtrToSQL(local_id, sql, idx + 1);
-    bindStringToSQL(thread, sql, idx + 2);
-    bindStringToSQL(user, sql, idx + 3);
-    bindIntToSQL(type, sql, idx + 4);
-    bindIntPtrToSQL(future_type, sql, idx + 5);
-    bindStringPtrToSQL(content, sql, idx + 6);
-    return bindInt64ToSQL(time, sql, idx + 7);
-  }
+template <> struct EntitySchemaOf<Message> {
+  static constexpr EntitySchema schema{
+      "messages",
+      entityColumn("id", &Message::id),
+      entityColumn("local_id", &Message::local_id),
+      entityColumn("thread", &Message::thread),
+      entityColumn("user", &Message::user),
+      entityColumn("type", &Message::type),
+      entityColumn("future_type", &Message::future_type),
+      entityColumn("content", &Message::content),
+      entityColumn("time", &Message::time)};
 };
 
+inline Message Message::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<Message>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int Message::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<Message>::schema.bindToSQL(*this, sql, idx);
+}
+
 struct WebMessage {
   std::string id;
   NullableString local_id;
@@ -80,6 +83,8 @@ struct WebMessage {
   }
 };
 
+using MessageEntity = std::pair<Message, std::vector<Media>>;
+
 struct MessageWithMedias {
   WebMessage message;
   std::vector<Media> medias;
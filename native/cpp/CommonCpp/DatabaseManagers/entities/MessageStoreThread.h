@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,17 +10,24 @@ struct MessageStoreThread {
   std::string id;
   int start_reached;
 
-  static MessageStoreThread fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return MessageStoreThread{
-        getStringFromSQLRow(sqlRow, idx),
-        getIntFromSQLRow(sqlRow, idx + 1),
-    };
-  }
-
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    return bindIntToSQL(start_reached, sql, idx + 1);
-  }
+  static MessageStoreThread fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
 };
 
+template <> struct EntitySchemaOf<MessageStoreThread> {
+  static constexpr EntitySchema schema{
+      "message_store_threads",
+      entityColumn("id", &MessageStoreThread::id),
+      entityColumn("start_reached", &MessageStoreThread::start_reached)};
+};
+
+inline MessageStoreThread
+MessageStoreThread::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<MessageStoreThread>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int MessageStoreThread::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<MessageStoreThread>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,23 @@ struct Metadata {
   std::string name;
   std::string data;
 
-  static Metadata fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return Metadata{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static Metadata fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(name, sql, idx);
-    return bindStringToSQL(data, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<Metadata> {
+  static constexpr EntitySchema schema{
+      "metadata",
+      entityColumn("name", &Metadata::name),
+      entityColumn("data", &Metadata::data)};
 };
 
+inline Metadata Metadata::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<Metadata>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int Metadata::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<Metadata>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
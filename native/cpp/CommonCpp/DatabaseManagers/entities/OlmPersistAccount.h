@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,24 @@ struct OlmPersistAccount {
   int id;
   std::string account_data;
 
-  static OlmPersistAccount fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return OlmPersistAccount{
-        getIntFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static OlmPersistAccount fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindIntToSQL(id, sql, idx);
-    return bindStringToSQL(account_data, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<OlmPersistAccount> {
+  static constexpr EntitySchema schema{
+      "olm_persist_account",
+      entityColumn("id", &OlmPersistAccount::id),
+      entityColumn("account_data", &OlmPersistAccount::account_data)};
 };
 
+inline OlmPersistAccount
+OlmPersistAccount::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<OlmPersistAccount>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int OlmPersistAccount::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<OlmPersistAccount>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,24 @@ struct OlmPersistSession {
   std::string target_user_id;
   std::string session_data;
 
-  static OlmPersistSession fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return OlmPersistSession{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static OlmPersistSession fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(target_user_id, sql, idx);
-    return bindStringToSQL(session_data, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<OlmPersistSession> {
+  static constexpr EntitySchema schema{
+      "olm_persist_sessions",
+      entityColumn("target_user_id", &OlmPersistSession::target_user_id),
+      entityColumn("session_data", &OlmPersistSession::session_data)};
 };
 
+inline OlmPersistSession
+OlmPersistSession::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<OlmPersistSession>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int OlmPersistSession::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<OlmPersistSession>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
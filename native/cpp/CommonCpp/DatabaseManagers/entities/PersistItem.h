@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,23 @@ struct PersistItem {
   std::string key;
   std::string item;
 
-  static PersistItem fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return PersistItem{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static PersistItem fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(key, sql, idx);
-    return bindStringToSQL(item, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<PersistItem> {
+  static constexpr EntitySchema schema{
+      "persist_storage",
+      entityColumn("key", &PersistItem::key),
+      entityColumn("item", &PersistItem::item)};
 };
 
+inline PersistItem PersistItem::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<PersistItem>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int PersistItem::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<PersistItem>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,23 @@ struct Report {
   std::string id;
   std::string report;
 
-  static Report fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return Report{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  }
+  static Report fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    return bindStringToSQL(report, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<Report> {
+  static constexpr EntitySchema schema{
+      "reports",
+      entityColumn("id", &Report::id),
+      entityColumn("report", &Report::report)};
 };
 
+inline Report Report::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<Report>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int Report::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<Report>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -2,7 +2,7 @@
 
 namespace comm {
 std::string getStringFromSQLRow(sqlite3_stmt *sqlRow, int idx) {
-  return reinterpret_cast<const char *>(sqlite3_column_text(sqlRow, idx));
+  return std::string(getStringViewFromSQLRow(sqlRow, idx));
 }
 
 int getIntFromSQLRow(sqlite3_stmt *sqlRow, int idx) {
@@ -16,7 +16,8 @@ getStringPtrFromSQLRow(sqlite3_stmt *sqlRow, int idx) {
   if (!maybeString) {
     return nullptr;
   }
-  return std::make_unique<std::string>(maybeString);
+  return std::make_unique<std::string>(
+      maybeString, sqlite3_column_bytes(sqlRow, idx));
 }
 
 std::unique_ptr<int> getIntPtrFromSQLRow(sqlite3_stmt *sqlRow, int idx) {
@@ -30,8 +31,20 @@ int64_t getInt64FromSQLRow(sqlite3_stmt *sqlRow, int idx) {
   return sqlite3_column_int64(sqlRow, idx);
 }
 
+std::string_view getStringViewFromSQLRow(sqlite3_stmt *sqlRow, int idx) {
+  // sqlite3_column_bytes has to be called after sqlite3_column_text, since
+  // the latter may convert the value and invalidate the length
+  const char *data =
+      reinterpret_cast<const char *>(sqlite3_column_text(sqlRow, idx));
+  if (!data) {
+    return std::string_view();
+  }
+  return std::string_view(data, sqlite3_column_bytes(sqlRow, idx));
+}
+
 int bindStringToSQL(const std::string &data, sqlite3_stmt *sql, int idx) {
-  return sqlite3_bind_text(sql, idx, data.c_str(), -1, SQLITE_TRANSIENT);
+  return sqlite3_bind_text(
+      sql, idx, data.c_str(), data.size(), SQLITE_STATIC);
 }
 
 int bindStringPtrToSQL(
@@ -41,7 +54,8 @@ int bindStringPtrToSQL(
   if (data == nullptr) {
     return sqlite3_bind_null(sql, idx);
   }
-  return sqlite3_bind_text(sql, idx, data->c_str(), -1, SQLITE_TRANSIENT);
+  return sqlite3_bind_text(
+      sql, idx, data->c_str(), data->size(), SQLITE_STATIC);
 }
 
 int bindIntToSQL(int data, sqlite3_stmt *sql, int idx) {
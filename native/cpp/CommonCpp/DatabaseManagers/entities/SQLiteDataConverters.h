@@ -3,6 +3,7 @@
 #include <sqlite3.h>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace comm {
 // getting data from SQL statement result row
@@ -12,8 +13,13 @@ std::unique_ptr<std::string>
 getStringPtrFromSQLRow(sqlite3_stmt *sqlRow, int idx);
 std::unique_ptr<int> getIntPtrFromSQLRow(sqlite3_stmt *sqlRow, int idx);
 int64_t getInt64FromSQLRow(sqlite3_stmt *sqlRow, int idx);
+// The view points into memory owned by the statement, so it is only valid
+// until the statement is stepped, reset or finalized. NULL reads as empty.
+std::string_view getStringViewFromSQLRow(sqlite3_stmt *sqlRow, int idx);
 
 // binding data to SQL statement
+// Strings are bound without being copied, so they have to outlive the
+// execution of the statement (until it is reset or finalized).
 int bindStringToSQL(const std::string &data, sqlite3_stmt *sql, int idx);
 int bindStringPtrToSQL(
     const std::unique_ptr<std::string> &data,
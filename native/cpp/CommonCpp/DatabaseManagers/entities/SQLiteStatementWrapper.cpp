@@ -1,4 +1,5 @@
 #include "SQLiteStatementWrapper.h"
+#include "../SQLiteConnectionManager.h"
 
 #include <sstream>
 #include <stdexcept>
@@ -7,8 +8,11 @@
 namespace comm {
 SQLiteStatementWrapper::SQLiteStatementWrapper(
     sqlite3 *db,
-    std::string sql,
-    std::string onLastStepFailureMessage) {
+    const std::string &sql,
+    const char *onLastStepFailureMessage)
+    : onLastStepFailureMessage(onLastStepFailureMessage),
+      connectionManager(nullptr),
+      cacheKey(nullptr) {
   int prepareSQLResult =
       sqlite3_prepare_v2(db, sql.c_str(), -1, &preparedSQLPtr, nullptr);
 
@@ -18,21 +22,38 @@ SQLiteStatementWrapper::SQLiteStatementWrapper(
                   << sqlite3_errstr(prepareSQLResult) << std::endl;
     throw std::runtime_error(error_message.str());
   }
-  onLastStepFailureMessage = onLastStepFailureMessage;
+}
+
+SQLiteStatementWrapper::SQLiteStatementWrapper(
+    SQLiteConnectionManager &connectionManager,
+    const std::string &sql,
+    const char *onLastStepFailureMessage)
+    : onLastStepFailureMessage(onLastStepFailureMessage),
+      connectionManager(&connectionManager) {
+  preparedSQLPtr =
+      connectionManager.acquirePreparedStatement(sql, this->cacheKey);
 }
 
 SQLiteStatementWrapper::~SQLiteStatementWrapper() {
-  int lastStepResult = sqlite3_finalize(preparedSQLPtr);
-  if (lastStepResult != SQLITE_OK) {
-    std::stringstream error_message;
-    error_message << onLastStepFailureMessage
-                  << " Details: " << sqlite3_errstr(lastStepResult)
-                  << std::endl;
-    throw std::runtime_error(error_message.str());
+  if (connectionManager) {
+    sqlite3_reset(preparedSQLPtr);
+    connectionManager->releasePreparedStatement(cacheKey, preparedSQLPtr);
+  } else {
+    sqlite3_finalize(preparedSQLPtr);
   }
 }
 
 SQLiteStatementWrapper::operator sqlite3_stmt *() {
   return preparedSQLPtr;
 }
+
+void SQLiteStatementWrapper::checkDone(int stepResult) {
+  if (stepResult == SQLITE_DONE) {
+    return;
+  }
+  std::stringstream error_message;
+  error_message << onLastStepFailureMessage
+                << " Details: " << sqlite3_errstr(stepResult) << std::endl;
+  throw std::runtime_error(error_message.str());
+}
 } // namespace comm
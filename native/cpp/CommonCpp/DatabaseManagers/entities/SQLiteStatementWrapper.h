@@ -4,18 +4,32 @@
 #include <string>
 
 namespace comm {
+class SQLiteConnectionManager;
+
 class SQLiteStatementWrapper {
 private:
   sqlite3_stmt *preparedSQLPtr;
-  std::string onLastStepFailureMessage;
+  const char *onLastStepFailureMessage;
+  // set only for statements borrowed from the connection statement cache
+  SQLiteConnectionManager *connectionManager;
+  // key of the cache entry the statement belongs to, owned by the cache
+  const std::string *cacheKey;
 
 public:
   SQLiteStatementWrapper(
       sqlite3 *db,
-      std::string sql,
-      std::string onLastStepFailureMessage);
+      const std::string &sql,
+      const char *onLastStepFailureMessage);
+  SQLiteStatementWrapper(
+      SQLiteConnectionManager &connectionManager,
+      const std::string &sql,
+      const char *onLastStepFailureMessage);
   SQLiteStatementWrapper(const SQLiteStatementWrapper &) = delete;
   ~SQLiteStatementWrapper();
   operator sqlite3_stmt *();
+  // Throws unless the step ran the statement to completion. Steps that fail,
+  // e.g. because the statement was interrupted, have to be reported this way,
+  // as the wrapper doesn't check the statement when it's destroyed.
+  void checkDone(int stepResult);
 };
 } // namespace comm
@@ -4,8 +4,8 @@
 #include <memory>
 #include <string>
 
+#include "EntitySchema.h"
 #include "Nullable.h"
-#include "SQLiteDataConverters.h"
 
 namespace comm {
 
@@ -27,47 +27,39 @@ struct Thread {
   std::unique_ptr<std::string> avatar;
   int pinned_count;
 
-  static Thread fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return Thread{
-        getStringFromSQLRow(sqlRow, idx),
-        getIntFromSQLRow(sqlRow, idx + 1),
-        getStringPtrFromSQLRow(sqlRow, idx + 2),
-        getStringPtrFromSQLRow(sqlRow, idx + 3),
-        getStringFromSQLRow(sqlRow, idx + 4),
-        getInt64FromSQLRow(sqlRow, idx + 5),
-        getStringPtrFromSQLRow(sqlRow, idx + 6),
-        getStringPtrFromSQLRow(sqlRow, idx + 7),
-        getStringPtrFromSQLRow(sqlRow, idx + 8),
-        getStringFromSQLRow(sqlRow, idx + 9),
-        getStringFromSQLRow(sqlRow, idx + 10),
-        getStringFromSQLRow(sqlRow, idx + 11),
-        getStringPtrFromSQLRow(sqlRow, idx + 12),
-        getIntFromSQLRow(sqlRow, idx + 13),
-        getStringPtrFromSQLRow(sqlRow, idx + 14),
-        getIntFromSQLRow(sqlRow, idx + 15),
-    };
-  }
+  static Thread fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    bindIntToSQL(type, sql, idx + 1);
-    bindStringPtrToSQL(name, sql, idx + 2);
-    bindStringPtrToSQL(description, sql, idx + 3);
-    bindStringToSQL(color, sql, idx + 4);
-    bindInt64ToSQL(reinterpret_cast<sqlite3_int64>(time), sql, idx + 5);
-    bindStringPtrToSQL(parent_thread_id, sql, idx + 6);
-    bindStringPtrToSQL(containing_thread_id, sql, idx + 7);
-    bindStringPtrToSQL(community, sql, idx + 8);
-    bindStringToSQL(members, sql, idx + 9);
-    bindStringToSQL(roles, sql, idx + 10);
-    bindStringToSQL(current_user, sql, idx + 11);
-    bindStringPtrToSQL(source_message_id, sql, idx + 12);
-    bindIntToSQL(replies_count, sql, idx + 13);
-    bindStringPtrToSQL(avatar, sql, idx + 14);
-    return bindIntToSQL(pinned_count, sql, idx + 15);
-  }
+template <> struct EntitySchemaOf<Thread> {
+  static constexpr EntitySchema schema{
+      "threads",
+      entityColumn("id", &Thread::id),
+      entityColumn("type", &Thread::type),
+      entityColumn("name", &Thread::name),
+      entityColumn("description", &Thread::description),
+      entityColumn("color", &Thread::color),
+      entityColumn("creation_time", &Thread::creation_time),
+      entityColumn("parent_thread_id", &Thread::parent_thread_id),
+      entityColumn("containing_thread_id", &Thread::containing_thread_id),
+      entityColumn("community", &Thread::community),
+      entityColumn("members", &Thread::members),
+      entityColumn("roles", &Thread::roles),
+      entityColumn("current_user", &Thread::current_user),
+      entityColumn("source_message_id", &Thread::source_message_id),
+      entityColumn("replies_count", &Thread::replies_count),
+      entityColumn("avatar", &Thread::avatar),
+      entityColumn("pinned_count", &Thread::pinned_count)};
 };
 
+inline Thread Thread::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<Thread>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int Thread::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<Thread>::schema.bindToSQL(*this, sql, idx);
+}
+
 struct WebThread {
   std::string id;
   int type;
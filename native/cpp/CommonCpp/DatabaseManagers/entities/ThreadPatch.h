@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Nullable.h"
+
+namespace comm {
+
+// Changes to the JSON columns of a thread, applied in place by a single
+// UPDATE. `current_user` and `roles` are JSON merge patches (RFC 7396) of the
+// respective columns, so fields they leave out keep their values, while
+// fields set to null are removed rather than set to null. `members` is a JSON
+// object mapping member IDs to merge patches of those members, and members
+// missing from the thread are not added. Columns without a patch are left as
+// they are.
+struct ThreadPatch {
+  std::string id;
+  std::unique_ptr<std::string> current_user;
+  std::unique_ptr<std::string> roles;
+  std::unique_ptr<std::string> members;
+};
+
+struct WebThreadPatch {
+  std::string id;
+  NullableString current_user;
+  NullableString roles;
+  NullableString members;
+
+  ThreadPatch toThreadPatch() const {
+    ThreadPatch patch;
+    patch.id = id;
+    patch.current_user = current_user.resetValue();
+    patch.roles = roles.resetValue();
+    patch.members = members.resetValue();
+    return patch;
+  }
+};
+
+} // namespace comm
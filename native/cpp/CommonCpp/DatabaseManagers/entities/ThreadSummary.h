@@ -0,0 +1,57 @@
+#pragma once
+
+#include "EntitySchema.h"
+#include <sqlite3.h>
+#include <string>
+
+namespace comm {
+
+struct ThreadSummary {
+  std::string thread;
+  std::string last_message_id;
+  int64_t last_message_time;
+  int last_message_type;
+  int messages_count;
+
+  static ThreadSummary fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
+
+template <> struct EntitySchemaOf<ThreadSummary> {
+  static constexpr EntitySchema schema{
+      "thread_summaries",
+      entityColumn("thread", &ThreadSummary::thread),
+      entityColumn("last_message_id", &ThreadSummary::last_message_id),
+      entityColumn("last_message_time", &ThreadSummary::last_message_time),
+      entityColumn("last_message_type", &ThreadSummary::last_message_type),
+      entityColumn("messages_count", &ThreadSummary::messages_count)};
+};
+
+inline ThreadSummary
+ThreadSummary::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<ThreadSummary>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int ThreadSummary::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<ThreadSummary>::schema.bindToSQL(*this, sql, idx);
+}
+
+struct WebThreadSummary {
+  std::string thread;
+  std::string last_message_id;
+  std::string last_message_time;
+  int last_message_type;
+  int messages_count;
+
+  WebThreadSummary() = default;
+
+  WebThreadSummary(const ThreadSummary &summary) {
+    thread = summary.thread;
+    last_message_id = summary.last_message_id;
+    last_message_time = std::to_string(summary.last_message_time);
+    last_message_type = summary.last_message_type;
+    messages_count = summary.messages_count;
+  }
+};
+
+} // namespace comm
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SQLiteDataConverters.h"
+#include "EntitySchema.h"
 #include <sqlite3.h>
 #include <string>
 
@@ -10,15 +10,23 @@ struct UserInfo {
   std::string id;
   std::string user_info;
 
-  static UserInfo fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
-    return UserInfo{
-        getStringFromSQLRow(sqlRow, idx), getStringFromSQLRow(sqlRow, idx + 1)};
-  };
+  static UserInfo fromSQLResult(sqlite3_stmt *sqlRow, int idx);
+  int bindToSQL(sqlite3_stmt *sql, int idx) const;
+};
 
-  int bindToSQL(sqlite3_stmt *sql, int idx) const {
-    bindStringToSQL(id, sql, idx);
-    return bindStringToSQL(user_info, sql, idx + 1);
-  }
+template <> struct EntitySchemaOf<UserInfo> {
+  static constexpr EntitySchema schema{
+      "users",
+      entityColumn("id", &UserInfo::id),
+      entityColumn("user_info", &UserInfo::user_info)};
 };
 
+inline UserInfo UserInfo::fromSQLResult(sqlite3_stmt *sqlRow, int idx) {
+  return EntitySchemaOf<UserInfo>::schema.fromSQLResult(sqlRow, idx);
+}
+
+inline int UserInfo::bindToSQL(sqlite3_stmt *sql, int idx) const {
+  return EntitySchemaOf<UserInfo>::schema.bindToSQL(*this, sql, idx);
+}
+
 } // namespace comm
@@ -0,0 +1,94 @@
+#include "AESCrypto.h"
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace comm {
+
+// Same layout as on the devices: AES-256-GCM, with the IV prepended and the
+// tag appended to the ciphertext.
+const int KEY_LENGTH = 32;
+const int IV_LENGTH = 12;
+const int TAG_LENGTH = 16;
+
+using CipherContext =
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)>;
+
+CipherContext createCipherContext(std::size_t keySize) {
+  if (keySize != KEY_LENGTH) {
+    throw std::runtime_error("Invalid AES key length.");
+  }
+  CipherContext context(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+  if (!context) {
+    throw std::runtime_error("Failed to create AES cipher context.");
+  }
+  return context;
+}
+
+template <typename T> void AESCrypto<T>::generateKey(T buffer) {
+  if (RAND_bytes(buffer.data(), buffer.size()) != 1) {
+    throw std::runtime_error("Failed to generate AES key.");
+  }
+}
+
+template <typename T>
+void AESCrypto<T>::encrypt(T key, T plaintext, T sealedData) {
+  if (sealedData.size() != plaintext.size() + IV_LENGTH + TAG_LENGTH) {
+    throw std::runtime_error("Invalid AES sealed data length.");
+  }
+  CipherContext context = createCipherContext(key.size());
+  std::uint8_t *iv = sealedData.data();
+  std::uint8_t *ciphertext = iv + IV_LENGTH;
+  std::uint8_t *tag = ciphertext + plaintext.size();
+  int length;
+  if (RAND_bytes(iv, IV_LENGTH) != 1 ||
+      EVP_EncryptInit_ex(
+          context.get(), EVP_aes_256_gcm(), nullptr, key.data(), iv) != 1 ||
+      EVP_EncryptUpdate(
+          context.get(),
+          ciphertext,
+          &length,
+          plaintext.data(),
+          plaintext.size()) != 1 ||
+      EVP_EncryptFinal_ex(context.get(), ciphertext + length, &length) != 1 ||
+      EVP_CIPHER_CTX_ctrl(
+          context.get(), EVP_CTRL_GCM_GET_TAG, TAG_LENGTH, tag) != 1) {
+    throw std::runtime_error("AES encryption failed.");
+  }
+}
+
+template <typename T>
+void AESCrypto<T>::decrypt(T key, T sealedData, T plaintext) {
+  if (sealedData.size() != plaintext.size() + IV_LENGTH + TAG_LENGTH) {
+    throw std::runtime_error("Invalid AES plaintext length.");
+  }
+  CipherContext context = createCipherContext(key.size());
+  std::uint8_t *iv = sealedData.data();
+  std::uint8_t *ciphertext = iv + IV_LENGTH;
+  std::uint8_t *tag = ciphertext + plaintext.size();
+  int length;
+  if (EVP_DecryptInit_ex(
+          context.get(), EVP_aes_256_gcm(), nullptr, key.data(), iv) != 1 ||
+      EVP_DecryptUpdate(
+          context.get(),
+          plaintext.data(),
+          &length,
+          ciphertext,
+          plaintext.size()) != 1 ||
+      EVP_CIPHER_CTX_ctrl(
+          context.get(), EVP_CTRL_GCM_SET_TAG, TAG_LENGTH, tag) != 1 ||
+      EVP_DecryptFinal_ex(context.get(), plaintext.data() + length, &length) !=
+          1) {
+    throw std::runtime_error("AES decryption failed.");
+  }
+}
+
+template class AESCrypto<rust::Slice<uint8_t>>;
+template class AESCrypto<std::vector<std::uint8_t> &>;
+
+} // namespace comm
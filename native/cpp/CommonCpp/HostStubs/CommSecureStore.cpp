@@ -0,0 +1,27 @@
+#include "CommSecureStore.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace comm {
+
+// Benchmarks and tests always start from a fresh database, so keys don't
+// have to outlive the process.
+std::mutex secureStoreMutex;
+std::unordered_map<std::string, std::string> secureStore;
+
+void CommSecureStore::set(const std::string key, const std::string value) {
+  std::lock_guard<std::mutex> lock(secureStoreMutex);
+  secureStore[key] = value;
+}
+
+folly::Optional<std::string> CommSecureStore::get(const std::string key) {
+  std::lock_guard<std::mutex> lock(secureStoreMutex);
+  auto it = secureStore.find(key);
+  if (it == secureStore.end()) {
+    return folly::none;
+  }
+  return it->second;
+}
+
+} // namespace comm
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+
+namespace comm {
+
+// Everything the benchmarks and tests write is kept in a single directory,
+// which can be put on the same kind of storage as the devices' by setting
+// COMM_HOST_DATA_DIR.
+inline std::filesystem::path getHostDataDirectory() {
+  const char *dataDirectory = std::getenv("COMM_HOST_DATA_DIR");
+  std::filesystem::path path = dataDirectory
+      ? std::filesystem::path(dataDirectory)
+      : std::filesystem::temp_directory_path() / "comm-host";
+  std::filesystem::create_directories(path);
+  return path;
+}
+
+} // namespace comm
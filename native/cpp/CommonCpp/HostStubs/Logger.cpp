@@ -0,0 +1,11 @@
+#include <Tools/Logger.h>
+
+#include <iostream>
+
+namespace comm {
+
+void Logger::log(const std::string str) {
+  std::cerr << "COMM: " << str << std::endl;
+}
+
+} // namespace comm
@@ -0,0 +1,70 @@
+#include <Tools/PlatformSpecificTools.h>
+
+#include "HostDataDirectory.h"
+
+#include <openssl/rand.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+namespace comm {
+
+std::filesystem::path getBackupDirectory() {
+  std::filesystem::path path = getHostDataDirectory() / "backup";
+  std::filesystem::create_directories(path);
+  return path;
+}
+
+void PlatformSpecificTools::generateSecureRandomBytes(
+    crypto::OlmBuffer &buffer,
+    size_t size) {
+  buffer.resize(size);
+  if (RAND_bytes(buffer.data(), size) != 1) {
+    throw std::runtime_error("Failed to generate secure random bytes.");
+  }
+}
+
+std::string PlatformSpecificTools::getDeviceOS() {
+  return std::string{"host"};
+}
+
+std::string PlatformSpecificTools::getNotificationsCryptoAccountPath() {
+  return getHostDataDirectory() / "comm_notifications_crypto_account";
+}
+
+std::string PlatformSpecificTools::getBackupDirectoryPath() {
+  return getBackupDirectory();
+}
+
+std::string PlatformSpecificTools::getBackupFilePath(
+    std::string backupID,
+    bool isAttachments) {
+  std::string filename = "backup-" + backupID;
+  if (isAttachments) {
+    filename += "-attachments";
+  }
+  return getBackupDirectory() / filename;
+}
+
+std::string PlatformSpecificTools::getBackupLogFilePath(
+    std::string backupID,
+    std::string logID,
+    bool isAttachments) {
+  std::string filename = "backup-" + backupID + "-log-" + logID;
+  if (isAttachments) {
+    filename += "-attachments";
+  }
+  return getBackupDirectory() / filename;
+}
+
+std::string
+PlatformSpecificTools::getBackupUserKeysFilePath(std::string backupID) {
+  return getBackupDirectory() / ("backup-" + backupID + "-userkeys");
+}
+
+void PlatformSpecificTools::removeBackupDirectory() {
+  std::filesystem::remove_all(getHostDataDirectory() / "backup");
+}
+
+} // namespace comm
@@ -0,0 +1,11 @@
+#include <Tools/StaffUtils.h>
+
+namespace comm {
+
+// Host builds behave like staff builds, so that staff-only code paths such
+// as backup logs can be benchmarked and tested.
+bool StaffUtils::isStaffRelease() {
+  return true;
+}
+
+} // namespace comm
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+// Host builds don't link the Rust library, so instead of the header generated
+// by the cxx bridge, only the parts of it used by the C++ libraries are
+// provided here.
+namespace rust {
+inline namespace cxxbridge1 {
+
+template <typename T> class Slice final {
+  T *ptr;
+  std::size_t len;
+
+public:
+  Slice() noexcept : ptr(nullptr), len(0) {
+  }
+  Slice(T *ptr, std::size_t len) noexcept : ptr(ptr), len(len) {
+  }
+
+  T *data() const noexcept {
+    return this->ptr;
+  }
+  std::size_t size() const noexcept {
+    return this->len;
+  }
+  std::size_t length() const noexcept {
+    return this->len;
+  }
+  bool empty() const noexcept {
+    return this->len == 0;
+  }
+  T &operator[](std::size_t n) const noexcept {
+    return this->ptr[n];
+  }
+  T *begin() const noexcept {
+    return this->ptr;
+  }
+  T *end() const noexcept {
+    return this->ptr + this->len;
+  }
+};
+
+} // namespace cxxbridge1
+} // namespace rust
@@ -1,17 +1,32 @@
 #include "CommCoreModule.h"
 #include "../Notifications/BackgroundDataStorage/NotificationsCryptoModule.h"
+#include "../Tools/TaskTelemetry.h"
 #include "BaseDataStore.h"
 #include "CommServicesAuthMetadataEmitter.h"
 #include "DatabaseManager.h"
+#include "InternalModules/ClientDBStoreSnapshotWriter.h"
+#include "InternalModules/DatabaseMaintenanceScheduler.h"
 #include "InternalModules/GlobalDBSingleton.h"
+#include "InternalModules/MessageSearchIndexer.h"
 #include "InternalModules/RustPromiseManager.h"
+#include "Logger.h"
 #include "NativeModuleUtils.h"
+#include "SQLiteProfiler.h"
+#include "StoreOperationCompaction.h"
 #include "TerminateApp.h"
 
 #include <ReactCommon/TurboModuleUtils.h>
 #include <folly/dynamic.h>
 #include <folly/json.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
 #include <future>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 #include "JSIRust.h"
 #include "lib.rs.h"
@@ -22,18 +37,22 @@ namespace comm {
 using namespace facebook::react;
 
 jsi::Value CommCoreModule::getDraft(jsi::Runtime &rt, jsi::String key) {
+  TaskLabelScope taskLabelScope(__func__);
   std::string keyStr = key.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string draftStr;
           try {
             draftStr = DatabaseManager::getQueryExecutor().getDraft(keyStr);
-          } catch (std::system_error &e) {
+          } catch (const std::exception &e) {
             error = e.what();
           }
-          this->jsInvoker_->invokeAsync([=, &innerRt]() {
+          this->jsInvoker_->invokeAsync([&innerRt,
+                                         error = std::move(error),
+                                         draftStr = std::move(draftStr),
+                                         promise]() {
             if (error.size()) {
               promise->reject(error);
               return;
@@ -42,8 +61,12 @@ jsi::Value CommCoreModule::getDraft(jsi::Runtime &rt, jsi::String key) {
             promise->resolve(std::move(draft));
           });
         };
-        GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job),
+            promise,
+            this->jsInvoker_,
+            nullptr,
+            ReadOrdering::AFTER_SCHEDULED_WRITES);
       });
 }
 
@@ -51,15 +74,19 @@ jsi::Value CommCoreModule::updateDraft(
     jsi::Runtime &rt,
     jsi::String key,
     jsi::String text) {
+  TaskLabelScope taskLabelScope(__func__);
   std::string keyStr = key.utf8(rt);
   std::string textStr = text.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=]() {
+        Task job = [=]() {
           std::string error;
           try {
-            DatabaseManager::getQueryExecutor().updateDraft(keyStr, textStr);
-          } catch (std::system_error &e) {
+            const DatabaseQueryExecutor &queryExecutor =
+                DatabaseManager::getQueryExecutor();
+            queryExecutor.runInTransaction(
+                [&]() { queryExecutor.updateDraft(keyStr, textStr); });
+          } catch (const std::exception &e) {
             error = e.what();
           }
           this->jsInvoker_->invokeAsync([=]() {
@@ -71,7 +98,7 @@ jsi::Value CommCoreModule::updateDraft(
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
@@ -79,18 +106,22 @@ jsi::Value CommCoreModule::moveDraft(
     jsi::Runtime &rt,
     jsi::String oldKey,
     jsi::String newKey) {
+  TaskLabelScope taskLabelScope(__func__);
   std::string oldKeyStr = oldKey.utf8(rt);
   std::string newKeyStr = newKey.utf8(rt);
 
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=]() {
+        Task job = [=]() {
           std::string error;
           bool result = false;
           try {
-            result = DatabaseManager::getQueryExecutor().moveDraft(
-                oldKeyStr, newKeyStr);
-          } catch (std::system_error &e) {
+            const DatabaseQueryExecutor &queryExecutor =
+                DatabaseManager::getQueryExecutor();
+            queryExecutor.runInTransaction([&]() {
+              result = queryExecutor.moveDraft(oldKeyStr, newKeyStr);
+            });
+          } catch (const std::exception &e) {
             error = e.what();
           }
           this->jsInvoker_->invokeAsync([=]() {
@@ -102,63 +133,218 @@ jsi::Value CommCoreModule::moveDraft(
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::getClientDBStore(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
-          std::string error;
-          std::vector<Draft> draftsVector;
-          std::vector<Thread> threadsVector;
-          std::vector<std::pair<Message, std::vector<Media>>> messagesVector;
-          std::vector<MessageStoreThread> messageStoreThreadsVector;
-          std::vector<Report> reportStoreVector;
-          std::vector<UserInfo> userStoreVector;
-          std::vector<KeyserverInfo> keyserverStoreVector;
-          std::vector<CommunityInfo> communityStoreVector;
+        if (this->clientDBStoreCancellationToken == nullptr) {
+          this->clientDBStoreCancellationToken =
+              std::make_shared<CancellationToken>();
+        }
+        auto cancellationToken = this->clientDBStoreCancellationToken;
+        auto startTime = std::chrono::steady_clock::now();
+        // Each table is loaded by a single read, and all of them finish
+        // before they are handed over to the JS thread.
+        auto draftsVectorPtr = std::make_shared<std::vector<Draft>>();
+        auto threadsVectorPtr = std::make_shared<std::vector<Thread>>();
+        auto messageStoreThreadsVectorPtr =
+            std::make_shared<std::vector<MessageStoreThread>>();
+        auto reportStoreVectorPtr = std::make_shared<std::vector<Report>>();
+        auto userStoreVectorPtr = std::make_shared<std::vector<UserInfo>>();
+        auto keyserveStoreVectorPtr =
+            std::make_shared<std::vector<KeyserverInfo>>();
+        auto communityStoreVectorPtr =
+            std::make_shared<std::vector<CommunityInfo>>();
+        // Only ever accessed on the JS thread.
+        auto jsiMessagesVectorPtr =
+            std::make_shared<std::vector<jsi::Object>>();
+        auto errorPtr = std::make_shared<std::string>();
+        auto errorMutexPtr = std::make_shared<std::mutex>();
+        auto setError = [errorPtr, errorMutexPtr](std::string error) {
+          std::lock_guard<std::mutex> lock(*errorMutexPtr);
+          if (errorPtr->empty()) {
+            *errorPtr = std::move(error);
+          }
+        };
+        auto timedRead = [setError](std::string table, taskType read) {
+          return [setError, table, read]() {
+            auto readStartTime = std::chrono::steady_clock::now();
+            try {
+              read();
+            } catch (const std::exception &e) {
+              setError(e.what());
+              return;
+            }
+            auto readDuration =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - readStartTime);
+            Logger::log(
+                "getClientDBStore: loaded " + table + " in " +
+                std::to_string(readDuration.count()) + "ms");
+          };
+        };
+
+        // Tables are loaded in parallel by the read threads. Every write to
+        // the store bumps its generation, so reads only run in snapshots of
+        // the same generation, and the store is consistent.
+        openSnapshotType openSnapshot = [setError]() {
           try {
-            draftsVector = DatabaseManager::getQueryExecutor().getAllDrafts();
-            messagesVector =
-                DatabaseManager::getQueryExecutor().getAllMessages();
-            threadsVector = DatabaseManager::getQueryExecutor().getAllThreads();
-            messageStoreThreadsVector =
-                DatabaseManager::getQueryExecutor().getAllMessageStoreThreads();
-            reportStoreVector =
-                DatabaseManager::getQueryExecutor().getAllReports();
-            userStoreVector = DatabaseManager::getQueryExecutor().getAllUsers();
-            keyserverStoreVector =
-                DatabaseManager::getQueryExecutor().getAllKeyservers();
-            communityStoreVector =
-                DatabaseManager::getQueryExecutor().getAllCommunities();
-          } catch (std::system_error &e) {
-            error = e.what();
+            const DatabaseQueryExecutor &queryExecutor =
+                DatabaseManager::getQueryExecutor();
+            queryExecutor.beginReadTransaction();
+            return queryExecutor.getMetadata("client_db_store_generation");
+          } catch (const std::exception &e) {
+            setError(e.what());
           }
-          auto draftsVectorPtr =
-              std::make_shared<std::vector<Draft>>(std::move(draftsVector));
-          auto messagesVectorPtr = std::make_shared<
-              std::vector<std::pair<Message, std::vector<Media>>>>(
-              std::move(messagesVector));
-          auto threadsVectorPtr =
-              std::make_shared<std::vector<Thread>>(std::move(threadsVector));
-          auto messageStoreThreadsVectorPtr =
-              std::make_shared<std::vector<MessageStoreThread>>(
-                  std::move(messageStoreThreadsVector));
-          auto reportStoreVectorPtr = std::make_shared<std::vector<Report>>(
-              std::move(reportStoreVector));
-          auto userStoreVectorPtr = std::make_shared<std::vector<UserInfo>>(
-              std::move(userStoreVector));
-          auto keyserveStoreVectorPtr =
-              std::make_shared<std::vector<KeyserverInfo>>(
-                  std::move(keyserverStoreVector));
-          auto communityStoreVectorPtr =
-              std::make_shared<std::vector<CommunityInfo>>(
-                  std::move(communityStoreVector));
+          return std::string();
+        };
+        taskType closeSnapshot = [setError]() {
+          try {
+            DatabaseManager::getQueryExecutor().commitTransaction();
+          } catch (const std::exception &e) {
+            setError(e.what());
+          }
+        };
+        // Messages are the largest part of the store, so instead of
+        // materializing all of them at once they are handed over to the JS
+        // thread in chunks and converted to JS objects as they come. Reading
+        // waits while `maxPendingMessagesChunks` chunks are still to be
+        // converted, so a busy JS thread doesn't make them pile up. The JS
+        // thread may itself be blocked on a synchronous call waiting for the
+        // database, so if it doesn't catch up in time we stop waiting for it.
+        struct PendingMessagesChunks {
+          std::mutex mutex;
+          std::condition_variable condition;
+          std::size_t count = 0;
+          bool stalled = false;
+        };
+        auto pendingMessagesChunksPtr =
+            std::make_shared<PendingMessagesChunks>();
+        const auto jsThreadID = std::this_thread::get_id();
+        auto handOverMessages =
+            [=,
+             &innerRt,
+             maxPendingMessagesChunks = this->maxPendingMessagesChunks,
+             messageStore =
+                 this->messageStore](std::vector<MessageEntity> &&chunk) {
+              if (std::this_thread::get_id() == jsThreadID) {
+                // There is no database thread yet, so the read runs inline
+                // and can convert the chunk right away.
+                for (const auto &messageEntity : chunk) {
+                  jsiMessagesVectorPtr->push_back(
+                      messageStore.parseDBMessage(innerRt, messageEntity));
+                }
+                return;
+              }
+              {
+                std::unique_lock<std::mutex> lock(
+                    pendingMessagesChunksPtr->mutex);
+                bool consumed = pendingMessagesChunksPtr->stalled ||
+                    pendingMessagesChunksPtr->condition.wait_for(
+                        lock, std::chrono::seconds(1), [&]() {
+                          return pendingMessagesChunksPtr->count <
+                              maxPendingMessagesChunks;
+                        });
+                if (!consumed) {
+                  if (cancellationToken->isCancelled()) {
+                    throw std::runtime_error(
+                        "Loading messages was cancelled.");
+                  }
+                  Logger::log(
+                      "getClientDBStore: JS thread isn't consuming messages, "
+                      "handing over the rest without waiting");
+                  pendingMessagesChunksPtr->stalled = true;
+                }
+                pendingMessagesChunksPtr->count++;
+              }
+              auto chunkPtr = std::make_shared<std::vector<MessageEntity>>(
+                  std::move(chunk));
+              this->jsInvoker_->invokeAsync([&innerRt,
+                                             chunkPtr,
+                                             jsiMessagesVectorPtr,
+                                             pendingMessagesChunksPtr,
+                                             messageStore]() {
+                for (const auto &messageEntity : *chunkPtr) {
+                  jsiMessagesVectorPtr->push_back(
+                      messageStore.parseDBMessage(innerRt, messageEntity));
+                }
+                chunkPtr->clear();
+                {
+                  std::lock_guard<std::mutex> lock(
+                      pendingMessagesChunksPtr->mutex);
+                  pendingMessagesChunksPtr->count--;
+                }
+                pendingMessagesChunksPtr->condition.notify_all();
+              });
+            };
+        // Messages go first, as they take the longest to load.
+        std::vector<taskType> reads{
+            timedRead(
+                "messages",
+                [=]() {
+                  DatabaseManager::getQueryExecutor().getAllMessagesInChunks(
+                      this->messagesChunkSize, handOverMessages);
+                }),
+            timedRead(
+                "threads",
+                [threadsVectorPtr]() {
+                  *threadsVectorPtr =
+                      DatabaseManager::getQueryExecutor().getAllThreads();
+                }),
+            timedRead(
+                "drafts",
+                [draftsVectorPtr]() {
+                  *draftsVectorPtr =
+                      DatabaseManager::getQueryExecutor().getAllDrafts();
+                }),
+            timedRead(
+                "message store threads",
+                [messageStoreThreadsVectorPtr]() {
+                  *messageStoreThreadsVectorPtr =
+                      DatabaseManager::getQueryExecutor()
+                          .getAllMessageStoreThreads();
+                }),
+            timedRead(
+                "reports",
+                [reportStoreVectorPtr]() {
+                  *reportStoreVectorPtr =
+                      DatabaseManager::getQueryExecutor().getAllReports();
+                }),
+            timedRead(
+                "users",
+                [userStoreVectorPtr]() {
+                  *userStoreVectorPtr =
+                      DatabaseManager::getQueryExecutor().getAllUsers();
+                }),
+            timedRead(
+                "keyservers",
+                [keyserveStoreVectorPtr]() {
+                  *keyserveStoreVectorPtr =
+                      DatabaseManager::getQueryExecutor().getAllKeyservers();
+                }),
+            timedRead(
+                "communities",
+                [communityStoreVectorPtr]() {
+                  *communityStoreVectorPtr =
+                      DatabaseManager::getQueryExecutor().getAllCommunities();
+                }),
+        };
+
+        taskType onDone = [=, &innerRt]() {
+          std::string error = *errorPtr;
+          auto loadDuration =
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - startTime);
+          Logger::log(
+              "getClientDBStore: loaded all tables in " +
+              std::to_string(loadDuration.count()) + "ms");
           this->jsInvoker_->invokeAsync([&innerRt,
                                          draftsVectorPtr,
-                                         messagesVectorPtr,
+                                         jsiMessagesVectorPtr,
                                          threadsVectorPtr,
                                          messageStoreThreadsVectorPtr,
                                          reportStoreVectorPtr,
@@ -175,6 +361,9 @@ jsi::Value CommCoreModule::getClientDBStore(jsi::Runtime &rt) {
                                          keyserverStore = this->keyserverStore,
                                          communityStore =
                                              this->communityStore]() {
+            std::vector<jsi::Object> jsiMessagesVector =
+                std::move(*jsiMessagesVectorPtr);
+            jsiMessagesVectorPtr->clear();
             if (error.size()) {
               promise->reject(error);
               return;
@@ -182,7 +371,12 @@ jsi::Value CommCoreModule::getClientDBStore(jsi::Runtime &rt) {
             jsi::Array jsiDrafts =
                 draftStore.parseDBDataStore(innerRt, draftsVectorPtr);
             jsi::Array jsiMessages =
-                messageStore.parseDBDataStore(innerRt, messagesVectorPtr);
+                jsi::Array(innerRt, jsiMessagesVector.size());
+            size_t messageIndex = 0;
+            for (auto &jsiMessage : jsiMessagesVector) {
+              jsiMessages.setValueAtIndex(
+                  innerRt, messageIndex++, std::move(jsiMessage));
+            }
             jsi::Array jsiThreads =
                 threadStore.parseDBDataStore(innerRt, threadsVectorPtr);
             jsi::Array jsiMessageStoreThreads =
@@ -213,19 +407,79 @@ jsi::Value CommCoreModule::getClientDBStore(jsi::Runtime &rt) {
             promise->resolve(std::move(jsiClientDBStore));
           });
         };
-        GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+
+        // Messages handed over from a snapshot that then turned out to be
+        // unreadable are dropped before they are loaded from the database.
+        taskType discardMessages = [=]() {
+          if (std::this_thread::get_id() == jsThreadID) {
+            jsiMessagesVectorPtr->clear();
+            return;
+          }
+          this->jsInvoker_->invokeAsync(
+              [jsiMessagesVectorPtr]() { jsiMessagesVectorPtr->clear(); });
+        };
+
+        // An up to date snapshot of the store lets us skip the database.
+        Task job = [=]() {
+          std::unique_ptr<ClientDBStore> snapshot;
+          try {
+            snapshot =
+                DatabaseManager::getQueryExecutor().getClientDBStoreSnapshot(
+                    this->messagesChunkSize, handOverMessages);
+          } catch (const std::exception &e) {
+            Logger::log(
+                "getClientDBStore: failed to read snapshot. Details: " +
+                std::string(e.what()));
+            discardMessages();
+          }
+          if (snapshot == nullptr) {
+            ClientDBStoreSnapshotWriter::instance().scheduleWrite();
+            GlobalDBSingleton::instance.scheduleOrRunCancellableSnapshotReads(
+                openSnapshot,
+                reads,
+                closeSnapshot,
+                onDone,
+                promise,
+                this->jsInvoker_,
+                cancellationToken);
+            return;
+          }
+
+          *draftsVectorPtr = std::move(snapshot->drafts);
+          *threadsVectorPtr = std::move(snapshot->threads);
+          *messageStoreThreadsVectorPtr =
+              std::move(snapshot->messageStoreThreads);
+          *reportStoreVectorPtr = std::move(snapshot->reports);
+          *userStoreVectorPtr = std::move(snapshot->users);
+          *keyserveStoreVectorPtr = std::move(snapshot->keyservers);
+          *communityStoreVectorPtr = std::move(snapshot->communities);
+          Logger::log("getClientDBStore: loaded from snapshot");
+          onDone();
+        };
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job),
+            promise,
+            this->jsInvoker_,
+            cancellationToken,
+            ReadOrdering::AFTER_SCHEDULED_WRITES);
+        // Queued behind the store reads, so they aren't held back by it.
+        MessageSearchIndexer::instance().scheduleIndexing();
+        DatabaseMaintenanceScheduler::instance().scheduleMaintenance();
       });
 }
 
 jsi::Value CommCoreModule::removeAllDrafts(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=]() {
+        Task job = [=]() {
           std::string error;
           try {
-            DatabaseManager::getQueryExecutor().removeAllDrafts();
-          } catch (std::system_error &e) {
+            const DatabaseQueryExecutor &queryExecutor =
+                DatabaseManager::getQueryExecutor();
+            queryExecutor.runInTransaction(
+                [&]() { queryExecutor.removeAllDrafts(); });
+          } catch (const std::exception &e) {
             error = e.what();
           }
           this->jsInvoker_->invokeAsync([=]() {
@@ -237,43 +491,271 @@ jsi::Value CommCoreModule::removeAllDrafts(jsi::Runtime &rt) {
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Array CommCoreModule::getAllMessagesSync(jsi::Runtime &rt) {
-  auto messagesVector = NativeModuleUtils::runSyncOrThrowJSError<
-      std::vector<std::pair<Message, std::vector<Media>>>>(rt, []() {
-    return DatabaseManager::getQueryExecutor().getAllMessages();
-  });
-  auto messagesVectorPtr =
-      std::make_shared<std::vector<std::pair<Message, std::vector<Media>>>>(
-          std::move(messagesVector));
-  jsi::Array jsiMessages =
-      this->messageStore.parseDBDataStore(rt, messagesVectorPtr);
+  TaskLabelScope taskLabelScope(__func__);
+  std::vector<jsi::Object> jsiMessagesVector;
+  const std::size_t chunkSize = this->messagesChunkSize;
+  NativeModuleUtils::runSyncChunkedOrThrowJSError<std::vector<MessageEntity>>(
+      rt,
+      [chunkSize](const std::function<void(std::vector<MessageEntity> &&)>
+                      &onChunk) {
+        DatabaseManager::getQueryExecutor().getAllMessagesInChunks(
+            chunkSize, onChunk);
+      },
+      [this, &rt, &jsiMessagesVector](std::vector<MessageEntity> &&chunk) {
+        for (const auto &messageEntity : chunk) {
+          jsiMessagesVector.push_back(
+              this->messageStore.parseDBMessage(rt, messageEntity));
+        }
+      });
+
+  jsi::Array jsiMessages = jsi::Array(rt, jsiMessagesVector.size());
+  size_t writeIndex = 0;
+  for (auto &jsiMessage : jsiMessagesVector) {
+    jsiMessages.setValueAtIndex(rt, writeIndex++, std::move(jsiMessage));
+  }
   return jsiMessages;
 }
 
+// Counts come from JS as doubles. Converting one that doesn't fit in an int is
+// undefined behavior, and a negative LIMIT means no limit to SQLite, so
+// anything but a non-negative number is rejected, and larger ones are
+// clamped.
+int countToInt(jsi::Runtime &rt, double count, const std::string &name) {
+  if (!(count >= 0)) {
+    throw jsi::JSError(rt, "Invalid " + name + ": " + std::to_string(count));
+  }
+  return static_cast<int>(
+      std::min(count, static_cast<double>(std::numeric_limits<int>::max())));
+}
+
+// Message times come from JS as strings. std::stoll would throw outside of the
+// JSError conversion and accept trailing garbage, so the whole string has to be
+// a decimal number that fits in int64_t.
+int64_t timeToInt64(
+    jsi::Runtime &rt,
+    const std::string &time,
+    const std::string &name) {
+  int64_t value;
+  const char *end = time.data() + time.size();
+  auto [parseEnd, parseError] = std::from_chars(time.data(), end, value);
+  if (parseError != std::errc() || parseEnd != end) {
+    throw jsi::JSError(rt, "Invalid " + name + ": " + time);
+  }
+  return value;
+}
+
+jsi::Value CommCoreModule::getMessagesForThread(
+    jsi::Runtime &rt,
+    jsi::String threadID,
+    std::optional<jsi::String> beforeTime,
+    std::optional<jsi::String> beforeID,
+    double limit) {
+  TaskLabelScope taskLabelScope(__func__);
+  std::string threadIDStr = threadID.utf8(rt);
+  int64_t beforeTimeValue = beforeTime.has_value()
+      ? timeToInt64(rt, beforeTime->utf8(rt), "beforeTime")
+      : std::numeric_limits<int64_t>::max();
+  // Without an id, all messages with the given time are skipped.
+  std::string beforeIDStr = beforeID.has_value() ? beforeID->utf8(rt) : "";
+  int limitValue = countToInt(rt, limit, "limit");
+  return createPromiseAsJSIValue(
+      rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
+        Task job = [=, &innerRt]() {
+          std::string error;
+          std::vector<std::pair<Message, std::vector<Media>>> messagesVector;
+          try {
+            messagesVector =
+                DatabaseManager::getQueryExecutor().getMessagesForThread(
+                    threadIDStr, beforeTimeValue, beforeIDStr, limitValue);
+          } catch (const std::exception &e) {
+            error = e.what();
+          }
+          auto messagesVectorPtr = std::make_shared<
+              std::vector<std::pair<Message, std::vector<Media>>>>(
+              std::move(messagesVector));
+          this->jsInvoker_->invokeAsync([=, &innerRt]() {
+            if (error.size()) {
+              promise->reject(error);
+              return;
+            }
+            jsi::Array jsiMessages =
+                this->messageStore.parseDBDataStore(innerRt, messagesVectorPtr);
+            promise->resolve(std::move(jsiMessages));
+          });
+        };
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job),
+            promise,
+            this->jsInvoker_,
+            nullptr,
+            ReadOrdering::AFTER_SCHEDULED_WRITES);
+      });
+}
+
+jsi::Value CommCoreModule::getMessagesForThreadAfter(
+    jsi::Runtime &rt,
+    jsi::String threadID,
+    jsi::String afterTime,
+    jsi::String afterID,
+    double limit) {
+  TaskLabelScope taskLabelScope(__func__);
+  std::string threadIDStr = threadID.utf8(rt);
+  int64_t afterTimeValue = timeToInt64(rt, afterTime.utf8(rt), "afterTime");
+  std::string afterIDStr = afterID.utf8(rt);
+  int limitValue = countToInt(rt, limit, "limit");
+  return createPromiseAsJSIValue(
+      rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
+        Task job = [=, &innerRt]() {
+          std::string error;
+          std::vector<std::pair<Message, std::vector<Media>>> messagesVector;
+          try {
+            messagesVector =
+                DatabaseManager::getQueryExecutor().getMessagesForThreadAfter(
+                    threadIDStr, afterTimeValue, afterIDStr, limitValue);
+          } catch (const std::exception &e) {
+            error = e.what();
+          }
+          auto messagesVectorPtr = std::make_shared<
+              std::vector<std::pair<Message, std::vector<Media>>>>(
+              std::move(messagesVector));
+          this->jsInvoker_->invokeAsync([=, &innerRt]() {
+            if (error.size()) {
+              promise->reject(error);
+              return;
+            }
+            jsi::Array jsiMessages =
+                this->messageStore.parseDBDataStore(innerRt, messagesVectorPtr);
+            promise->resolve(std::move(jsiMessages));
+          });
+        };
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job),
+            promise,
+            this->jsInvoker_,
+            nullptr,
+            ReadOrdering::AFTER_SCHEDULED_WRITES);
+      });
+}
+
+jsi::Value CommCoreModule::searchMessages(
+    jsi::Runtime &rt,
+    jsi::String query,
+    std::optional<jsi::String> threadID,
+    double limit,
+    double offset) {
+  TaskLabelScope taskLabelScope(__func__);
+  std::string queryStr = query.utf8(rt);
+  std::optional<std::string> threadIDStr;
+  if (threadID.has_value()) {
+    threadIDStr = threadID->utf8(rt);
+  }
+  int limitValue = countToInt(rt, limit, "limit");
+  int offsetValue = countToInt(rt, offset, "offset");
+  return createPromiseAsJSIValue(
+      rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
+        Task job = [=, &innerRt]() {
+          std::string error;
+          std::vector<std::string> messageIDs;
+          try {
+            messageIDs = DatabaseManager::getQueryExecutor().searchMessages(
+                queryStr, threadIDStr, limitValue, offsetValue);
+          } catch (const std::exception &e) {
+            error = e.what();
+          }
+          this->jsInvoker_->invokeAsync([=, &innerRt]() {
+            if (error.size()) {
+              promise->reject(error);
+              return;
+            }
+            jsi::Array jsiMessageIDs = jsi::Array(innerRt, messageIDs.size());
+            for (std::size_t i = 0; i < messageIDs.size(); i++) {
+              jsiMessageIDs.setValueAtIndex(
+                  innerRt,
+                  i,
+                  jsi::String::createFromUtf8(innerRt, messageIDs[i]));
+            }
+            promise->resolve(std::move(jsiMessageIDs));
+          });
+        };
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job), promise, this->jsInvoker_);
+      });
+}
+
+jsi::Value CommCoreModule::getThreadSummaries(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
+  return createPromiseAsJSIValue(
+      rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
+        Task job = [=, &innerRt]() {
+          std::string error;
+          std::vector<ThreadSummary> threadSummaries;
+          try {
+            threadSummaries =
+                DatabaseManager::getQueryExecutor().getThreadSummaries();
+          } catch (const std::exception &e) {
+            error = e.what();
+          }
+          this->jsInvoker_->invokeAsync([=, &innerRt]() {
+            if (error.size()) {
+              promise->reject(error);
+              return;
+            }
+            jsi::Array jsiThreadSummaries =
+                jsi::Array(innerRt, threadSummaries.size());
+            for (std::size_t i = 0; i < threadSummaries.size(); i++) {
+              const ThreadSummary &threadSummary = threadSummaries[i];
+              auto jsiThreadSummary = jsi::Object(innerRt);
+              jsiThreadSummary.setProperty(
+                  innerRt, "threadID", threadSummary.thread);
+              jsiThreadSummary.setProperty(
+                  innerRt, "lastMessageID", threadSummary.last_message_id);
+              jsiThreadSummary.setProperty(
+                  innerRt,
+                  "lastMessageTime",
+                  std::to_string(threadSummary.last_message_time));
+              jsiThreadSummary.setProperty(
+                  innerRt, "lastMessageType", threadSummary.last_message_type);
+              jsiThreadSummary.setProperty(
+                  innerRt, "messagesCount", threadSummary.messages_count);
+              jsiThreadSummaries.setValueAtIndex(innerRt, i, jsiThreadSummary);
+            }
+            promise->resolve(std::move(jsiThreadSummaries));
+          });
+        };
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job), promise, this->jsInvoker_);
+      });
+}
+
 jsi::Value CommCoreModule::processDraftStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->draftStore.processStoreOperations(rt, std::move(operations));
 }
 
 jsi::Value CommCoreModule::processMessageStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->messageStore.processStoreOperations(rt, std::move(operations));
 }
 
 void CommCoreModule::processMessageStoreOperationsSync(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->messageStore.processStoreOperationsSync(
       rt, std::move(operations));
 }
 
 jsi::Array CommCoreModule::getAllThreadsSync(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   auto threadsVector =
       NativeModuleUtils::runSyncOrThrowJSError<std::vector<Thread>>(rt, []() {
         return DatabaseManager::getQueryExecutor().getAllThreads();
@@ -290,42 +772,49 @@ jsi::Array CommCoreModule::getAllThreadsSync(jsi::Runtime &rt) {
 jsi::Value CommCoreModule::processThreadStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->threadStore.processStoreOperations(rt, std::move(operations));
 }
 
 void CommCoreModule::processThreadStoreOperationsSync(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   this->threadStore.processStoreOperationsSync(rt, std::move(operations));
 }
 
 jsi::Value CommCoreModule::processReportStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->reportStore.processStoreOperations(rt, std::move(operations));
 }
 
 void CommCoreModule::processReportStoreOperationsSync(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   this->reportStore.processStoreOperationsSync(rt, std::move(operations));
 }
 
 jsi::Value CommCoreModule::processUserStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->userStore.processStoreOperations(rt, std::move(operations));
 }
 
 jsi::Value CommCoreModule::processKeyserverStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->keyserverStore.processStoreOperations(rt, std::move(operations));
 }
 
 jsi::Value CommCoreModule::processCommunityStoreOperations(
     jsi::Runtime &rt,
     jsi::Array operations) {
+  TaskLabelScope taskLabelScope(__func__);
   return this->communityStore.processStoreOperations(rt, std::move(operations));
 }
 
@@ -334,6 +823,7 @@ void CommCoreModule::terminate(jsi::Runtime &rt) {
 }
 
 void CommCoreModule::persistCryptoModule() {
+  TaskLabelScope taskLabelScope(__func__);
   folly::Optional<std::string> storedSecretKey =
       CommSecureStore::get(this->secureStoreAccountDataKey);
   if (!storedSecretKey.hasValue()) {
@@ -352,7 +842,7 @@ void CommCoreModule::persistCryptoModule() {
         try {
           DatabaseManager::getQueryExecutor().storeOlmPersistData(newPersist);
           persistencePromise.set_value();
-        } catch (std::system_error &e) {
+        } catch (const std::exception &e) {
           persistencePromise.set_exception(std::make_exception_ptr(e));
         }
       });
@@ -360,6 +850,7 @@ void CommCoreModule::persistCryptoModule() {
 }
 
 jsi::Value CommCoreModule::initializeCryptoAccount(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   folly::Optional<std::string> storedSecretKey =
       CommSecureStore::get(this->secureStoreAccountDataKey);
   if (!storedSecretKey.hasValue()) {
@@ -370,7 +861,7 @@ jsi::Value CommCoreModule::initializeCryptoAccount(jsi::Runtime &rt) {
 
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=]() {
+        Task job = [=]() {
           crypto::Persist persist;
           std::string error;
           try {
@@ -391,11 +882,11 @@ jsi::Value CommCoreModule::initializeCryptoAccount(jsi::Runtime &rt) {
                     sessionsDataItem.target_user_id, sessionDataBuffer));
               }
             }
-          } catch (std::system_error &e) {
+          } catch (const std::exception &e) {
             error = e.what();
           }
 
-          this->cryptoThread->scheduleTask([=]() {
+          this->cryptoExecutor.scheduleTask(this->cryptoAccountTaskKey, [=]() {
             std::string error;
             this->cryptoModule.reset(new crypto::CryptoModule(
                 this->publicCryptoAccountID, storedSecretKey.value(), persist));
@@ -408,7 +899,7 @@ jsi::Value CommCoreModule::initializeCryptoAccount(jsi::Runtime &rt) {
                     try {
                       DatabaseManager::getQueryExecutor().storeOlmPersistData(
                           newPersist);
-                    } catch (std::system_error &e) {
+                    } catch (const std::exception &e) {
                       error = e.what();
                     }
                     this->jsInvoker_->invokeAsync([=]() {
@@ -447,14 +938,15 @@ jsi::Value CommCoreModule::initializeCryptoAccount(jsi::Runtime &rt) {
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::getUserPublicKey(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string primaryKeysResult;
           std::string notificationsKeysResult;
@@ -561,7 +1053,8 @@ jsi::Value CommCoreModule::getUserPublicKey(jsi::Runtime &rt) {
             promise->resolve(std::move(jsiClientPublicKeys));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -600,9 +1093,10 @@ jsi::Object parseOneTimeKeysResult(
 
 jsi::Value
 CommCoreModule::getOneTimeKeys(jsi::Runtime &rt, double oneTimeKeysAmount) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string contentResult;
           std::string notifResult;
@@ -631,7 +1125,8 @@ CommCoreModule::getOneTimeKeys(jsi::Runtime &rt, double oneTimeKeysAmount) {
                 parseOneTimeKeysResult(innerRt, contentResult, notifResult));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -652,12 +1147,13 @@ jsi::Value CommCoreModule::validateAndUploadPrekeys(
     jsi::String authUserID,
     jsi::String authDeviceID,
     jsi::String authAccessToken) {
+  TaskLabelScope taskLabelScope(__func__);
   auto authUserIDRust = jsiStringToRustString(authUserID, rt);
   auto authDeviceIDRust = jsiStringToRustString(authDeviceID, rt);
   auto authAccessTokenRust = jsiStringToRustString(authAccessToken, rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::optional<std::string> maybePrekeyToUpload;
 
@@ -740,14 +1236,16 @@ jsi::Value CommCoreModule::validateAndUploadPrekeys(
             promise->resolve(jsi::Value::undefined());
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
 jsi::Value CommCoreModule::validateAndGetPrekeys(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string contentPrekeySignature, notifPrekey, notifPrekeySignature;
           std::optional<std::string> contentPrekey;
@@ -805,7 +1303,8 @@ jsi::Value CommCoreModule::validateAndGetPrekeys(jsi::Runtime &rt) {
           });
         };
 
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -816,13 +1315,14 @@ jsi::Value CommCoreModule::initializeNotificationsSession(
     jsi::String prekeySignature,
     jsi::String oneTimeKey,
     jsi::String keyserverID) {
+  TaskLabelScope taskLabelScope(__func__);
   auto identityKeysCpp{identityKeys.utf8(rt)};
   auto prekeyCpp{prekey.utf8(rt)};
   auto prekeySignatureCpp{prekeySignature.utf8(rt)};
   auto oneTimeKeyCpp{oneTimeKey.utf8(rt)};
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           crypto::EncryptedData result;
           try {
@@ -845,14 +1345,16 @@ jsi::Value CommCoreModule::initializeNotificationsSession(
                 std::string{result.message.begin(), result.message.end()}));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
 jsi::Value CommCoreModule::isNotificationsSessionInitialized(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           bool result;
           try {
@@ -870,7 +1372,8 @@ jsi::Value CommCoreModule::isNotificationsSessionInitialized(jsi::Runtime &rt) {
             promise->resolve(result);
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -881,6 +1384,7 @@ jsi::Value CommCoreModule::initializeContentOutboundSession(
     jsi::String prekeySignature,
     jsi::String oneTimeKey,
     jsi::String deviceID) {
+  TaskLabelScope taskLabelScope(__func__);
   auto identityKeysCpp{identityKeys.utf8(rt)};
   auto prekeyCpp{prekey.utf8(rt)};
   auto prekeySignatureCpp{prekeySignature.utf8(rt)};
@@ -888,7 +1392,7 @@ jsi::Value CommCoreModule::initializeContentOutboundSession(
   auto deviceIDCpp{deviceID.utf8(rt)};
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           crypto::EncryptedData initialEncryptedMessage;
           try {
@@ -921,7 +1425,8 @@ jsi::Value CommCoreModule::initializeContentOutboundSession(
                     initialEncryptedMessage.message.end()}));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -930,12 +1435,13 @@ jsi::Value CommCoreModule::initializeContentInboundSession(
     jsi::String identityKeys,
     jsi::String encryptedMessage,
     jsi::String deviceID) {
+  TaskLabelScope taskLabelScope(__func__);
   auto identityKeysCpp{identityKeys.utf8(rt)};
   auto encryptedMessageCpp{encryptedMessage.utf8(rt)};
   auto deviceIDCpp{deviceID.utf8(rt)};
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string decryptedMessage;
           try {
@@ -962,7 +1468,8 @@ jsi::Value CommCoreModule::initializeContentInboundSession(
                 jsi::String::createFromUtf8(innerRt, decryptedMessage));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -970,11 +1477,12 @@ jsi::Value CommCoreModule::encrypt(
     jsi::Runtime &rt,
     jsi::String message,
     jsi::String deviceID) {
+  TaskLabelScope taskLabelScope(__func__);
   auto messageCpp{message.utf8(rt)};
   auto deviceIDCpp{deviceID.utf8(rt)};
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           crypto::EncryptedData encryptedMessage;
           try {
@@ -995,7 +1503,8 @@ jsi::Value CommCoreModule::encrypt(
                     encryptedMessage.message.end()}));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -1003,11 +1512,12 @@ jsi::Value CommCoreModule::decrypt(
     jsi::Runtime &rt,
     jsi::String message,
     jsi::String deviceID) {
+  TaskLabelScope taskLabelScope(__func__);
   auto messageCpp{message.utf8(rt)};
   auto deviceIDCpp{deviceID.utf8(rt)};
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string decryptedMessage;
           try {
@@ -1029,15 +1539,17 @@ jsi::Value CommCoreModule::decrypt(
                 jsi::String::createFromUtf8(innerRt, decryptedMessage));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
 jsi::Value CommCoreModule::signMessage(jsi::Runtime &rt, jsi::String message) {
+  TaskLabelScope taskLabelScope(__func__);
   std::string messageStr = message.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string signature;
           try {
@@ -1056,14 +1568,14 @@ jsi::Value CommCoreModule::signMessage(jsi::Runtime &rt, jsi::String message) {
             promise->resolve(std::move(jsiSignature));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
 CommCoreModule::CommCoreModule(
     std::shared_ptr<facebook::react::CallInvoker> jsInvoker)
     : facebook::react::CommCoreModuleSchemaCxxSpecJSI(jsInvoker),
-      cryptoThread(std::make_unique<WorkerThread>("crypto")),
       draftStore(jsInvoker),
       threadStore(jsInvoker),
       messageStore(jsInvoker),
@@ -1072,6 +1584,14 @@ CommCoreModule::CommCoreModule(
       keyserverStore(jsInvoker),
       communityStore(jsInvoker) {
   GlobalDBSingleton::instance.enableMultithreading();
+  GlobalDBSingleton::instance.scheduleOrRun(
+      []() { DatabaseManager::setCurrentThreadWriter(); });
+  // Without read threads all reads run on the database thread.
+  if (DatabaseManager::areReadConnectionsSupported()) {
+    GlobalDBSingleton::instance.enableReadThreads(
+        this->databaseReadThreadsCount,
+        []() { DatabaseManager::setCurrentThreadReadOnly(); });
+  }
 }
 
 double CommCoreModule::getCodeVersion(jsi::Runtime &rt) {
@@ -1079,16 +1599,17 @@ double CommCoreModule::getCodeVersion(jsi::Runtime &rt) {
 }
 
 jsi::Value CommCoreModule::setNotifyToken(jsi::Runtime &rt, jsi::String token) {
+  TaskLabelScope taskLabelScope(__func__);
   auto notifyToken{token.utf8(rt)};
   return createPromiseAsJSIValue(
       rt,
       [this,
        notifyToken](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [this, notifyToken, promise]() {
+        Task job = [this, notifyToken, promise]() {
           std::string error;
           try {
             DatabaseManager::getQueryExecutor().setNotifyToken(notifyToken);
-          } catch (std::system_error &e) {
+          } catch (const std::exception &e) {
             error = e.what();
           }
 
@@ -1101,18 +1622,19 @@ jsi::Value CommCoreModule::setNotifyToken(jsi::Runtime &rt, jsi::String token) {
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::clearNotifyToken(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [this](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
         taskType job = [this, promise]() {
           std::string error;
           try {
             DatabaseManager::getQueryExecutor().clearNotifyToken();
-          } catch (std::system_error &e) {
+          } catch (const std::exception &e) {
             error = e.what();
           }
           this->jsInvoker_->invokeAsync([error, promise]() {
@@ -1135,7 +1657,7 @@ CommCoreModule::setCurrentUserID(jsi::Runtime &rt, jsi::String userID) {
       rt,
       [this,
        currentUserID](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [this, promise, currentUserID]() {
+        Task job = [this, promise, currentUserID]() {
           std::string error;
           try {
             DatabaseManager::getQueryExecutor().setCurrentUserID(currentUserID);
@@ -1151,14 +1673,15 @@ CommCoreModule::setCurrentUserID(jsi::Runtime &rt, jsi::String userID) {
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::getCurrentUserID(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [this](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [this, &innerRt, promise]() {
+        Task job = [this, &innerRt, promise]() {
           std::string error;
           std::string result;
           try {
@@ -1174,16 +1697,23 @@ jsi::Value CommCoreModule::getCurrentUserID(jsi::Runtime &rt) {
             }
           });
         };
-        GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+        GlobalDBSingleton::instance.scheduleOrRunCancellableRead(
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::clearSensitiveData(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [this](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
         GlobalDBSingleton::instance.setTasksCancelled(true);
-        taskType job = [this, promise]() {
+        // Store loads still running are interrupted too, so clearing the data
+        // doesn't have to wait for them.
+        if (this->clientDBStoreCancellationToken != nullptr) {
+          this->clientDBStoreCancellationToken->cancel();
+          this->clientDBStoreCancellationToken = nullptr;
+        }
+        Task job = [this, promise]() {
           std::string error;
           try {
             DatabaseManager::clearSensitiveData();
@@ -1200,7 +1730,7 @@ jsi::Value CommCoreModule::clearSensitiveData(jsi::Runtime &rt) {
           GlobalDBSingleton::instance.scheduleOrRun(
               []() { GlobalDBSingleton::instance.setTasksCancelled(false); });
         };
-        GlobalDBSingleton::instance.scheduleOrRun(job);
+        GlobalDBSingleton::instance.scheduleOrRun(std::move(job));
       });
 }
 
@@ -1212,15 +1742,116 @@ void CommCoreModule::reportDBOperationsFailure(jsi::Runtime &rt) {
   DatabaseManager::reportDBOperationsFailure();
 }
 
+jsi::Array CommCoreModule::getSQLiteStatementProfiles(jsi::Runtime &rt) {
+  // Aggregates are only guarded by a mutex that is held for a single map
+  // update, so they can be read directly on the JS thread.
+  std::vector<SQLiteStatementProfile> profiles =
+      SQLiteProfiler::getProfiles();
+  jsi::Array jsiProfiles = jsi::Array(rt, profiles.size());
+  for (std::size_t i = 0; i < profiles.size(); i++) {
+    const auto &profile = profiles[i];
+    auto jsiProfile = jsi::Object(rt);
+    jsiProfile.setProperty(rt, "sql", profile.sql);
+    jsiProfile.setProperty(
+        rt, "callsCount", static_cast<double>(profile.callsCount));
+    jsiProfile.setProperty(rt, "totalTimeMs", profile.totalTimeNs / 1e6);
+    jsiProfile.setProperty(rt, "p50TimeMs", profile.p50TimeNs / 1e6);
+    jsiProfile.setProperty(rt, "p90TimeMs", profile.p90TimeNs / 1e6);
+    jsiProfile.setProperty(rt, "p99TimeMs", profile.p99TimeNs / 1e6);
+    jsiProfile.setProperty(
+        rt, "rowsReturned", static_cast<double>(profile.rowsReturned));
+    jsiProfile.setProperty(
+        rt, "rowsChanged", static_cast<double>(profile.rowsChanged));
+    jsiProfiles.setValueAtIndex(rt, i, jsiProfile);
+  }
+  return jsiProfiles;
+}
+
+void CommCoreModule::logSQLiteStatementProfiles(
+    jsi::Runtime &rt,
+    double statementsCount) {
+  SQLiteProfiler::logProfiles(statementsCount);
+}
+
+jsi::Object
+CommCoreModule::getStoreOperationsCompactionStats(jsi::Runtime &rt) {
+  const auto &stats = StoreOperationsCompactionStats::instance();
+  auto jsiStats = jsi::Object(rt);
+  jsiStats.setProperty(
+      rt, "operationsCount", static_cast<double>(stats.getOperationsCount()));
+  jsiStats.setProperty(
+      rt,
+      "executedOperationsCount",
+      static_cast<double>(stats.getExecutedOperationsCount()));
+  return jsiStats;
+}
+
+jsi::Object histogramSummaryToJSI(
+    jsi::Runtime &rt,
+    const HistogramSummary &summary,
+    double unit) {
+  auto jsiHistogram = jsi::Object(rt);
+  jsiHistogram.setProperty(rt, "count", static_cast<double>(summary.count));
+  jsiHistogram.setProperty(rt, "total", summary.total / unit);
+  jsiHistogram.setProperty(rt, "p50", summary.p50 / unit);
+  jsiHistogram.setProperty(rt, "p90", summary.p90 / unit);
+  jsiHistogram.setProperty(rt, "p99", summary.p99 / unit);
+  jsiHistogram.setProperty(rt, "max", summary.max / unit);
+  return jsiHistogram;
+}
+
+jsi::Array CommCoreModule::getTaskQueuesTelemetry(
+    jsi::Runtime &rt,
+    double slowestTasksCount) {
+  // Times are recorded in microseconds and returned in milliseconds.
+  const double usPerMs = 1e3;
+  std::vector<TaskQueueTelemetry> snapshots =
+      TaskTelemetry::getAllSnapshots(static_cast<size_t>(slowestTasksCount));
+  jsi::Array jsiSnapshots = jsi::Array(rt, snapshots.size());
+  for (std::size_t i = 0; i < snapshots.size(); i++) {
+    const auto &snapshot = snapshots[i];
+    jsi::Array jsiSlowestTasks = jsi::Array(rt, snapshot.slowestTasks.size());
+    for (std::size_t j = 0; j < snapshot.slowestTasks.size(); j++) {
+      const auto &task = snapshot.slowestTasks[j];
+      auto jsiTask = jsi::Object(rt);
+      jsiTask.setProperty(rt, "label", task.label);
+      jsiTask.setProperty(
+          rt,
+          "waitTimeMs",
+          histogramSummaryToJSI(rt, task.waitTimeUs, usPerMs));
+      jsiTask.setProperty(
+          rt, "runTimeMs", histogramSummaryToJSI(rt, task.runTimeUs, usPerMs));
+      jsiSlowestTasks.setValueAtIndex(rt, j, jsiTask);
+    }
+
+    auto jsiSnapshot = jsi::Object(rt);
+    jsiSnapshot.setProperty(rt, "name", snapshot.name);
+    jsiSnapshot.setProperty(
+        rt, "queueDepth", histogramSummaryToJSI(rt, snapshot.queueDepth, 1));
+    jsiSnapshot.setProperty(
+        rt,
+        "waitTimeMs",
+        histogramSummaryToJSI(rt, snapshot.waitTimeUs, usPerMs));
+    jsiSnapshot.setProperty(
+        rt,
+        "runTimeMs",
+        histogramSummaryToJSI(rt, snapshot.runTimeUs, usPerMs));
+    jsiSnapshot.setProperty(rt, "slowestTasks", jsiSlowestTasks);
+    jsiSnapshots.setValueAtIndex(rt, i, jsiSnapshot);
+  }
+  return jsiSnapshots;
+}
+
 jsi::Value CommCoreModule::computeBackupKey(
     jsi::Runtime &rt,
     jsi::String password,
     jsi::String backupID) {
+  TaskLabelScope taskLabelScope(__func__);
   std::string passwordStr = password.utf8(rt);
   std::string backupIDStr = backupID.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::array<::std::uint8_t, 32> backupKey;
           try {
@@ -1246,14 +1877,15 @@ jsi::Value CommCoreModule::computeBackupKey(
             promise->resolve(std::move(arrayBuffer));
           });
         };
-        this->cryptoThread->scheduleTask(job);
+        WorkStealingThreadPool::shared().scheduleTask(std::move(job));
       });
 }
 
 jsi::Value CommCoreModule::generateRandomString(jsi::Runtime &rt, double size) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::string randomString;
           try {
@@ -1275,7 +1907,7 @@ jsi::Value CommCoreModule::generateRandomString(jsi::Runtime &rt, double size) {
                 }
               });
         };
-        this->cryptoThread->scheduleTask(job);
+        WorkStealingThreadPool::shared().scheduleTask(std::move(job));
       });
 }
 
@@ -1284,6 +1916,7 @@ jsi::Value CommCoreModule::setCommServicesAuthMetadata(
     jsi::String userID,
     jsi::String deviceID,
     jsi::String accessToken) {
+  TaskLabelScope taskLabelScope(__func__);
   auto userIDStr{userID.utf8(rt)};
   auto deviceIDStr{deviceID.utf8(rt)};
   auto accessTokenStr{accessToken.utf8(rt)};
@@ -1318,9 +1951,10 @@ jsi::Value CommCoreModule::setCommServicesAuthMetadata(
 }
 
 jsi::Value CommCoreModule::getCommServicesAuthMetadata(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [this](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [this, &innerRt, promise]() {
+        Task job = [this, &innerRt, promise]() {
           std::string error;
           std::string userID;
           std::string deviceID;
@@ -1373,19 +2007,20 @@ jsi::Value CommCoreModule::getCommServicesAuthMetadata(jsi::Runtime &rt) {
               });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::setCommServicesAccessToken(
     jsi::Runtime &rt,
     jsi::String accessToken) {
+  TaskLabelScope taskLabelScope(__func__);
   auto accessTokenStr{accessToken.utf8(rt)};
   return createPromiseAsJSIValue(
       rt,
       [this, accessTokenStr](
           jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [this, promise, accessTokenStr]() {
+        Task job = [this, promise, accessTokenStr]() {
           std::string error;
           try {
             CommSecureStore::set(
@@ -1402,14 +2037,15 @@ jsi::Value CommCoreModule::setCommServicesAccessToken(
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
 jsi::Value CommCoreModule::clearCommServicesAccessToken(jsi::Runtime &rt) {
+  TaskLabelScope taskLabelScope(__func__);
   return createPromiseAsJSIValue(
       rt, [this](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [this, promise]() {
+        Task job = [this, promise]() {
           std::string error;
           try {
             CommSecureStore::set(CommSecureStore::commServicesAccessToken, "");
@@ -1425,7 +2061,7 @@ jsi::Value CommCoreModule::clearCommServicesAccessToken(jsi::Runtime &rt) {
           });
         };
         GlobalDBSingleton::instance.scheduleOrRunCancellable(
-            job, promise, this->jsInvoker_);
+            std::move(job), promise, this->jsInvoker_);
       });
 }
 
@@ -1447,10 +2083,11 @@ void CommCoreModule::stopBackupHandler(jsi::Runtime &rt) {
 
 jsi::Value
 CommCoreModule::createNewBackup(jsi::Runtime &rt, jsi::String backupSecret) {
+  TaskLabelScope taskLabelScope(__func__);
   std::string backupSecretStr = backupSecret.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        this->cryptoThread->scheduleTask([=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
 
           std::string backupID;
@@ -1487,7 +2124,9 @@ CommCoreModule::createNewBackup(jsi::Runtime &rt, jsi::String backupSecret) {
             this->jsInvoker_->invokeAsync(
                 [=, &innerRt]() { promise->reject(error); });
           }
-        });
+        };
+        this->cryptoExecutor.scheduleTask(
+            this->cryptoAccountTaskKey, std::move(job));
       });
 }
 
@@ -1,8 +1,9 @@
 #pragma once
 
 #include "../CryptoTools/CryptoModule.h"
+#include "../Tools/CancellationToken.h"
 #include "../Tools/CommSecureStore.h"
-#include "../Tools/WorkerThread.h"
+#include "../Tools/KeyedSerialExecutor.h"
 #include "../_generated/commJSI.h"
 #include "PersistentStorageUtilities/DataStores/CommunityStore.h"
 #include "PersistentStorageUtilities/DataStores/DraftStore.h"
@@ -22,7 +23,20 @@ namespace jsi = facebook::jsi;
 
 class CommCoreModule : public facebook::react::CommCoreModuleSchemaCxxSpecJSI {
   const int codeVersion{324};
-  std::unique_ptr<WorkerThread> cryptoThread;
+  // Number of messages read from the database before handing them over to
+  // the JS thread when loading all of them at once.
+  const std::size_t messagesChunkSize{1000};
+  // Number of such chunks handed over to the JS thread but not yet converted
+  // to JS objects, above which reading the next one waits.
+  const std::size_t maxPendingMessagesChunks{2};
+  // Number of threads serving read-only database queries in parallel with the
+  // database thread.
+  const std::size_t databaseReadThreadsCount{2};
+  // Any olm task may persist the account together with all of its sessions,
+  // so they all run in order under a single key. Tasks not touching the
+  // account go straight to the shared thread pool.
+  KeyedSerialExecutor cryptoExecutor;
+  const std::string cryptoAccountTaskKey = "cryptoAccount";
 
   const std::string secureStoreAccountDataKey = "cryptoAccountDataKey";
   const std::string publicCryptoAccountID = "publicCryptoAccountID";
@@ -34,6 +48,9 @@ class CommCoreModule : public facebook::react::CommCoreModuleSchemaCxxSpecJSI {
   UserStore userStore;
   KeyserverStore keyserverStore;
   CommunityStore communityStore;
+  // Shared by all store loads pending at the time, so clearing sensitive data
+  // can drop them. Only ever accessed on the JS thread.
+  std::shared_ptr<CancellationToken> clientDBStoreCancellationToken;
 
   void persistCryptoModule();
 
@@ -45,6 +62,25 @@ class CommCoreModule : public facebook::react::CommCoreModuleSchemaCxxSpecJSI {
   virtual jsi::Value getClientDBStore(jsi::Runtime &rt) override;
   virtual jsi::Value removeAllDrafts(jsi::Runtime &rt) override;
   virtual jsi::Array getAllMessagesSync(jsi::Runtime &rt) override;
+  virtual jsi::Value getMessagesForThread(
+      jsi::Runtime &rt,
+      jsi::String threadID,
+      std::optional<jsi::String> beforeTime,
+      std::optional<jsi::String> beforeID,
+      double limit) override;
+  virtual jsi::Value getMessagesForThreadAfter(
+      jsi::Runtime &rt,
+      jsi::String threadID,
+      jsi::String afterTime,
+      jsi::String afterID,
+      double limit) override;
+  virtual jsi::Value searchMessages(
+      jsi::Runtime &rt,
+      jsi::String query,
+      std::optional<jsi::String> threadID,
+      double limit,
+      double offset) override;
+  virtual jsi::Value getThreadSummaries(jsi::Runtime &rt) override;
   virtual jsi::Value
   processDraftStoreOperations(jsi::Runtime &rt, jsi::Array operations) override;
   virtual jsi::Value processReportStoreOperations(
@@ -122,6 +158,13 @@ class CommCoreModule : public facebook::react::CommCoreModuleSchemaCxxSpecJSI {
   virtual jsi::Value clearSensitiveData(jsi::Runtime &rt) override;
   virtual bool checkIfDatabaseNeedsDeletion(jsi::Runtime &rt) override;
   virtual void reportDBOperationsFailure(jsi::Runtime &rt) override;
+  virtual jsi::Array getSQLiteStatementProfiles(jsi::Runtime &rt) override;
+  virtual void
+  logSQLiteStatementProfiles(jsi::Runtime &rt, double statementsCount) override;
+  virtual jsi::Object
+  getStoreOperationsCompactionStats(jsi::Runtime &rt) override;
+  virtual jsi::Array
+  getTaskQueuesTelemetry(jsi::Runtime &rt, double slowestTasksCount) override;
   virtual jsi::Value computeBackupKey(
       jsi::Runtime &rt,
       jsi::String password,
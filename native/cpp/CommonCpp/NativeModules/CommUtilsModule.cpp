@@ -1,5 +1,6 @@
 #include "CommUtilsModule.h"
 #include "../Tools/Base64.h"
+#include "../Tools/TaskTelemetry.h"
 #include "olm/olm.h"
 
 #include <ReactCommon/TurboModuleUtils.h>
@@ -12,7 +13,6 @@ using namespace facebook::react;
 
 CommUtilsModule::CommUtilsModule(std::shared_ptr<CallInvoker> jsInvoker)
     : CommUtilsModuleSchemaCxxSpecJSI(jsInvoker),
-      utilsThread(std::make_unique<WorkerThread>("utils")),
       olmUtilityBuffer(::olm_utility_size()) {
   this->olmUtility = ::olm_utility(olmUtilityBuffer.data());
 }
@@ -21,13 +21,14 @@ jsi::Value CommUtilsModule::writeBufferToFile(
     jsi::Runtime &rt,
     jsi::String path,
     jsi::Object data) {
+  TaskLabelScope taskLabelScope(__func__);
   auto arrayBuffer = data.getArrayBuffer(rt);
   auto size = arrayBuffer.size(rt);
   auto dataPtr = arrayBuffer.data(rt);
   auto filePath = path.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           try {
             std::ofstream file;
@@ -47,16 +48,17 @@ jsi::Value CommUtilsModule::writeBufferToFile(
             }
           });
         };
-        this->utilsThread->scheduleTask(job);
+        this->fileExecutor.scheduleTask(filePath, std::move(job));
       });
 }
 
 jsi::Value
 CommUtilsModule::readBufferFromFile(jsi::Runtime &rt, jsi::String path) {
+  TaskLabelScope taskLabelScope(__func__);
   auto filePath = path.utf8(rt);
   return createPromiseAsJSIValue(
       rt, [=](jsi::Runtime &innerRt, std::shared_ptr<Promise> promise) {
-        taskType job = [=, &innerRt]() {
+        Task job = [=, &innerRt]() {
           std::string error;
           std::streampos file_size;
           std::shared_ptr<uint8_t> data{nullptr};
@@ -98,7 +100,7 @@ CommUtilsModule::readBufferFromFile(jsi::Runtime &rt, jsi::String path) {
             promise->resolve(std::move(arrayBuffer));
           });
         };
-        this->utilsThread->scheduleTask(job);
+        this->fileExecutor.scheduleTask(filePath, std::move(job));
       });
 }
 
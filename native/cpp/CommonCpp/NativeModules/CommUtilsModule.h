@@ -1,7 +1,7 @@
 #pragma once
 
 #include "../CryptoTools/Tools.h"
-#include "../Tools/WorkerThread.h"
+#include "../Tools/KeyedSerialExecutor.h"
 #include "../_generated/utilsJSI.h"
 #include "olm/olm.h"
 #include <ReactCommon/TurboModuleUtils.h>
@@ -16,7 +16,9 @@ using ::comm::crypto::OlmBuffer;
 
 class CommUtilsModule
     : public facebook::react::CommUtilsModuleSchemaCxxSpecJSI {
-  std::unique_ptr<WorkerThread> utilsThread;
+  // Reads and writes of different files run in parallel, and the ones of the
+  // same file in the order they were called.
+  KeyedSerialExecutor fileExecutor;
 
   OlmBuffer olmUtilityBuffer;
   ::OlmUtility *olmUtility;
@@ -2,12 +2,14 @@
 
 #include "../DatabaseManagers/entities/CommunityInfo.h"
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
 #include <vector>
 
 namespace comm {
 class CommunityStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~CommunityStoreOperationBase(){};
 };
 
@@ -20,6 +22,10 @@ public:
     DatabaseManager::getQueryExecutor().removeCommunities(this->ids);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Remove, "communities", this->ids};
+  }
+
 private:
   std::vector<std::string> ids;
 };
@@ -34,6 +40,13 @@ public:
     DatabaseManager::getQueryExecutor().replaceCommunity(this->community);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {
+        StoreOperationEffect::Type::Replace,
+        "communities",
+        {this->community.id}};
+  }
+
 private:
   CommunityInfo community;
 };
@@ -43,6 +56,10 @@ public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllCommunities();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "communities"};
+  }
 };
 
 } // namespace comm
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
 #include <jsi/jsi.h>
 
 namespace comm {
@@ -10,6 +11,7 @@ namespace jsi = facebook::jsi;
 class DraftStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~DraftStoreOperationBase(){};
 };
 
@@ -23,6 +25,10 @@ public:
     DatabaseManager::getQueryExecutor().updateDraft(this->key, this->text);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Replace, "drafts", {this->key}};
+  }
+
 private:
   std::string key;
   std::string text;
@@ -38,6 +44,10 @@ public:
     DatabaseManager::getQueryExecutor().moveDraft(this->oldKey, this->newKey);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Other, "drafts"};
+  }
+
 private:
   std::string oldKey;
   std::string newKey;
@@ -48,6 +58,10 @@ public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllDrafts();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "drafts"};
+  }
 };
 
 class RemoveDraftsOperation : public DraftStoreOperationBase {
@@ -65,6 +79,10 @@ public:
     DatabaseManager::getQueryExecutor().removeDrafts(this->idsToRemove);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Remove, "drafts", this->idsToRemove};
+  }
+
 private:
   std::vector<std::string> idsToRemove;
 };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../../DatabaseManagers/DatabaseManager.h"
+#include "../../Tools/CancellationToken.h"
+#include "../../Tools/Logger.h"
+#include "../../Tools/WorkerThread.h"
+#include "GlobalDBSingleton.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace comm {
+
+// Refreshes the client DB store snapshot in the background. Every write
+// reads the whole store, so requests are debounced until the store went
+// `quietPeriod` without changes, and writes are at least `minWriteInterval`
+// apart. The store is read through a dedicated read-only connection, which
+// doesn't hold back commits, but competes with the database thread and the
+// read threads for I/O, so a write only starts once those are idle. The read
+// is interrupted after `GlobalDBSingleton::readTransactionTimeout`, as a
+// long read transaction keeps the write-ahead log from being checkpointed.
+class ClientDBStoreSnapshotWriter {
+  const std::chrono::milliseconds quietPeriod{30000};
+  const std::chrono::milliseconds minWriteInterval{300000};
+  std::atomic<bool> writeScheduled{false};
+  std::atomic<std::chrono::steady_clock::time_point> lastWriteRequestedAt{};
+  std::once_flag writerThreadStarted;
+  std::unique_ptr<WorkerThread> writerThread;
+  // Only accessed on the writer thread.
+  std::chrono::steady_clock::time_point lastWriteStartedAt;
+
+public:
+  static ClientDBStoreSnapshotWriter &instance() {
+    static ClientDBStoreSnapshotWriter writer;
+    return writer;
+  }
+
+  void scheduleWrite() {
+    // The snapshot only saves time, so it's skipped where it can't be
+    // written without holding back the database thread.
+    if (!DatabaseManager::areReadConnectionsSupported()) {
+      return;
+    }
+    this->lastWriteRequestedAt.store(std::chrono::steady_clock::now());
+    if (this->writeScheduled.exchange(true)) {
+      return;
+    }
+    TaskLabelScope labelScope("writeClientDBStoreSnapshot");
+    std::call_once(this->writerThreadStarted, [this]() {
+      this->writerThread = std::make_unique<WorkerThread>("store snapshot");
+      this->writerThread->scheduleTask(
+          []() { DatabaseManager::setCurrentThreadReadOnly(); });
+    });
+    // At most one write is queued at a time, so the queue can't fill up.
+    this->writerThread->scheduleTask([this]() {
+      auto quietUntil = this->lastWriteRequestedAt.load() + this->quietPeriod;
+      while (std::chrono::steady_clock::now() < quietUntil) {
+        std::this_thread::sleep_until(quietUntil);
+        quietUntil = this->lastWriteRequestedAt.load() + this->quietPeriod;
+      }
+      std::this_thread::sleep_until(
+          this->lastWriteStartedAt + this->minWriteInterval);
+      GlobalDBSingleton::instance.waitUntilDatabaseThreadIdle();
+      this->lastWriteStartedAt = std::chrono::steady_clock::now();
+      // Commits from now on have to be picked up by another write.
+      this->writeScheduled.store(false);
+      CancellationToken deadline(GlobalDBSingleton::readTransactionTimeout);
+      CancellationScope deadlineScope(&deadline);
+      try {
+        DatabaseManager::getQueryExecutor().writeClientDBStoreSnapshot();
+      } catch (const std::exception &e) {
+        Logger::log(
+            "Failed to write client DB store snapshot. Details: " +
+            std::string(e.what()));
+      }
+    });
+  }
+};
+
+} // namespace comm
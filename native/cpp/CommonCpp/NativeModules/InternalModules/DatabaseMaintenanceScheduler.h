@@ -0,0 +1,160 @@
+#pragma once
+
+#include "../../DatabaseManagers/DatabaseManager.h"
+#include "../../Tools/Logger.h"
+#include "../../Tools/WorkerThread.h"
+#include "GlobalDBSingleton.h"
+#include "MessageSearchIndexer.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace comm {
+
+// Runs database maintenance on the database thread once it's idle. The work
+// is split into slices limited by a time budget, and every slice waits until
+// no other database task is queued, so maintenance holds back tasks
+// scheduled in the meantime by at most a single slice. Databases too large
+// to be switched to incremental auto vacuum within a slice are rebuilt
+// afterwards in one go, once the database has been idle for a while.
+class DatabaseMaintenanceScheduler {
+  const std::chrono::milliseconds startupDelay{30000};
+  const std::chrono::milliseconds idleCheckInterval{1000};
+  const std::chrono::milliseconds conversionIdleDuration{5 * 60 * 1000};
+  const int sliceTimeBudgetMs{50};
+  // Failed slices are retried, waiting twice as long after every failure.
+  const int maxFailedSlicesCount{8};
+  std::atomic<bool> maintenanceScheduled{false};
+  std::once_flag schedulerThreadStarted;
+  std::unique_ptr<WorkerThread> schedulerThread;
+  // Only accessed on the database thread.
+  DatabaseMaintenanceReport totalReport;
+  int failedSlicesCount{0};
+
+  void runSlice() {
+    bool maintenanceDone = false;
+    try {
+      DatabaseMaintenanceReport report =
+          DatabaseManager::getQueryExecutor().performMaintenance(
+              this->sliceTimeBudgetMs);
+      this->totalReport.add(report);
+      maintenanceDone = report.completed;
+      if (report.messageSearchIndexReset) {
+        MessageSearchIndexer::instance().scheduleIndexing();
+      }
+    } catch (const std::exception &e) {
+      Logger::log(
+          "Database maintenance failed. Details: " + std::string(e.what()));
+      // E.g. the database was busy, so the slice is retried later.
+      if (++this->failedSlicesCount < this->maxFailedSlicesCount) {
+        this->scheduleSlice(
+            this->idleCheckInterval * (1 << this->failedSlicesCount));
+        return;
+      }
+      Logger::log("Database maintenance given up after repeated failures");
+      this->finishMaintenance();
+      return;
+    }
+    this->failedSlicesCount = 0;
+    if (!maintenanceDone) {
+      this->scheduleSlice(this->idleCheckInterval);
+      return;
+    }
+
+    const DatabaseMaintenanceReport &report = this->totalReport;
+    Logger::log(
+        "Database maintenance done: reclaimed " +
+        std::to_string(report.pagesReclaimed) + " pages in " +
+        std::to_string(report.timeSpentMs) + "ms" +
+        (report.autoVacuumConverted ? ", switched to incremental vacuum" : "") +
+        (report.optimized ? ", optimized" : "") +
+        (report.analyzed ? ", analyzed" : ""));
+    if (report.autoVacuumConversionPending) {
+      this->scheduleConversion();
+      return;
+    }
+    this->finishMaintenance();
+  }
+
+  void runConversion() {
+    try {
+      DatabaseMaintenanceReport report =
+          DatabaseManager::getQueryExecutor().convertToIncrementalAutoVacuum();
+      if (report.messageSearchIndexReset) {
+        MessageSearchIndexer::instance().scheduleIndexing();
+      }
+      Logger::log(
+          "Database switched to incremental vacuum: reclaimed " +
+          std::to_string(report.pagesReclaimed) + " pages in " +
+          std::to_string(report.timeSpentMs) + "ms");
+    } catch (const std::exception &e) {
+      // Tried again the next time maintenance is scheduled.
+      Logger::log(
+          "Switching database to incremental vacuum failed. Details: " +
+          std::string(e.what()));
+    }
+    this->finishMaintenance();
+  }
+
+  void finishMaintenance() {
+    this->totalReport = DatabaseMaintenanceReport();
+    this->failedSlicesCount = 0;
+    this->maintenanceScheduled.store(false);
+  }
+
+  // At most one task is queued on the scheduler thread at a time, so its
+  // queue can't fill up.
+  void scheduleSlice(std::chrono::milliseconds delay) {
+    TaskLabelScope labelScope("databaseMaintenance");
+    this->schedulerThread->scheduleTask([this, delay]() {
+      std::this_thread::sleep_for(delay);
+      while (!GlobalDBSingleton::instance.isDatabaseThreadIdle()) {
+        std::this_thread::sleep_for(this->idleCheckInterval);
+      }
+      GlobalDBSingleton::instance.scheduleOrRun(
+          [this]() { this->runSlice(); }, TaskPriority::BACKGROUND);
+    });
+  }
+
+  // Rebuilding the database holds back every other database task until it's
+  // done, so it waits until no database task has been queued for
+  // `conversionIdleDuration`, which likely means the user isn't using the app.
+  void scheduleConversion() {
+    TaskLabelScope labelScope("databaseMaintenance");
+    this->schedulerThread->scheduleTask([this]() {
+      auto idleSince = std::chrono::steady_clock::now();
+      while (std::chrono::steady_clock::now() - idleSince <
+             this->conversionIdleDuration) {
+        std::this_thread::sleep_for(this->idleCheckInterval);
+        if (!GlobalDBSingleton::instance.isDatabaseThreadIdle()) {
+          idleSince = std::chrono::steady_clock::now();
+        }
+      }
+      GlobalDBSingleton::instance.scheduleOrRun(
+          [this]() { this->runConversion(); }, TaskPriority::BACKGROUND);
+    });
+  }
+
+public:
+  static DatabaseMaintenanceScheduler &instance() {
+    static DatabaseMaintenanceScheduler scheduler;
+    return scheduler;
+  }
+
+  // Does nothing if maintenance is already scheduled.
+  void scheduleMaintenance() {
+    if (this->maintenanceScheduled.exchange(true)) {
+      return;
+    }
+    std::call_once(this->schedulerThreadStarted, [this]() {
+      this->schedulerThread =
+          std::make_unique<WorkerThread>("database maintenance");
+    });
+    this->scheduleSlice(this->startupDelay);
+  }
+};
+
+} // namespace comm
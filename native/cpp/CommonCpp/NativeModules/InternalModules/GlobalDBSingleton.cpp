@@ -0,0 +1,196 @@
+#include "GlobalDBSingleton.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+
+namespace comm {
+
+void GlobalDBSingleton::scheduleOrRunSnapshotReadsCommonImpl(
+    openSnapshotType openSnapshot,
+    std::vector<taskType> reads,
+    taskType closeSnapshot,
+    std::function<void(std::exception_ptr)> onDone) {
+  struct SnapshotReadsState {
+    std::mutex mutex;
+    // Version observed by the first snapshot opened. Groups whose snapshot
+    // observes another one close it without running any reads.
+    std::optional<std::string> version;
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    // Shared by all read threads involved rather than copied to each.
+    std::vector<taskType> reads;
+    std::atomic<std::size_t> nextRead{0};
+    std::atomic<std::size_t> pendingGroupsCount{0};
+  };
+  auto state = std::make_shared<SnapshotReadsState>();
+  state->reads = std::move(reads);
+  std::size_t groupsCount = 0;
+  if (this->readThreadsEnabled.load()) {
+    groupsCount = std::min(state->reads.size(), this->readThreads.size());
+  }
+  // The caller holds one group until it's done scheduling, so onDone can't
+  // run before that.
+  state->pendingGroupsCount = groupsCount + 1;
+  auto recordError = [state]() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->error == nullptr) {
+      state->error = std::current_exception();
+    }
+    state->failed = true;
+  };
+  auto finishGroup = [state, onDone = std::move(onDone)]() {
+    if (--state->pendingGroupsCount == 0) {
+      std::exception_ptr error;
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        error = state->error;
+      }
+      onDone(error);
+    }
+  };
+  // The snapshot is closed and the group finished whatever the reads throw,
+  // so neither a read transaction nor the promise is left behind.
+  auto closeSnapshotAndFinishGroup = [closeSnapshot = std::move(closeSnapshot),
+                                      recordError,
+                                      finishGroup]() {
+    try {
+      closeSnapshot();
+    } catch (...) {
+      recordError();
+    }
+    finishGroup();
+  };
+
+  // Read threads don't wait for each other, so no thread is held back by a
+  // busy one. With the write-ahead log writes commit while the snapshots are
+  // being opened, and a read thread whose snapshot missed or caught one
+  // leaves the reads to the others. The first snapshot opened always runs
+  // reads, so all of them run.
+  taskType runGroup = [state,
+                       openSnapshot = std::move(openSnapshot),
+                       recordError,
+                       finishGroup,
+                       closeSnapshotAndFinishGroup]() {
+    if (state->failed || state->nextRead >= state->reads.size()) {
+      finishGroup();
+      return;
+    }
+    // Bounds the whole snapshot, as its transaction keeps the write-ahead
+    // log from being checkpointed.
+    CancellationToken deadline(GlobalDBSingleton::readTransactionTimeout);
+    CancellationScope deadlineScope(&deadline);
+    std::string version;
+    try {
+      version = openSnapshot();
+    } catch (...) {
+      recordError();
+      finishGroup();
+      return;
+    }
+    bool sameVersion;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (!state->version.has_value()) {
+        state->version = version;
+      }
+      sameVersion = state->version == version;
+    }
+    if (!sameVersion) {
+      closeSnapshotAndFinishGroup();
+      return;
+    }
+    try {
+      for (std::size_t i = state->nextRead++;
+           !state->failed && i < state->reads.size();
+           i = state->nextRead++) {
+        state->reads[i]();
+      }
+    } catch (...) {
+      recordError();
+    }
+    closeSnapshotAndFinishGroup();
+  };
+
+  std::size_t firstReadThread = this->nextReadThread.fetch_add(groupsCount);
+  std::size_t scheduledGroupsCount = 0;
+  for (std::size_t i = 0; i < groupsCount; i++) {
+    std::size_t readThreadIndex =
+        (firstReadThread + i) % this->readThreads.size();
+    Task groupTask = runGroup;
+    if (this->readThreads[readThreadIndex]->tryScheduleTask(groupTask)) {
+      scheduledGroupsCount++;
+    } else {
+      // The read thread is saturated, so its share of reads is left to the
+      // other ones.
+      finishGroup();
+    }
+  }
+  if (scheduledGroupsCount) {
+    finishGroup();
+    return;
+  }
+  // No read thread took the reads, so all of them run in a single snapshot
+  // on the database thread, which finishes the group held by the caller.
+  this->scheduleOrRunCommonImpl(std::move(runGroup), TaskPriority::INTERACTIVE);
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableSnapshotReadsCommonImpl(
+    openSnapshotType openSnapshot,
+    std::vector<taskType> reads,
+    taskType closeSnapshot,
+    taskType onDone,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken) {
+  if (this->isCancelled(cancellationToken)) {
+    jsInvoker->invokeAsync(
+        [promise]() { promise->reject(TASK_CANCELLED_FLAG); });
+    return;
+  }
+
+  std::vector<taskType> cancellableReads;
+  cancellableReads.reserve(reads.size());
+  for (taskType &read : reads) {
+    cancellableReads.push_back(
+        [this, read = std::move(read), cancellationToken]() {
+          if (!this->isCancelled(cancellationToken)) {
+            this->runInterruptibleRead(read, cancellationToken);
+          }
+        });
+  }
+  auto cancellableOnDone = [this,
+                            onDone = std::move(onDone),
+                            promise = std::move(promise),
+                            jsInvoker = std::move(jsInvoker),
+                            cancellationToken](std::exception_ptr error) {
+    if (this->isCancelled(cancellationToken)) {
+      jsInvoker->invokeAsync(
+          [promise]() { promise->reject(TASK_CANCELLED_FLAG); });
+      return;
+    }
+    if (error != nullptr) {
+      std::string errorMessage;
+      try {
+        std::rethrow_exception(error);
+      } catch (const std::exception &e) {
+        errorMessage = e.what();
+      } catch (...) {
+        errorMessage = "unknown error";
+      }
+      jsInvoker->invokeAsync(
+          [promise, errorMessage]() { promise->reject(errorMessage); });
+      return;
+    }
+    onDone();
+  };
+  this->scheduleOrRunSnapshotReadsCommonImpl(
+      std::move(openSnapshot),
+      std::move(cancellableReads),
+      std::move(closeSnapshot),
+      std::move(cancellableOnDone));
+}
+
+} // namespace comm
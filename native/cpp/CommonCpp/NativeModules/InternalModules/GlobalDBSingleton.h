@@ -1,60 +1,288 @@
 #pragma once
 
+#include "../../Tools/CancellationToken.h"
 #include "../../Tools/WorkerThread.h"
 #include <ReactCommon/TurboModuleUtils.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace comm {
 
 const std::string TASK_CANCELLED_FLAG{"TASK_CANCELLED"};
+const std::string DATABASE_BUSY_FLAG{"DATABASE_BUSY"};
+
+// Opens a snapshot of the database and returns the version of the data it
+// observes. Snapshots of equal versions observe the same data.
+using openSnapshotType = std::function<std::string()>;
+
+// Reads which have to observe the writes scheduled before them, e.g. ones the
+// caller just made, wait for those to commit. Other reads start right away
+// and may observe the data from before such writes.
+enum class ReadOrdering { ANY, AFTER_SCHEDULED_WRITES };
 
 class GlobalDBSingleton {
   std::atomic<bool> multithreadingEnabled;
   std::unique_ptr<WorkerThread> databaseThread;
   std::atomic<bool> tasksCancelled;
+  std::vector<std::unique_ptr<WorkerThread>> readThreads;
+  std::atomic<bool> readThreadsEnabled;
+  std::atomic<std::size_t> nextReadThread;
 
   GlobalDBSingleton();
 
-  void scheduleOrRunCommonImpl(const taskType task) {
+  // Once the database thread is saturated callers wait for room, rather than
+  // getting an error, which only background producers may do. Returns the
+  // sequence number of the task on the database thread, unless it ran in
+  // place.
+  std::optional<std::uint64_t> scheduleOrRunCommonImpl(
+      Task task,
+      TaskPriority priority = TaskPriority::WRITE) {
     if (this->databaseThread != nullptr) {
-      this->databaseThread->scheduleTask(task);
-      return;
+      return this->databaseThread->scheduleTaskBlocking(
+          std::move(task), priority);
     }
     task();
+    return std::nullopt;
+  }
+
+  // Callers on the JS thread must not wait for room on the database thread,
+  // so they get DATABASE_BUSY_FLAG thrown once it's saturated.
+  std::optional<std::uint64_t> scheduleOrRunWithoutWaitingCommonImpl(
+      Task task,
+      TaskPriority priority) {
+    if (this->databaseThread == nullptr) {
+      task();
+      return std::nullopt;
+    }
+    std::optional<std::uint64_t> sequenceNumber =
+        this->databaseThread->tryScheduleTask(task, priority);
+    if (!sequenceNumber.has_value()) {
+      throw std::runtime_error(DATABASE_BUSY_FLAG);
+    }
+    return sequenceNumber;
+  }
+
+  // Like scheduleOrRunWithoutWaitingCommonImpl, but returns false instead,
+  // leaving the task as it was.
+  bool tryScheduleOrRunCommonImpl(Task &task, TaskPriority priority) {
+    if (this->databaseThread == nullptr) {
+      task();
+      return true;
+    }
+    return this->databaseThread->tryScheduleTask(task, priority).has_value();
   }
 
-  void scheduleOrRunCancellableCommonImpl(const taskType task) {
+  void scheduleOrRunCancellableCommonImpl(Task task, TaskPriority priority) {
     if (this->tasksCancelled.load()) {
       throw std::runtime_error(TASK_CANCELLED_FLAG);
     }
 
-    this->scheduleOrRunCommonImpl([this, task]() {
-      if (this->tasksCancelled.load()) {
-        throw std::runtime_error(TASK_CANCELLED_FLAG);
+    this->scheduleOrRunCommonImpl(
+        [this, task = std::move(task)]() mutable {
+          if (this->tasksCancelled.load()) {
+            throw std::runtime_error(TASK_CANCELLED_FLAG);
+          }
+          task();
+        },
+        priority);
+  }
+
+  bool isCancelled(
+      const std::shared_ptr<CancellationToken> &cancellationToken) {
+    return this->tasksCancelled.load() ||
+        (cancellationToken != nullptr && cancellationToken->isCancelled());
+  }
+
+  // Runs a read with its token, so its queries are interrupted once the
+  // token is cancelled or the read runs out of time. Returns false if the
+  // read failed because the token was cancelled. Running out of time is an
+  // error the read reports like any other. Writes are never interrupted, as
+  // SQLite would roll back the whole transaction they are part of.
+  template <typename Read>
+  bool runInterruptibleRead(
+      Read &read,
+      const std::shared_ptr<CancellationToken> &cancellationToken) {
+    CancellationToken deadline(GlobalDBSingleton::readTransactionTimeout);
+    CancellationScope deadlineScope(&deadline);
+    CancellationScope cancellationScope(cancellationToken.get());
+    try {
+      read();
+    } catch (const std::exception &) {
+      if (!this->isCancelled(cancellationToken)) {
+        throw;
       }
-      task();
-    });
+      return false;
+    }
+    return true;
   }
 
   void scheduleOrRunCancellableCommonImpl(
-      const taskType task,
-      const std::shared_ptr<facebook::react::Promise> promise,
-      const std::shared_ptr<facebook::react::CallInvoker> jsInvoker) {
-    if (this->tasksCancelled.load()) {
+      Task task,
+      std::shared_ptr<facebook::react::Promise> promise,
+      std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+      std::shared_ptr<CancellationToken> cancellationToken) {
+    if (this->isCancelled(cancellationToken)) {
       jsInvoker->invokeAsync(
           [promise]() { promise->reject(TASK_CANCELLED_FLAG); });
       return;
     }
 
-    scheduleOrRunCommonImpl([this, task, promise, jsInvoker]() {
-      if (this->tasksCancelled.load()) {
+    // Promises are only created on the JS thread, which rejects the task
+    // rather than waiting for room on the database thread.
+    Task job = [this,
+                task = std::move(task),
+                promise,
+                jsInvoker,
+                cancellationToken = std::move(cancellationToken)]() mutable {
+      if (this->isCancelled(cancellationToken)) {
         jsInvoker->invokeAsync(
             [promise]() { promise->reject(TASK_CANCELLED_FLAG); });
         return;
       }
       task();
-    });
+    };
+    if (!this->tryScheduleOrRunCommonImpl(job, TaskPriority::WRITE)) {
+      jsInvoker->invokeAsync(
+          [promise]() { promise->reject(DATABASE_BUSY_FLAG); });
+    }
+  }
+
+  // Returns false if all read threads are saturated, leaving the task as it
+  // was.
+  bool tryScheduleOnReadThread(Task &task) {
+    for (std::size_t i = 0; i < this->readThreads.size(); i++) {
+      auto &readThread = this->readThreads
+          [this->nextReadThread++ % this->readThreads.size()];
+      if (readThread->tryScheduleTask(task)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Reads go straight to one of the read threads, where they run
+  // concurrently with each other and with writes. The database uses the
+  // write-ahead log, so neither holds back the other. Reads ordered after
+  // scheduled writes are routed through the database thread while it has
+  // writes to run, so they start only after those committed. Reads are
+  // scheduled from the JS thread, so rather than waiting for room this
+  // returns false if no thread has any, leaving the task as it was.
+  bool tryScheduleOrRunReadCommonImpl(Task &task, ReadOrdering ordering) {
+    bool afterWrites = ordering == ReadOrdering::AFTER_SCHEDULED_WRITES;
+    if (!this->readThreadsEnabled.load()) {
+      return this->tryScheduleOrRunCommonImpl(
+          task, afterWrites ? TaskPriority::WRITE : TaskPriority::INTERACTIVE);
+    }
+    if (afterWrites && this->databaseThread != nullptr &&
+        this->databaseThread->hasPendingTasks(TaskPriority::WRITE)) {
+      auto sharedTask = std::make_shared<Task>(std::move(task));
+      Task routedTask = [this, sharedTask]() {
+        // The database thread can't wait for room either, so the read runs
+        // in place if the read threads are saturated.
+        if (!this->tryScheduleOnReadThread(*sharedTask)) {
+          (*sharedTask)();
+        }
+      };
+      if (this->tryScheduleOrRunCommonImpl(routedTask, TaskPriority::WRITE)) {
+        return true;
+      }
+      task = std::move(*sharedTask);
+      return false;
+    }
+    if (this->tryScheduleOnReadThread(task)) {
+      return true;
+    }
+    // All read threads are saturated, so the read runs on the writer
+    // connection.
+    return this->tryScheduleOrRunCommonImpl(task, TaskPriority::INTERACTIVE);
+  }
+
+  void scheduleOrRunCancellableReadCommonImpl(Task task) {
+    if (this->tasksCancelled.load()) {
+      throw std::runtime_error(TASK_CANCELLED_FLAG);
+    }
+
+    Task read = [this, task = std::move(task)]() mutable {
+      if (this->tasksCancelled.load()) {
+        throw std::runtime_error(TASK_CANCELLED_FLAG);
+      }
+      task();
+    };
+    if (!this->tryScheduleOrRunReadCommonImpl(read, ReadOrdering::ANY)) {
+      throw std::runtime_error(DATABASE_BUSY_FLAG);
+    }
+  }
+
+  void scheduleOrRunCancellableReadCommonImpl(
+      Task task,
+      std::shared_ptr<facebook::react::Promise> promise,
+      std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+      std::shared_ptr<CancellationToken> cancellationToken,
+      ReadOrdering ordering) {
+    if (this->isCancelled(cancellationToken)) {
+      jsInvoker->invokeAsync(
+          [promise]() { promise->reject(TASK_CANCELLED_FLAG); });
+      return;
+    }
+
+    Task read = [this,
+                 task = std::move(task),
+                 promise,
+                 jsInvoker,
+                 cancellationToken = std::move(cancellationToken)]() mutable {
+      if (this->isCancelled(cancellationToken) ||
+          !this->runInterruptibleRead(task, cancellationToken)) {
+        jsInvoker->invokeAsync(
+            [promise]() { promise->reject(TASK_CANCELLED_FLAG); });
+      }
+    };
+    if (!this->tryScheduleOrRunReadCommonImpl(read, ordering)) {
+      jsInvoker->invokeAsync(
+          [promise]() { promise->reject(DATABASE_BUSY_FLAG); });
+    }
+  }
+
+  // Every read thread involved opens a snapshot, and those which observe the
+  // same version as the first one opened pick up reads until none are left.
+  // The first error thrown stops the remaining reads and is passed to
+  // `onDone`.
+  void scheduleOrRunSnapshotReadsCommonImpl(
+      openSnapshotType openSnapshot,
+      std::vector<taskType> reads,
+      taskType closeSnapshot,
+      std::function<void(std::exception_ptr)> onDone);
+
+  void scheduleOrRunCancellableSnapshotReadsCommonImpl(
+      openSnapshotType openSnapshot,
+      std::vector<taskType> reads,
+      taskType closeSnapshot,
+      taskType onDone,
+      std::shared_ptr<facebook::react::Promise> promise,
+      std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+      std::shared_ptr<CancellationToken> cancellationToken);
+
+  void enableReadThreadsCommonImpl(
+      std::size_t readThreadsCount,
+      const taskType readThreadInitializer) {
+    if (this->readThreadsEnabled.load() || !readThreadsCount) {
+      return;
+    }
+    for (std::size_t i = 0; i < readThreadsCount; i++) {
+      auto readThread = std::make_unique<WorkerThread>(
+          "database read " + std::to_string(i));
+      readThread->scheduleTask(readThreadInitializer);
+      this->readThreads.push_back(std::move(readThread));
+    }
+    this->readThreadsEnabled.store(true);
   }
 
   void enableMultithreadingCommonImpl() {
@@ -66,15 +294,100 @@ class GlobalDBSingleton {
 
 public:
   static GlobalDBSingleton instance;
-  void scheduleOrRun(const taskType task);
-  void scheduleOrRunCancellable(const taskType task);
+  // Checkpoints can't move pages of the write-ahead log past the ones a read
+  // transaction may still need, so a read running for long lets the log grow
+  // with every commit. Reads are interrupted after this long.
+  static constexpr std::chrono::milliseconds readTransactionTimeout{20000};
+  // Returns the sequence number of the task on the database thread, unless
+  // it ran in place or it's left to the main thread to schedule it later.
+  std::optional<std::uint64_t>
+  scheduleOrRun(Task task, TaskPriority priority = TaskPriority::WRITE);
+  // For callers on the JS thread, which must not wait for room on the
+  // database thread. Throws DATABASE_BUSY_FLAG once it's saturated.
+  std::optional<std::uint64_t> scheduleOrRunWithoutWaiting(
+      Task task,
+      TaskPriority priority = TaskPriority::WRITE);
   void scheduleOrRunCancellable(
-      const taskType task,
-      const std::shared_ptr<facebook::react::Promise> promise,
-      const std::shared_ptr<facebook::react::CallInvoker> jsInvoker);
+      Task task,
+      TaskPriority priority = TaskPriority::WRITE);
+  // Once the token is cancelled, or its deadline passed, the task is skipped
+  // if it hasn't started yet and the promise is rejected.
+  void scheduleOrRunCancellable(
+      Task task,
+      std::shared_ptr<facebook::react::Promise> promise,
+      std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+      std::shared_ptr<CancellationToken> cancellationToken = nullptr);
   void enableMultithreading();
+  // Read-only tasks. They run on one of the read threads once those are
+  // enabled, and on the database thread otherwise. Unlike writes, reads
+  // already running are interrupted once their token is cancelled.
+  void scheduleOrRunCancellableRead(Task task);
+  void scheduleOrRunCancellableRead(
+      Task task,
+      std::shared_ptr<facebook::react::Promise> promise,
+      std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+      std::shared_ptr<CancellationToken> cancellationToken = nullptr,
+      ReadOrdering ordering = ReadOrdering::ANY);
+  // Reads which have to observe the same data but can run in parallel, each
+  // read thread involved running them in its own snapshot. `openSnapshot`
+  // and `closeSnapshot` run on every thread involved before its first and
+  // after its last read. `onDone` runs after all reads finished.
+  void scheduleOrRunCancellableSnapshotReads(
+      openSnapshotType openSnapshot,
+      std::vector<taskType> reads,
+      taskType closeSnapshot,
+      taskType onDone,
+      std::shared_ptr<facebook::react::Promise> promise,
+      std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+      std::shared_ptr<CancellationToken> cancellationToken = nullptr);
+  void enableReadThreads(
+      std::size_t readThreadsCount,
+      const taskType readThreadInitializer);
   void setTasksCancelled(bool tasksCancelled) {
     this->tasksCancelled.store(tasksCancelled);
   }
+  bool areTasksCancelled() {
+    return this->tasksCancelled.load();
+  }
+  // No task was scheduled on the database thread after the one with the
+  // given sequence number.
+  bool isLastScheduledTask(std::uint64_t sequenceNumber) {
+    return this->databaseThread != nullptr &&
+        this->databaseThread->getScheduledTasksCount() == sequenceNumber + 1;
+  }
+  // Neither the database thread nor any read thread has tasks to run. Always
+  // false until multithreading is enabled, as tasks run in place until then.
+  bool isDatabaseThreadIdle() {
+    if (!this->multithreadingEnabled.load() ||
+        !this->databaseThread->isIdle()) {
+      return false;
+    }
+    if (!this->readThreadsEnabled.load()) {
+      return true;
+    }
+    return std::all_of(
+        this->readThreads.begin(),
+        this->readThreads.end(),
+        [](const std::unique_ptr<WorkerThread> &readThread) {
+          return readThread->isIdle();
+        });
+  }
+  // Returns once `isDatabaseThreadIdle` holds, woken up by the threads
+  // running out of tasks rather than by polling them.
+  void waitUntilDatabaseThreadIdle() {
+    while (!this->isDatabaseThreadIdle()) {
+      if (!this->multithreadingEnabled.load()) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        continue;
+      }
+      this->databaseThread->waitUntilIdle();
+      if (!this->readThreadsEnabled.load()) {
+        continue;
+      }
+      for (const auto &readThread : this->readThreads) {
+        readThread->waitUntilIdle();
+      }
+    }
+  }
 };
 } // namespace comm
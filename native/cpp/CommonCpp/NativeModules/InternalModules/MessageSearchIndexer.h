@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../../DatabaseManagers/DatabaseManager.h"
+#include "../../Tools/Logger.h"
+#include "GlobalDBSingleton.h"
+
+#include <atomic>
+
+namespace comm {
+
+// Adds messages created before the search index existed to it. Every chunk
+// is a separate background task on the database thread, so other tasks wait
+// for at most a single chunk rather than for the whole index.
+class MessageSearchIndexer {
+  const int chunkSize{1000};
+  std::atomic<bool> indexingScheduled{false};
+
+  void scheduleChunk() {
+    Task indexChunk = [this]() {
+      bool indexingDone = true;
+      try {
+        indexingDone =
+            DatabaseManager::getQueryExecutor().indexMessagesForSearch(
+                this->chunkSize);
+      } catch (const std::exception &e) {
+        Logger::log(
+            "Failed to index messages for search. Details: " +
+            std::string(e.what()));
+      }
+      if (indexingDone) {
+        this->indexingScheduled.store(false);
+        return;
+      }
+      this->scheduleChunk();
+    };
+    TaskLabelScope labelScope("indexMessagesForSearch");
+    GlobalDBSingleton::instance.scheduleOrRun(
+        std::move(indexChunk), TaskPriority::BACKGROUND);
+  }
+
+public:
+  static MessageSearchIndexer &instance() {
+    static MessageSearchIndexer indexer;
+    return indexer;
+  }
+
+  // Does nothing if all messages are already indexed.
+  void scheduleIndexing() {
+    if (this->indexingScheduled.exchange(true)) {
+      return;
+    }
+    this->scheduleChunk();
+  }
+};
+
+} // namespace comm
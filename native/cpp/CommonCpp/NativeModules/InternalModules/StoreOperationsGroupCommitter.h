@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../../DatabaseManagers/DatabaseManager.h"
+#include "../../Tools/WorkerThread.h"
+#include "ClientDBStoreSnapshotWriter.h"
+#include "GlobalDBSingleton.h"
+#include "lib.rs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+// Merges batches of store operations scheduled back-to-back, also by
+// different stores, into a single transaction, so a burst of them pays for
+// one commit and one backup log capture. A group takes batches until the
+// database thread gets to it, so it never waits for more of them. Every batch
+// runs in its own savepoint, so a failing one is rolled back alone and
+// reported only to its caller. A batch joins a group only if no other
+// database task was scheduled after the group, so all tasks still run in the
+// order they were scheduled.
+class StoreOperationsGroupCommitter {
+public:
+  struct Batch {
+    Task executeOperations;
+    // Called with an empty string if the batch was committed. Runs on the
+    // database thread, or in place if the batch was rejected right away.
+    std::function<void(const std::string &error)> onDone;
+  };
+
+private:
+  struct Group {
+    std::vector<Batch> batches;
+    // Sequence number of the database task committing the group. Unknown
+    // until the task is on the database thread's queue.
+    std::optional<std::uint64_t> scheduledTaskNumber;
+    bool closed{false};
+  };
+
+  const std::size_t maxGroupSize{64};
+  const std::string savepointName{"store_operations_batch"};
+  std::mutex mutex;
+  std::shared_ptr<Group> openGroup;
+
+  std::string runBatch(Batch &batch) {
+    if (GlobalDBSingleton::instance.areTasksCancelled()) {
+      return TASK_CANCELLED_FLAG;
+    }
+    const DatabaseQueryExecutor &executor = DatabaseManager::getQueryExecutor();
+    executor.createSavepoint(this->savepointName);
+    try {
+      batch.executeOperations();
+      executor.releaseSavepoint(this->savepointName);
+    } catch (const std::exception &e) {
+      executor.rollbackToSavepoint(this->savepointName);
+      return e.what();
+    }
+    return "";
+  }
+
+  void commitGroup(const std::shared_ptr<Group> &group) {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      group->closed = true;
+      if (this->openGroup == group) {
+        this->openGroup = nullptr;
+      }
+    }
+
+    const DatabaseQueryExecutor &executor = DatabaseManager::getQueryExecutor();
+    std::vector<std::string> errors;
+    try {
+      executor.beginTransaction();
+      try {
+        for (Batch &batch : group->batches) {
+          errors.push_back(this->runBatch(batch));
+        }
+        executor.captureBackupLogs();
+        executor.commitTransaction();
+      } catch (const std::exception &) {
+        executor.rollbackTransaction();
+        throw;
+      }
+    } catch (const std::exception &e) {
+      errors.assign(group->batches.size(), e.what());
+    }
+
+    bool anyCommitted = std::any_of(
+        errors.begin(), errors.end(), [](const std::string &error) {
+          return error.empty();
+        });
+    if (anyCommitted) {
+      ::triggerBackupFileUpload();
+      ClientDBStoreSnapshotWriter::instance().scheduleWrite();
+    }
+    for (std::size_t i = 0; i < group->batches.size(); i++) {
+      group->batches[i].onDone(errors[i]);
+    }
+  }
+
+public:
+  static StoreOperationsGroupCommitter &instance() {
+    static StoreOperationsGroupCommitter committer;
+    return committer;
+  }
+
+  void scheduleBatch(Batch &&batch) {
+    if (GlobalDBSingleton::instance.areTasksCancelled()) {
+      batch.onDone(TASK_CANCELLED_FLAG);
+      return;
+    }
+
+    auto group = std::make_shared<Group>();
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      std::shared_ptr<Group> openGroup = this->openGroup;
+      if (openGroup && !openGroup->closed &&
+          openGroup->scheduledTaskNumber.has_value() &&
+          GlobalDBSingleton::instance.isLastScheduledTask(
+              openGroup->scheduledTaskNumber.value())) {
+        openGroup->batches.push_back(std::move(batch));
+        if (openGroup->batches.size() >= this->maxGroupSize) {
+          openGroup->closed = true;
+        }
+        return;
+      }
+      if (openGroup) {
+        // Other tasks were scheduled after it, so batches joining it would
+        // run before them.
+        openGroup->closed = true;
+      }
+      group->batches.push_back(std::move(batch));
+      this->openGroup = group;
+    }
+
+    // Batches are scheduled from the JS thread, so once the database thread
+    // is saturated the batch is rejected rather than waiting for room.
+    std::optional<std::uint64_t> scheduledTaskNumber;
+    try {
+      scheduledTaskNumber =
+          GlobalDBSingleton::instance.scheduleOrRunWithoutWaiting(
+              [this, group]() { this->commitGroup(group); });
+    } catch (const std::exception &e) {
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        group->closed = true;
+        if (this->openGroup == group) {
+          this->openGroup = nullptr;
+        }
+      }
+      group->batches.front().onDone(e.what());
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    group->scheduledTaskNumber = scheduledTaskNumber;
+  }
+};
+
+} // namespace comm
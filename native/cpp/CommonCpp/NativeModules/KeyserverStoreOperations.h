@@ -2,12 +2,14 @@
 
 #include "../DatabaseManagers/entities/KeyserverInfo.h"
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
 #include <vector>
 
 namespace comm {
 class KeyserverStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~KeyserverStoreOperationBase(){};
 };
 
@@ -20,6 +22,10 @@ public:
     DatabaseManager::getQueryExecutor().removeKeyservers(this->ids);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Remove, "keyservers", this->ids};
+  }
+
 private:
   std::vector<std::string> ids;
 };
@@ -34,6 +40,13 @@ public:
     DatabaseManager::getQueryExecutor().replaceKeyserver(this->keyserver);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {
+        StoreOperationEffect::Type::Replace,
+        "keyservers",
+        {this->keyserver.id}};
+  }
+
 private:
   KeyserverInfo keyserver;
 };
@@ -43,6 +56,10 @@ public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllKeyservers();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "keyservers"};
+  }
 };
 
 } // namespace comm
@@ -3,12 +3,15 @@
 #include "../DatabaseManagers/entities/Media.h"
 #include "../DatabaseManagers/entities/Message.h"
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
+#include <unordered_map>
 #include <vector>
 
 namespace comm {
 class MessageStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~MessageStoreOperationBase(){};
 };
 
@@ -29,6 +32,13 @@ public:
         this->msg_ids_to_remove);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {
+        StoreOperationEffect::Type::Remove,
+        "messages",
+        this->msg_ids_to_remove};
+  }
+
 private:
   std::vector<std::string> msg_ids_to_remove;
 };
@@ -53,15 +63,19 @@ public:
     DatabaseManager::getQueryExecutor().removeMediaForThreads(this->thread_ids);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Other, "messages"};
+  }
+
 private:
   std::vector<std::string> thread_ids;
 };
 
-class ReplaceMessageOperation : public MessageStoreOperationBase {
+// Consecutive replace operations are merged into a single batch, so that
+// messages and media are written with multi-row statements.
+class ReplaceMessagesOperation : public MessageStoreOperationBase {
 public:
-  ReplaceMessageOperation(jsi::Runtime &rt, const jsi::Object &payload)
-      : media_vector{} {
-
+  void addMessage(jsi::Runtime &rt, const jsi::Object &payload) {
     auto msg_id = payload.getProperty(rt, "id").asString(rt).utf8(rt);
 
     auto maybe_local_id = payload.getProperty(rt, "local_id");
@@ -88,7 +102,7 @@ public:
     auto time =
         std::stoll(payload.getProperty(rt, "time").asString(rt).utf8(rt));
 
-    this->msg = std::make_unique<Message>(Message{
+    this->msgs.push_back(Message{
         msg_id,
         std::move(local_id),
         thread,
@@ -98,6 +112,7 @@ public:
         std::move(content),
         time});
 
+    std::vector<Media> media_vector;
     if (payload.getProperty(rt, "media_infos").isObject()) {
       auto media_infos =
           payload.getProperty(rt, "media_infos").asObject(rt).asArray(rt);
@@ -114,23 +129,53 @@ public:
         auto media_extras =
             media_info.getProperty(rt, "extras").asString(rt).utf8(rt);
 
-        this->media_vector.push_back(std::make_unique<Media>(Media{
-            media_id, msg_id, thread, media_uri, media_type, media_extras}));
+        media_vector.push_back(Media{
+            media_id, msg_id, thread, media_uri, media_type, media_extras});
       }
     }
+    this->media_vectors.push_back(std::move(media_vector));
   }
 
   virtual void execute() override {
-    DatabaseManager::getQueryExecutor().removeMediaForMessage(msg->id);
-    for (auto &&media : this->media_vector) {
-      DatabaseManager::getQueryExecutor().replaceMedia(std::move(*media));
+    // When a message is replaced more than once in the batch only its last
+    // replacement is written, which matches executing the replacements one
+    // by one.
+    std::unordered_map<std::string, size_t> last_replacement_idx;
+    for (size_t idx = 0; idx < this->msgs.size(); idx++) {
+      last_replacement_idx[this->msgs[idx].id] = idx;
+    }
+
+    std::vector<std::string> msg_ids;
+    std::vector<Message> msgs_to_replace;
+    std::vector<Media> medias_to_replace;
+    for (size_t idx = 0; idx < this->msgs.size(); idx++) {
+      if (last_replacement_idx[this->msgs[idx].id] != idx) {
+        continue;
+      }
+      msg_ids.push_back(this->msgs[idx].id);
+      msgs_to_replace.push_back(std::move(this->msgs[idx]));
+      for (auto &&media : this->media_vectors[idx]) {
+        medias_to_replace.push_back(std::move(media));
+      }
+    }
+
+    DatabaseManager::getQueryExecutor().removeMediaForMessages(msg_ids);
+    DatabaseManager::getQueryExecutor().replaceMedias(medias_to_replace);
+    DatabaseManager::getQueryExecutor().replaceMessages(msgs_to_replace);
+  }
+
+  virtual StoreOperationEffect getEffect() const override {
+    StoreOperationEffect effect{
+        StoreOperationEffect::Type::Replace, "messages"};
+    for (const Message &msg : this->msgs) {
+      effect.keys.push_back(msg.id);
     }
-    DatabaseManager::getQueryExecutor().replaceMessage(std::move(*this->msg));
+    return effect;
   }
 
 private:
-  std::unique_ptr<Message> msg;
-  std::vector<std::unique_ptr<Media>> media_vector;
+  std::vector<Message> msgs;
+  std::vector<std::vector<Media>> media_vectors;
 };
 
 class RekeyMessageOperation : public MessageStoreOperationBase {
@@ -146,6 +191,10 @@ public:
         this->from, this->to);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Other, "messages"};
+  }
+
 private:
   std::string from;
   std::string to;
@@ -157,6 +206,10 @@ public:
     DatabaseManager::getQueryExecutor().removeAllMessages();
     DatabaseManager::getQueryExecutor().removeAllMedia();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "messages"};
+  }
 };
 
 class ReplaceMessageThreadsOperation : public MessageStoreOperationBase {
@@ -181,6 +234,15 @@ public:
         this->msg_threads);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    StoreOperationEffect effect{
+        StoreOperationEffect::Type::Replace, "message_store_threads"};
+    for (const MessageStoreThread &msg_thread : this->msg_threads) {
+      effect.keys.push_back(msg_thread.id);
+    }
+    return effect;
+  }
+
 private:
   std::vector<MessageStoreThread> msg_threads;
 };
@@ -190,6 +252,10 @@ public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllMessageStoreThreads();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "message_store_threads"};
+  }
 };
 
 class RemoveMessageStoreThreadsOperation : public MessageStoreOperationBase {
@@ -210,6 +276,13 @@ public:
         this->thread_ids);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {
+        StoreOperationEffect::Type::Remove,
+        "message_store_threads",
+        this->thread_ids};
+  }
+
 private:
   std::vector<std::string> thread_ids;
 };
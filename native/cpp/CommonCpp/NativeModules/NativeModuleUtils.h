@@ -3,7 +3,11 @@
 #include "InternalModules/GlobalDBSingleton.h"
 
 #include <jsi/jsi.h>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <mutex>
+#include <thread>
 
 namespace comm {
 
@@ -35,6 +39,93 @@ public:
       throw jsi::JSError(rt, e.what());
     }
   }
+
+  // Like runSyncOrThrowJSError, but the database thread hands over its
+  // result in chunks which are consumed on the calling thread while the
+  // next ones are still being produced. At most `maxPendingChunks` chunks
+  // are buffered at any time, so peak memory stays bounded regardless of
+  // the total size of the result.
+  template <class T>
+  static void runSyncChunkedOrThrowJSError(
+      jsi::Runtime &rt,
+      std::function<void(const std::function<void(T &&)> &)> produce,
+      std::function<void(T &&)> consume,
+      std::size_t maxPendingChunks = 2) {
+    struct Channel {
+      std::mutex mutex;
+      std::condition_variable condition;
+      std::deque<T> chunks;
+      bool finished = false;
+      bool abandoned = false;
+      std::exception_ptr error;
+    };
+    auto channel = std::make_shared<Channel>();
+    const auto consumerThreadID = std::this_thread::get_id();
+
+    GlobalDBSingleton::instance.scheduleOrRunCancellable(
+        [channel, consumerThreadID, maxPendingChunks, produce, &consume]() {
+          std::exception_ptr error;
+          try {
+            if (std::this_thread::get_id() == consumerThreadID) {
+              // There is no database thread yet, so the task runs inline
+              // and can feed the consumer directly.
+              produce(consume);
+            } else {
+              produce([&channel, maxPendingChunks](T &&chunk) {
+                std::unique_lock<std::mutex> lock(channel->mutex);
+                channel->condition.wait(lock, [&channel, maxPendingChunks]() {
+                  return channel->chunks.size() < maxPendingChunks ||
+                      channel->abandoned;
+                });
+                if (channel->abandoned) {
+                  throw std::runtime_error("Chunk consumer failed.");
+                }
+                channel->chunks.push_back(std::move(chunk));
+                channel->condition.notify_all();
+              });
+            }
+          } catch (const std::exception &e) {
+            error = std::make_exception_ptr(std::runtime_error(e.what()));
+          }
+          std::lock_guard<std::mutex> lock(channel->mutex);
+          channel->error = error;
+          channel->finished = true;
+          channel->condition.notify_all();
+        });
+
+    while (true) {
+      std::unique_lock<std::mutex> lock(channel->mutex);
+      channel->condition.wait(lock, [&channel]() {
+        return !channel->chunks.empty() || channel->finished;
+      });
+      if (channel->chunks.empty()) {
+        break;
+      }
+      T chunk = std::move(channel->chunks.front());
+      channel->chunks.pop_front();
+      lock.unlock();
+      channel->condition.notify_all();
+      try {
+        consume(std::move(chunk));
+      } catch (...) {
+        // Unblock the database thread so that it stops producing. It only
+        // touches `consume` when running inline, so we can leave right away.
+        std::lock_guard<std::mutex> abandonLock(channel->mutex);
+        channel->abandoned = true;
+        channel->chunks.clear();
+        channel->condition.notify_all();
+        throw;
+      }
+    }
+
+    if (channel->error) {
+      try {
+        std::rethrow_exception(channel->error);
+      } catch (const std::exception &e) {
+        throw jsi::JSError(rt, e.what());
+      }
+    }
+  }
 };
 
 } // namespace comm
@@ -3,6 +3,7 @@
 #include "GlobalDBSingleton.h"
 #include "Logger.h"
 #include "RustPromiseManager.h"
+#include "TaskTelemetry.h"
 #include "WorkerThread.h"
 #include "lib.rs.h"
 
@@ -10,7 +11,8 @@ namespace comm {
 void BackupOperationsExecutor::createMainCompaction(
     std::string backupID,
     size_t futureID) {
-  taskType job = [backupID, futureID]() {
+  TaskLabelScope taskLabelScope(__func__);
+  Task job = [backupID, futureID]() {
     try {
       DatabaseManager::getQueryExecutor().createMainCompaction(backupID);
       ::resolveUnitFuture(futureID);
@@ -20,14 +22,18 @@ void BackupOperationsExecutor::createMainCompaction(
           "Main compaction creation failed. Details: " + std::string(e.what()));
     }
   };
-  GlobalDBSingleton::instance.scheduleOrRunCancellable(job);
+  // It copies the database as of when it runs, so it can wait for other
+  // tasks.
+  GlobalDBSingleton::instance.scheduleOrRunCancellable(
+      std::move(job), TaskPriority::BACKGROUND);
 }
 
 void BackupOperationsExecutor::restoreFromMainCompaction(
     std::string mainCompactionPath,
     std::string mainCompactionEncryptionKey,
     size_t futureID) {
-  taskType job = [mainCompactionPath, mainCompactionEncryptionKey, futureID]() {
+  TaskLabelScope taskLabelScope(__func__);
+  Task job = [mainCompactionPath, mainCompactionEncryptionKey, futureID]() {
     try {
       DatabaseManager::getQueryExecutor().restoreFromMainCompaction(
           mainCompactionPath, mainCompactionEncryptionKey);
@@ -39,13 +45,14 @@ void BackupOperationsExecutor::restoreFromMainCompaction(
       ::rejectFuture(futureID, errorDetails);
     }
   };
-  GlobalDBSingleton::instance.scheduleOrRunCancellable(job);
+  GlobalDBSingleton::instance.scheduleOrRunCancellable(std::move(job));
 }
 
 void BackupOperationsExecutor::restoreFromBackupLog(
     const std::vector<std::uint8_t> &backupLog,
     size_t futureID) {
-  taskType job = [backupLog, futureID]() {
+  TaskLabelScope taskLabelScope(__func__);
+  Task job = [backupLog, futureID]() {
     try {
       DatabaseManager::getQueryExecutor().restoreFromBackupLog(backupLog);
       ::resolveUnitFuture(futureID);
@@ -55,6 +62,6 @@ void BackupOperationsExecutor::restoreFromBackupLog(
       ::rejectFuture(futureID, errorDetails);
     }
   };
-  GlobalDBSingleton::instance.scheduleOrRunCancellable(job);
+  GlobalDBSingleton::instance.scheduleOrRunCancellable(std::move(job));
 }
 } // namespace comm
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "ClientDBStoreSnapshotWriter.h"
 #include "DatabaseManager.h"
 #include "GlobalDBSingleton.h"
 #include "NativeModuleUtils.h"
+#include "StoreOperationCompaction.h"
+#include "StoreOperationsGroupCommitter.h"
 #include "WorkerThread.h"
 #include "lib.rs.h"
 
@@ -40,6 +43,7 @@ public:
 
     try {
       auto storeOps = createOperations(rt, operations);
+      compactStoreOperations(storeOps);
       storeOpsPtr = std::make_shared<std::vector<std::unique_ptr<Operation>>>(
           std::move(storeOps));
     } catch (std::runtime_error &e) {
@@ -50,28 +54,9 @@ public:
         rt,
         [=](jsi::Runtime &innerRt,
             std::shared_ptr<facebook::react::Promise> promise) {
-          taskType job = [=]() {
-            std::string error = createOperationsError;
-
-            if (!error.size()) {
-              try {
-                DatabaseManager::getQueryExecutor().beginTransaction();
-                for (const auto &operation : *storeOpsPtr) {
-                  operation->execute();
-                }
-                DatabaseManager::getQueryExecutor().captureBackupLogs();
-                DatabaseManager::getQueryExecutor().commitTransaction();
-              } catch (std::system_error &e) {
-                error = e.what();
-                DatabaseManager::getQueryExecutor().rollbackTransaction();
-              }
-            }
-
-            if (!error.size()) {
-              ::triggerBackupFileUpload();
-            }
-
-            this->jsInvoker->invokeAsync([=]() {
+          auto jsInvoker = this->jsInvoker;
+          auto onDone = [jsInvoker, promise](const std::string &error) {
+            jsInvoker->invokeAsync([=]() {
               if (error.size()) {
                 promise->reject(error);
               } else {
@@ -79,8 +64,19 @@ public:
               }
             });
           };
-          GlobalDBSingleton::instance.scheduleOrRunCancellable(
-              job, promise, this->jsInvoker);
+
+          if (createOperationsError.size()) {
+            onDone(createOperationsError);
+            return;
+          }
+
+          Task executeOperations = [storeOpsPtr]() {
+            for (const auto &operation : *storeOpsPtr) {
+              operation->execute();
+            }
+          };
+          StoreOperationsGroupCommitter::instance().scheduleBatch(
+              {std::move(executeOperations), std::move(onDone)});
         });
   }
 
@@ -89,6 +85,7 @@ public:
 
     try {
       storeOps = createOperations(rt, operations);
+      compactStoreOperations(storeOps);
     } catch (const std::exception &e) {
       throw jsi::JSError(rt, e.what());
     }
@@ -112,6 +109,7 @@ public:
         throw std::runtime_error(error);
       } else if (!error.size()) {
         ::triggerBackupFileUpload();
+        ClientDBStoreSnapshotWriter::instance().scheduleWrite();
       }
     });
   }
@@ -29,48 +29,55 @@ jsi::Array MessageStore::parseDBDataStore(
   size_t numMessages = messagesVectorPtr->size();
   jsi::Array jsiMessages = jsi::Array(rt, numMessages);
   size_t writeIndex = 0;
-  for (const auto &[message, media] : *messagesVectorPtr) {
-    auto jsiMessage = jsi::Object(rt);
-    jsiMessage.setProperty(rt, "id", message.id);
-
-    if (message.local_id) {
-      auto local_id = message.local_id.get();
-      jsiMessage.setProperty(rt, "local_id", *local_id);
-    }
-
-    jsiMessage.setProperty(rt, "thread", message.thread);
-    jsiMessage.setProperty(rt, "user", message.user);
-    jsiMessage.setProperty(rt, "type", std::to_string(message.type));
+  for (const auto &messageEntity : *messagesVectorPtr) {
+    jsiMessages.setValueAtIndex(
+        rt, writeIndex++, this->parseDBMessage(rt, messageEntity));
+  }
+  return jsiMessages;
+}
 
-    if (message.future_type) {
-      auto future_type = message.future_type.get();
-      jsiMessage.setProperty(rt, "future_type", std::to_string(*future_type));
-    }
+jsi::Object MessageStore::parseDBMessage(
+    jsi::Runtime &rt,
+    const MessageEntity &messageEntity) const {
+  const auto &[message, media] = messageEntity;
+  auto jsiMessage = jsi::Object(rt);
+  jsiMessage.setProperty(rt, "id", message.id);
+
+  if (message.local_id) {
+    auto local_id = message.local_id.get();
+    jsiMessage.setProperty(rt, "local_id", *local_id);
+  }
 
-    if (message.content) {
-      auto content = message.content.get();
-      jsiMessage.setProperty(rt, "content", *content);
-    }
+  jsiMessage.setProperty(rt, "thread", message.thread);
+  jsiMessage.setProperty(rt, "user", message.user);
+  jsiMessage.setProperty(rt, "type", std::to_string(message.type));
 
-    jsiMessage.setProperty(rt, "time", std::to_string(message.time));
+  if (message.future_type) {
+    auto future_type = message.future_type.get();
+    jsiMessage.setProperty(rt, "future_type", std::to_string(*future_type));
+  }
 
-    size_t media_idx = 0;
-    jsi::Array jsiMediaArray = jsi::Array(rt, media.size());
-    for (const auto &media_info : media) {
-      auto jsiMedia = jsi::Object(rt);
-      jsiMedia.setProperty(rt, "id", media_info.id);
-      jsiMedia.setProperty(rt, "uri", media_info.uri);
-      jsiMedia.setProperty(rt, "type", media_info.type);
-      jsiMedia.setProperty(rt, "extras", media_info.extras);
+  if (message.content) {
+    auto content = message.content.get();
+    jsiMessage.setProperty(rt, "content", *content);
+  }
 
-      jsiMediaArray.setValueAtIndex(rt, media_idx++, jsiMedia);
-    }
+  jsiMessage.setProperty(rt, "time", std::to_string(message.time));
 
-    jsiMessage.setProperty(rt, "media_infos", jsiMediaArray);
+  size_t media_idx = 0;
+  jsi::Array jsiMediaArray = jsi::Array(rt, media.size());
+  for (const auto &media_info : media) {
+    auto jsiMedia = jsi::Object(rt);
+    jsiMedia.setProperty(rt, "id", media_info.id);
+    jsiMedia.setProperty(rt, "uri", media_info.uri);
+    jsiMedia.setProperty(rt, "type", media_info.type);
+    jsiMedia.setProperty(rt, "extras", media_info.extras);
 
-    jsiMessages.setValueAtIndex(rt, writeIndex++, jsiMessage);
+    jsiMediaArray.setValueAtIndex(rt, media_idx++, jsiMedia);
   }
-  return jsiMessages;
+
+  jsiMessage.setProperty(rt, "media_infos", jsiMediaArray);
+  return jsiMessage;
 }
 
 std::vector<std::unique_ptr<MessageStoreOperationBase>>
@@ -78,11 +85,24 @@ MessageStore::createOperations(jsi::Runtime &rt, const jsi::Array &operations)
     const {
 
   std::vector<std::unique_ptr<MessageStoreOperationBase>> messageStoreOps;
+  ReplaceMessagesOperation *replaceMessagesBatch = nullptr;
 
   for (auto idx = 0; idx < operations.size(rt); idx++) {
     auto op = operations.getValueAtIndex(rt, idx).asObject(rt);
     auto op_type = op.getProperty(rt, "type").asString(rt).utf8(rt);
 
+    if (op_type == REPLACE_OPERATION) {
+      if (!replaceMessagesBatch) {
+        auto replaceMessagesOp = std::make_unique<ReplaceMessagesOperation>();
+        replaceMessagesBatch = replaceMessagesOp.get();
+        messageStoreOps.push_back(std::move(replaceMessagesOp));
+      }
+      auto payload_obj = op.getProperty(rt, "payload").asObject(rt);
+      replaceMessagesBatch->addMessage(rt, payload_obj);
+      continue;
+    }
+    replaceMessagesBatch = nullptr;
+
     if (op_type == REMOVE_ALL_OPERATION) {
       messageStoreOps.push_back(std::make_unique<RemoveAllMessagesOperation>());
       continue;
@@ -102,10 +122,6 @@ MessageStore::createOperations(jsi::Runtime &rt, const jsi::Array &operations)
       messageStoreOps.push_back(
           std::make_unique<RemoveMessagesForThreadsOperation>(rt, payload_obj));
 
-    } else if (op_type == REPLACE_OPERATION) {
-      messageStoreOps.push_back(
-          std::make_unique<ReplaceMessageOperation>(rt, payload_obj));
-
     } else if (op_type == REKEY_OPERATION) {
       messageStoreOps.push_back(
           std::make_unique<RekeyMessageOperation>(rt, payload_obj));
@@ -9,8 +9,6 @@
 
 namespace comm {
 
-using MessageEntity = std::pair<Message, std::vector<Media>>;
-
 class MessageStore
     : public BaseDataStore<MessageStoreOperationBase, MessageEntity> {
 private:
@@ -35,6 +33,9 @@ public:
       jsi::Runtime &rt,
       std::shared_ptr<std::vector<MessageEntity>> dataVectorPtr) const override;
 
+  jsi::Object
+  parseDBMessage(jsi::Runtime &rt, const MessageEntity &messageEntity) const;
+
   jsi::Array parseDBMessageStoreThreads(
       jsi::Runtime &rt,
       std::shared_ptr<std::vector<MessageStoreThread>> threadsVectorPtr) const;
@@ -8,6 +8,7 @@ namespace comm {
 OperationType ThreadStore::REMOVE_OPERATION = "remove";
 OperationType ThreadStore::REMOVE_ALL_OPERATION = "remove_all";
 OperationType ThreadStore::REPLACE_OPERATION = "replace";
+OperationType ThreadStore::PATCH_OPERATION = "patch";
 
 ThreadStore::ThreadStore(
     std::shared_ptr<facebook::react::CallInvoker> jsInvoker)
@@ -188,6 +189,29 @@ ThreadStore::createOperations(jsi::Runtime &rt, const jsi::Array &operations)
 
       threadStoreOps.push_back(
           std::make_unique<ReplaceThreadOperation>(std::move(thread)));
+    } else if (opType == PATCH_OPERATION) {
+      jsi::Object patchObj = op.getProperty(rt, "payload").asObject(rt);
+      ThreadPatch patch;
+      patch.id = patchObj.getProperty(rt, "id").asString(rt).utf8(rt);
+
+      jsi::Value maybeCurrentUser = patchObj.getProperty(rt, "currentUser");
+      patch.current_user = maybeCurrentUser.isString()
+          ? std::make_unique<std::string>(
+                maybeCurrentUser.asString(rt).utf8(rt))
+          : nullptr;
+
+      jsi::Value maybeRoles = patchObj.getProperty(rt, "roles");
+      patch.roles = maybeRoles.isString()
+          ? std::make_unique<std::string>(maybeRoles.asString(rt).utf8(rt))
+          : nullptr;
+
+      jsi::Value maybeMembers = patchObj.getProperty(rt, "members");
+      patch.members = maybeMembers.isString()
+          ? std::make_unique<std::string>(maybeMembers.asString(rt).utf8(rt))
+          : nullptr;
+
+      threadStoreOps.push_back(
+          std::make_unique<PatchThreadOperation>(std::move(patch)));
     } else {
       throw std::runtime_error("unsupported operation: " + opType);
     }
@@ -13,6 +13,7 @@ private:
   static OperationType REMOVE_OPERATION;
   static OperationType REMOVE_ALL_OPERATION;
   static OperationType REPLACE_OPERATION;
+  static OperationType PATCH_OPERATION;
 
 public:
   ThreadStore(std::shared_ptr<facebook::react::CallInvoker> jsInvoker);
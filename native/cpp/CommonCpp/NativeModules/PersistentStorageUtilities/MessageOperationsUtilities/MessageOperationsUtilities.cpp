@@ -111,13 +111,16 @@ void MessageOperationsUtilities::storeMessageInfos(
     std::string &rawMessageInfosString) {
   std::vector<ClientDBMessageInfo> clientDBMessageInfos =
       translateStringToClientDBMessageInfos(rawMessageInfosString);
-  for (const auto &clientDBMessageInfo : clientDBMessageInfos) {
-    DatabaseManager::getQueryExecutor().replaceMessage(
-        clientDBMessageInfo.first);
-    for (const auto &mediaInfo : clientDBMessageInfo.second) {
-      DatabaseManager::getQueryExecutor().replaceMedia(mediaInfo);
+  const DatabaseQueryExecutor &queryExecutor =
+      DatabaseManager::getQueryExecutor();
+  queryExecutor.runInTransaction([&]() {
+    for (const auto &clientDBMessageInfo : clientDBMessageInfos) {
+      queryExecutor.replaceMessage(clientDBMessageInfo.first);
+      for (const auto &mediaInfo : clientDBMessageInfo.second) {
+        queryExecutor.replaceMedia(mediaInfo);
+      }
     }
-  }
+  });
 }
 
 } // namespace comm
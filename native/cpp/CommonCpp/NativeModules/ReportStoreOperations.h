@@ -3,12 +3,14 @@
 #include "../DatabaseManagers/entities/Media.h"
 #include "../DatabaseManagers/entities/Report.h"
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
 #include <vector>
 
 namespace comm {
 class ReportStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~ReportStoreOperationBase(){};
 };
 
@@ -27,6 +29,10 @@ public:
     DatabaseManager::getQueryExecutor().removeReports(this->ids_to_remove);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Remove, "reports", this->ids_to_remove};
+  }
+
 private:
   std::vector<std::string> ids_to_remove;
 };
@@ -43,6 +49,10 @@ public:
     DatabaseManager::getQueryExecutor().replaceReport(std::move(*this->report));
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Replace, "reports", {this->report->id}};
+  }
+
 private:
   std::unique_ptr<Report> report;
 };
@@ -52,6 +62,10 @@ public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllReports();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "reports"};
+  }
 };
 
 } // namespace comm
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace comm {
+
+// What a store operation does to the rows of a table, so operations made
+// redundant by later ones in the same batch can be dropped.
+struct StoreOperationEffect {
+  enum class Type {
+    // Anything not described below, e.g. rekeying rows. Later operations
+    // never make the ones before it redundant.
+    Other,
+    // Writes the rows with the given keys regardless of their content.
+    Replace,
+    // Updates the rows with the given keys based on their content.
+    Patch,
+    Remove,
+    RemoveAll,
+  };
+
+  Type type{Type::Other};
+  // Operations on different tables never make each other redundant.
+  std::string table;
+  std::vector<std::string> keys;
+};
+
+// Counts of store operations received from JS and of the ones executed after
+// compaction, summed over all stores.
+class StoreOperationsCompactionStats {
+  std::atomic<std::uint64_t> operationsCount{0};
+  std::atomic<std::uint64_t> executedOperationsCount{0};
+
+public:
+  static StoreOperationsCompactionStats &instance() {
+    static StoreOperationsCompactionStats stats;
+    return stats;
+  }
+
+  void add(std::size_t operationsCount, std::size_t executedOperationsCount) {
+    this->operationsCount += operationsCount;
+    this->executedOperationsCount += executedOperationsCount;
+  }
+
+  std::uint64_t getOperationsCount() const {
+    return this->operationsCount.load();
+  }
+
+  std::uint64_t getExecutedOperationsCount() const {
+    return this->executedOperationsCount.load();
+  }
+};
+
+// Drops operations whose effect is entirely undone by later ones: writes to
+// rows that are replaced or removed later, and everything before a
+// `RemoveAll` of the same table. The remaining operations keep their order,
+// so executing them leaves the database in the same state as executing all
+// of them.
+template <typename Operation>
+void compactStoreOperations(
+    std::vector<std::unique_ptr<Operation>> &operations) {
+  struct TableState {
+    bool removedAll{false};
+    // Rows written by later operations, with no `Other` operation in between.
+    std::unordered_set<std::string> overwrittenKeys;
+  };
+  std::unordered_map<std::string, TableState> tables;
+  std::vector<bool> redundant(operations.size(), false);
+
+  for (std::size_t i = operations.size(); i-- > 0;) {
+    StoreOperationEffect effect = operations[i]->getEffect();
+    TableState &state = tables[effect.table];
+    if (state.removedAll) {
+      redundant[i] = true;
+      continue;
+    }
+
+    bool allKeysOverwritten = true;
+    for (const std::string &key : effect.keys) {
+      if (!state.overwrittenKeys.count(key)) {
+        allKeysOverwritten = false;
+        break;
+      }
+    }
+
+    switch (effect.type) {
+      case StoreOperationEffect::Type::Other:
+        state.overwrittenKeys.clear();
+        break;
+      case StoreOperationEffect::Type::RemoveAll:
+        state.removedAll = true;
+        break;
+      case StoreOperationEffect::Type::Patch:
+        redundant[i] = allKeysOverwritten;
+        break;
+      case StoreOperationEffect::Type::Replace:
+      case StoreOperationEffect::Type::Remove:
+        redundant[i] = allKeysOverwritten;
+        state.overwrittenKeys.insert(effect.keys.begin(), effect.keys.end());
+        break;
+    }
+  }
+
+  std::size_t operationsCount = operations.size();
+  std::size_t keptCount = 0;
+  for (std::size_t i = 0; i < operationsCount; i++) {
+    if (!redundant[i]) {
+      operations[keptCount++] = std::move(operations[i]);
+    }
+  }
+  operations.resize(keptCount);
+  StoreOperationsCompactionStats::instance().add(operationsCount, keptCount);
+}
+
+} // namespace comm
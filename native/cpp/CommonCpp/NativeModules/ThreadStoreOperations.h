@@ -2,13 +2,16 @@
 
 #include "../DatabaseManagers/entities/Media.h"
 #include "../DatabaseManagers/entities/Thread.h"
+#include "../DatabaseManagers/entities/ThreadPatch.h"
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
 #include <vector>
 
 namespace comm {
 class ThreadStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~ThreadStoreOperationBase(){};
 };
 
@@ -21,6 +24,10 @@ public:
     DatabaseManager::getQueryExecutor().removeThreads(this->ids);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Remove, "threads", this->ids};
+  }
+
 private:
   std::vector<std::string> ids;
 };
@@ -34,15 +41,40 @@ public:
     DatabaseManager::getQueryExecutor().replaceThread(this->thread);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Replace, "threads", {this->thread.id}};
+  }
+
 private:
   Thread thread;
 };
 
+class PatchThreadOperation : public ThreadStoreOperationBase {
+public:
+  PatchThreadOperation(ThreadPatch &&patch) : patch{std::move(patch)} {
+  }
+
+  virtual void execute() override {
+    DatabaseManager::getQueryExecutor().patchThread(this->patch);
+  }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Patch, "threads", {this->patch.id}};
+  }
+
+private:
+  ThreadPatch patch;
+};
+
 class RemoveAllThreadsOperation : public ThreadStoreOperationBase {
 public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllThreads();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "threads"};
+  }
 };
 
 } // namespace comm
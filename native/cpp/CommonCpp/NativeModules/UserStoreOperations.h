@@ -2,12 +2,14 @@
 
 #include "../DatabaseManagers/entities/UserInfo.h"
 #include "DatabaseManager.h"
+#include "StoreOperationCompaction.h"
 #include <vector>
 
 namespace comm {
 class UserStoreOperationBase {
 public:
   virtual void execute() = 0;
+  virtual StoreOperationEffect getEffect() const = 0;
   virtual ~UserStoreOperationBase(){};
 };
 
@@ -20,6 +22,10 @@ public:
     DatabaseManager::getQueryExecutor().removeUsers(this->ids);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Remove, "users", this->ids};
+  }
+
 private:
   std::vector<std::string> ids;
 };
@@ -33,6 +39,10 @@ public:
     DatabaseManager::getQueryExecutor().replaceUser(this->user);
   }
 
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::Replace, "users", {this->user.id}};
+  }
+
 private:
   UserInfo user;
 };
@@ -42,6 +52,10 @@ public:
   virtual void execute() override {
     DatabaseManager::getQueryExecutor().removeAllUsers();
   }
+
+  virtual StoreOperationEffect getEffect() const override {
+    return {StoreOperationEffect::Type::RemoveAll, "users"};
+  }
 };
 
 } // namespace comm
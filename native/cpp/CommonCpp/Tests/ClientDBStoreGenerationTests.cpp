@@ -0,0 +1,101 @@
+#include "HostDataDirectory.h"
+#include "SQLiteQueryExecutor.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace comm {
+
+// Every test starts from a freshly migrated, empty database, reopened the way
+// it is on every launch after the first one.
+class ClientDBStoreGenerationTest : public testing::Test {
+protected:
+  std::string databasePath =
+      (getHostDataDirectory() / "comm-tests.sqlite").string();
+  std::unique_ptr<SQLiteQueryExecutor> executor;
+
+  void SetUp() override {
+    SQLiteQueryExecutor::initialize(this->databasePath);
+    SQLiteQueryExecutor::clearSensitiveData();
+    {
+      // Closes the connection the database was created with once destroyed.
+      SQLiteQueryExecutor creator;
+    }
+    this->executor = std::make_unique<SQLiteQueryExecutor>(this->databasePath);
+  }
+
+  void TearDown() override {
+    this->executor.reset();
+  }
+
+  std::uint64_t getGeneration() const {
+    std::string generation =
+        this->executor->getMetadata("client_db_store_generation");
+    return generation.size() ? std::stoull(generation) : 0;
+  }
+};
+
+TEST_F(ClientDBStoreGenerationTest, RowWriteBumpsGeneration) {
+  std::uint64_t generation = this->getGeneration();
+  this->executor->runInTransaction(
+      [this]() { this->executor->updateDraft("key", "text"); });
+  EXPECT_NE(this->getGeneration(), generation);
+}
+
+TEST_F(ClientDBStoreGenerationTest, AutocommitWriteBumpsGeneration) {
+  std::uint64_t generation = this->getGeneration();
+  this->executor->updateDraft("key", "text");
+  EXPECT_NE(this->getGeneration(), generation);
+  generation = this->getGeneration();
+  this->executor->removeAllDrafts();
+  EXPECT_EQ(this->getGeneration(), generation + 1);
+}
+
+TEST_F(ClientDBStoreGenerationTest, TransactionBumpsGenerationOnce) {
+  this->executor->runInTransaction(
+      [this]() { this->executor->updateDraft("key", "text"); });
+  std::uint64_t generation = this->getGeneration();
+  this->executor->runInTransaction([this]() {
+    this->executor->updateDraft("key", "other text");
+    this->executor->updateDraft("other key", "text");
+  });
+  EXPECT_EQ(this->getGeneration(), generation + 1);
+}
+
+TEST_F(ClientDBStoreGenerationTest, RemoveAllBumpsGeneration) {
+  this->executor->runInTransaction(
+      [this]() { this->executor->updateDraft("key", "text"); });
+  std::uint64_t generation = this->getGeneration();
+  this->executor->runInTransaction(
+      [this]() { this->executor->removeAllDrafts(); });
+  EXPECT_EQ(this->getGeneration(), generation + 1);
+}
+
+TEST_F(ClientDBStoreGenerationTest, RolledBackSavepointKeepsBumping) {
+  this->executor->runInTransaction(
+      [this]() { this->executor->updateDraft("key", "text"); });
+  std::uint64_t generation = this->getGeneration();
+  this->executor->runInTransaction([this]() {
+    this->executor->createSavepoint("draft");
+    this->executor->updateDraft("key", "other text");
+    this->executor->rollbackToSavepoint("draft");
+    this->executor->updateDraft("other key", "text");
+  });
+  EXPECT_EQ(this->getGeneration(), generation + 1);
+}
+
+TEST_F(ClientDBStoreGenerationTest, OtherTablesLeaveGenerationUnchanged) {
+  this->executor->runInTransaction(
+      [this]() { this->executor->updateDraft("key", "text"); });
+  std::uint64_t generation = this->getGeneration();
+  this->executor->runInTransaction(
+      [this]() { this->executor->setMetadata("name", "data"); });
+  this->executor->runInTransaction(
+      [this]() { this->executor->getAllDrafts(); });
+  EXPECT_EQ(this->getGeneration(), generation);
+}
+
+} // namespace comm
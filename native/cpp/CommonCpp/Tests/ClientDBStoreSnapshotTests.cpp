@@ -0,0 +1,133 @@
+#include "HostDataDirectory.h"
+#include "ClientDBStoreSnapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+// Snapshots are written with enough messages to span several segments.
+class ClientDBStoreSnapshotTest : public testing::Test {
+protected:
+  const std::string snapshotPath =
+      (getHostDataDirectory() / "comm-tests-snapshot").string();
+  const std::string encryptionKey = std::string(32, 'k');
+  const std::uint64_t generation = 7;
+  const std::size_t messagesCount = 20000;
+
+  void SetUp() override {
+    ClientDBStore store;
+    store.drafts.push_back(Draft{"thread", "draft"});
+    ClientDBStoreSnapshot::writeTemporary(
+        this->snapshotPath,
+        this->encryptionKey,
+        this->generation,
+        store,
+        [this](const ClientDBStoreSnapshot::MessagesChunkCallback &onChunk) {
+          std::vector<MessageEntity> chunk;
+          for (std::size_t i = 0; i < this->messagesCount; i++) {
+            Message message{};
+            message.id = std::to_string(i);
+            message.thread = "thread";
+            message.content = std::make_unique<std::string>(100, 'c');
+            std::vector<Media> media;
+            media.push_back(Media{"media", message.id, "thread", "", "", ""});
+            chunk.emplace_back(std::move(message), std::move(media));
+            if (chunk.size() == 700) {
+              onChunk(std::move(chunk));
+              chunk = std::vector<MessageEntity>();
+            }
+          }
+          onChunk(std::move(chunk));
+        });
+    ClientDBStoreSnapshot::commitTemporary(this->snapshotPath);
+  }
+
+  void TearDown() override {
+    ClientDBStoreSnapshot::remove(this->snapshotPath);
+    std::remove((this->snapshotPath + "_modified").c_str());
+  }
+
+  // Copies the snapshot with the given number of bytes cut off or appended.
+  std::string writeModifiedCopy(std::size_t cutBytes, std::string suffix) {
+    std::ifstream file(this->snapshotPath, std::ios::binary);
+    std::string bytes(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    std::string modifiedPath = this->snapshotPath + "_modified";
+    std::ofstream modifiedFile(modifiedPath, std::ios::binary);
+    modifiedFile << bytes.substr(0, bytes.size() - cutBytes) << suffix;
+    return modifiedPath;
+  }
+};
+
+TEST_F(ClientDBStoreSnapshotTest, HandsOverMessagesInChunks) {
+  std::vector<std::size_t> chunkSizes;
+  std::size_t nextMessageIndex = 0;
+  auto store = ClientDBStoreSnapshot::read(
+      this->snapshotPath,
+      this->encryptionKey,
+      this->generation,
+      1000,
+      [&](std::vector<MessageEntity> &&chunk) {
+        chunkSizes.push_back(chunk.size());
+        for (const auto &[message, media] : chunk) {
+          EXPECT_EQ(message.id, std::to_string(nextMessageIndex++));
+          ASSERT_EQ(media.size(), 1);
+          EXPECT_EQ(media[0].container, message.id);
+        }
+      });
+  ASSERT_NE(store, nullptr);
+  EXPECT_EQ(nextMessageIndex, this->messagesCount);
+  EXPECT_EQ(chunkSizes.size(), this->messagesCount / 1000);
+  EXPECT_TRUE(store->messages.empty());
+  ASSERT_EQ(store->drafts.size(), 1);
+  EXPECT_EQ(store->drafts[0].text, "draft");
+}
+
+TEST_F(ClientDBStoreSnapshotTest, IgnoresOtherGenerationAndKey) {
+  auto onMessages = [](std::vector<MessageEntity> &&) {
+    FAIL() << "Messages of an unreadable snapshot were handed over.";
+  };
+  EXPECT_EQ(
+      ClientDBStoreSnapshot::read(
+          this->snapshotPath,
+          this->encryptionKey,
+          this->generation + 1,
+          1000,
+          onMessages),
+      nullptr);
+  EXPECT_EQ(
+      ClientDBStoreSnapshot::read(
+          this->snapshotPath,
+          std::string(32, 'x'),
+          this->generation,
+          1000,
+          onMessages),
+      nullptr);
+}
+
+TEST_F(ClientDBStoreSnapshotTest, ThrowsOnceMessagesWereHandedOver) {
+  auto noop = [](std::vector<MessageEntity> &&) {};
+  EXPECT_ANY_THROW(ClientDBStoreSnapshot::read(
+      this->writeModifiedCopy(10, ""),
+      this->encryptionKey,
+      this->generation,
+      1000,
+      noop));
+  EXPECT_ANY_THROW(ClientDBStoreSnapshot::read(
+      this->writeModifiedCopy(0, "trailing"),
+      this->encryptionKey,
+      this->generation,
+      1000,
+      noop));
+}
+
+} // namespace comm
@@ -0,0 +1,123 @@
+#include "NativeModules/StoreOperationCompaction.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+namespace {
+
+using Type = StoreOperationEffect::Type;
+
+struct FakeOperation {
+  std::size_t index;
+  StoreOperationEffect effect;
+
+  StoreOperationEffect getEffect() const {
+    return this->effect;
+  }
+};
+
+struct CompactionCase {
+  std::string name;
+  std::vector<StoreOperationEffect> operations;
+  // Indexes of the operations left after compaction, in order.
+  std::vector<std::size_t> kept;
+};
+
+StoreOperationEffect
+effect(Type type, std::vector<std::string> keys, std::string table = "drafts") {
+  return StoreOperationEffect{type, std::move(table), std::move(keys)};
+}
+
+const std::vector<CompactionCase> compactionCases = {
+    {"ReplaceThenRemove",
+     {effect(Type::Replace, {"a"}), effect(Type::Remove, {"a"})},
+     {1}},
+    {"ReplaceThenReplace",
+     {effect(Type::Replace, {"a"}), effect(Type::Replace, {"a"})},
+     {1}},
+    {"PatchThenReplace",
+     {effect(Type::Patch, {"a"}), effect(Type::Replace, {"a"})},
+     {1}},
+    {"ReplaceThenPatch",
+     {effect(Type::Replace, {"a"}), effect(Type::Patch, {"a"})},
+     {0, 1}},
+    {"ReplaceOfOtherKeyThenRemove",
+     {effect(Type::Replace, {"a"}), effect(Type::Remove, {"b"})},
+     {0, 1}},
+    {"ReplaceOfSomeKeysOverwritten",
+     {effect(Type::Replace, {"a", "b"}), effect(Type::Replace, {"a"})},
+     {0, 1}},
+    {"ReplaceOfKeysOverwrittenInParts",
+     {effect(Type::Replace, {"a", "b"}),
+      effect(Type::Replace, {"a"}),
+      effect(Type::Remove, {"b"})},
+     {1, 2}},
+    {"OperationsThenRemoveAll",
+     {effect(Type::Replace, {"a"}),
+      effect(Type::Patch, {"b"}),
+      effect(Type::Other, {"c"}),
+      effect(Type::RemoveAll, {})},
+     {3}},
+    {"RemoveAllThenReplace",
+     {effect(Type::RemoveAll, {}), effect(Type::Replace, {"a"})},
+     {0, 1}},
+    {"RemoveAllOfOtherTable",
+     {effect(Type::Replace, {"a"}),
+      effect(Type::RemoveAll, {}, "threads")},
+     {0, 1}},
+    {"ReplaceOfOtherTable",
+     {effect(Type::Replace, {"a"}),
+      effect(Type::Replace, {"a"}, "threads")},
+     {0, 1}},
+    // The rekey may move the first row elsewhere, so it has to be written.
+    {"ReplaceThenRekeyThenReplace",
+     {effect(Type::Replace, {"a"}),
+      effect(Type::Other, {"a", "b"}),
+      effect(Type::Replace, {"a"})},
+     {0, 1, 2}},
+    // Operations without keys change no rows, so they count as entirely
+    // overwritten and are dropped.
+    {"ReplaceWithoutKeys", {effect(Type::Replace, {})}, {}},
+    {"RemoveWithoutKeysThenReplace",
+     {effect(Type::Remove, {}), effect(Type::Replace, {"a"})},
+     {1}},
+    {"PatchWithoutKeys", {effect(Type::Patch, {})}, {}},
+};
+
+class StoreOperationCompactionTest
+    : public testing::TestWithParam<CompactionCase> {};
+
+TEST_P(StoreOperationCompactionTest, KeepsOnlyOperationsNotUndoneLater) {
+  const CompactionCase &compactionCase = GetParam();
+  std::vector<std::unique_ptr<FakeOperation>> operations;
+  for (std::size_t i = 0; i < compactionCase.operations.size(); i++) {
+    operations.push_back(std::make_unique<FakeOperation>(
+        FakeOperation{i, compactionCase.operations[i]}));
+  }
+
+  compactStoreOperations(operations);
+
+  std::vector<std::size_t> kept;
+  for (const std::unique_ptr<FakeOperation> &operation : operations) {
+    kept.push_back(operation->index);
+  }
+  EXPECT_EQ(kept, compactionCase.kept);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    CompactionCases,
+    StoreOperationCompactionTest,
+    testing::ValuesIn(compactionCases),
+    [](const testing::TestParamInfo<CompactionCase> &info) {
+      return info.param.name;
+    });
+
+} // namespace
+
+} // namespace comm
@@ -0,0 +1,47 @@
+#include "CancellationToken.h"
+
+namespace comm {
+
+thread_local const CancellationScope *CancellationScope::currentScope =
+    nullptr;
+
+CancellationToken::CancellationToken() : hasDeadline(false), deadline() {
+}
+
+CancellationToken::CancellationToken(std::chrono::milliseconds timeout)
+    : hasDeadline(true), deadline(std::chrono::steady_clock::now() + timeout) {
+}
+
+void CancellationToken::cancel() {
+  this->cancelled.store(true);
+}
+
+bool CancellationToken::isCancelled() const {
+  if (this->cancelled.load()) {
+    return true;
+  }
+  return this->hasDeadline &&
+      std::chrono::steady_clock::now() >= this->deadline;
+}
+
+CancellationScope::CancellationScope(const CancellationToken *token)
+    : token(token), previousScope(CancellationScope::currentScope) {
+  CancellationScope::currentScope = this;
+}
+
+CancellationScope::~CancellationScope() {
+  CancellationScope::currentScope = this->previousScope;
+}
+
+bool CancellationScope::isCurrentTaskCancelled() {
+  for (const CancellationScope *scope = CancellationScope::currentScope;
+       scope != nullptr;
+       scope = scope->previousScope) {
+    if (scope->token != nullptr && scope->token->isCancelled()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace comm
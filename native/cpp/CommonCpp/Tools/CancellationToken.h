@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace comm {
+
+// Lets the owner of a request give up on it. Tasks holding the token are
+// skipped if it's cancelled before they start, and database queries they run
+// are interrupted once it's cancelled while they are running. A token with a
+// deadline cancels itself once the deadline passes.
+class CancellationToken {
+  std::atomic<bool> cancelled{false};
+  const bool hasDeadline;
+  const std::chrono::steady_clock::time_point deadline;
+
+public:
+  CancellationToken();
+  explicit CancellationToken(std::chrono::milliseconds timeout);
+  void cancel();
+  bool isCancelled() const;
+};
+
+// Adds the given token to the ones of the task running on the current thread
+// while the scope is alive. Scopes nest, so e.g. a request's token doesn't
+// lift a deadline set by the thread running it. The token has to outlive the
+// scope.
+class CancellationScope {
+  static thread_local const CancellationScope *currentScope;
+  const CancellationToken *token;
+  const CancellationScope *previousScope;
+
+public:
+  explicit CancellationScope(const CancellationToken *token);
+  CancellationScope(const CancellationScope &) = delete;
+  CancellationScope &operator=(const CancellationScope &) = delete;
+  ~CancellationScope();
+  // Any token of the scopes alive on the current thread is cancelled.
+  static bool isCurrentTaskCancelled();
+};
+
+} // namespace comm
@@ -0,0 +1,66 @@
+#include "KeyedSerialExecutor.h"
+#include "Logger.h"
+#include "TaskTelemetry.h"
+
+#include <exception>
+
+namespace comm {
+
+KeyedSerialExecutor::KeyedSerialExecutor(WorkStealingThreadPool &pool)
+    : pool(pool), state(std::make_shared<State>()) {
+}
+
+void KeyedSerialExecutor::runNextTask(
+    WorkStealingThreadPool &pool,
+    std::shared_ptr<State> state,
+    const std::string &key) {
+  Task task;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    task = std::move(state->queues[key].front().task);
+  }
+  // A task that throws mustn't leave its key marked as running, as no other
+  // task with that key would ever run then.
+  try {
+    task();
+  } catch (const std::exception &e) {
+    Logger::log(
+        "Task with key " + key +
+        " failed on the thread pool. Details: " + std::string(e.what()));
+  } catch (...) {
+    Logger::log("Task with key " + key + " failed on the thread pool.");
+  }
+
+  const char *nextLabel;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto queue = state->queues.find(key);
+    queue->second.pop_front();
+    if (queue->second.empty()) {
+      state->queues.erase(queue);
+      return;
+    }
+    nextLabel = queue->second.front().label;
+  }
+  // Scheduled anew rather than run in a loop, so a busy key doesn't keep the
+  // thread from tasks of other keys.
+  TaskLabelScope labelScope(nextLabel);
+  pool.scheduleTask([&pool, state, key]() { runNextTask(pool, state, key); });
+}
+
+void KeyedSerialExecutor::scheduleTask(const std::string &key, Task task) {
+  {
+    std::lock_guard<std::mutex> lock(this->state->mutex);
+    std::deque<LabeledTask> &queue = this->state->queues[key];
+    queue.push_back({std::move(task), TaskLabelScope::getCurrentLabel()});
+    if (queue.size() > 1) {
+      return;
+    }
+  }
+  WorkStealingThreadPool &pool = this->pool;
+  std::shared_ptr<State> state = this->state;
+  this->pool.scheduleTask(
+      [&pool, state, key]() { runNextTask(pool, state, key); });
+}
+
+} // namespace comm
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "WorkStealingThreadPool.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace comm {
+
+// Runs tasks on a thread pool so that tasks scheduled with the same key run
+// one at a time, in the order they were scheduled, while tasks with different
+// keys run in parallel. Keys don't take any resources while none of their
+// tasks are waiting or running.
+class KeyedSerialExecutor {
+  struct LabeledTask {
+    Task task;
+    const char *label;
+  };
+
+  struct State {
+    std::mutex mutex;
+    // The front task of every queue is the one running.
+    std::unordered_map<std::string, std::deque<LabeledTask>> queues;
+  };
+
+  WorkStealingThreadPool &pool;
+  // Shared with the scheduled tasks, so they can outlive the executor.
+  std::shared_ptr<State> state;
+
+  static void runNextTask(
+      WorkStealingThreadPool &pool,
+      std::shared_ptr<State> state,
+      const std::string &key);
+
+public:
+  KeyedSerialExecutor(
+      WorkStealingThreadPool &pool = WorkStealingThreadPool::shared());
+  void scheduleTask(const std::string &key, Task task);
+};
+
+} // namespace comm
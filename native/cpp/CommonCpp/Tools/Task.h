@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace comm {
+
+// A callable scheduled to run on another thread. Unlike `std::function` it's
+// move-only, so it never copies its captures and can hold move-only ones, and
+// it keeps callables of up to `inlineCapacity` bytes in place rather than on
+// the heap. That fits a lambda capturing a few strings and shared pointers,
+// so scheduling one doesn't allocate. Tasks wrapping other tasks don't fit,
+// so every wrapper takes a single allocation.
+class Task {
+public:
+  static constexpr std::size_t inlineCapacity{64};
+
+private:
+  struct Operations {
+    void (*invoke)(void *storage);
+    // Moves the callable to `destination` and destroys it in `source`.
+    void (*relocate)(void *source, void *destination) noexcept;
+    void (*destroy)(void *storage) noexcept;
+  };
+
+  template <typename Callable>
+  static constexpr bool isStoredInline = sizeof(Callable) <= inlineCapacity &&
+      alignof(Callable) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible<Callable>::value;
+
+  template <typename Callable> struct InlineOperations {
+    static void invoke(void *storage) {
+      (*static_cast<Callable *>(storage))();
+    }
+    static void relocate(void *source, void *destination) noexcept {
+      Callable *callable = static_cast<Callable *>(source);
+      new (destination) Callable(std::move(*callable));
+      callable->~Callable();
+    }
+    static void destroy(void *storage) noexcept {
+      static_cast<Callable *>(storage)->~Callable();
+    }
+    static constexpr Operations operations{invoke, relocate, destroy};
+  };
+
+  // The storage holds a pointer to the callable.
+  template <typename Callable> struct HeapOperations {
+    static void invoke(void *storage) {
+      (**static_cast<Callable **>(storage))();
+    }
+    static void relocate(void *source, void *destination) noexcept {
+      *static_cast<Callable **>(destination) =
+          *static_cast<Callable **>(source);
+    }
+    static void destroy(void *storage) noexcept {
+      delete *static_cast<Callable **>(storage);
+    }
+    static constexpr Operations operations{invoke, relocate, destroy};
+  };
+
+  alignas(std::max_align_t) unsigned char storage[inlineCapacity];
+  const Operations *operations{nullptr};
+
+  void reset() noexcept {
+    if (this->operations) {
+      this->operations->destroy(this->storage);
+      this->operations = nullptr;
+    }
+  }
+
+public:
+  Task() noexcept = default;
+  Task(std::nullptr_t) noexcept {
+  }
+
+  template <
+      typename Callable,
+      typename = std::enable_if_t<
+          !std::is_same<std::decay_t<Callable>, Task>::value>>
+  Task(Callable &&callable) {
+    using StoredCallable = std::decay_t<Callable>;
+    if constexpr (isStoredInline<StoredCallable>) {
+      new (this->storage) StoredCallable(std::forward<Callable>(callable));
+      this->operations = &InlineOperations<StoredCallable>::operations;
+    } else {
+      *reinterpret_cast<StoredCallable **>(this->storage) =
+          new StoredCallable(std::forward<Callable>(callable));
+      this->operations = &HeapOperations<StoredCallable>::operations;
+    }
+  }
+
+  Task(Task &&other) noexcept : operations(other.operations) {
+    if (this->operations) {
+      this->operations->relocate(other.storage, this->storage);
+      other.operations = nullptr;
+    }
+  }
+
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      this->reset();
+      if (other.operations) {
+        other.operations->relocate(other.storage, this->storage);
+        this->operations = other.operations;
+        other.operations = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task() {
+    this->reset();
+  }
+
+  void operator()() {
+    if (!this->operations) {
+      throw std::bad_function_call();
+    }
+    this->operations->invoke(this->storage);
+  }
+
+  explicit operator bool() const noexcept {
+    return this->operations != nullptr;
+  }
+};
+
+} // namespace comm
@@ -0,0 +1,194 @@
+#include "TaskTelemetry.h"
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace comm {
+
+thread_local const char *TaskLabelScope::currentLabel = "unlabeled";
+
+TaskLabelScope::TaskLabelScope(const char *label)
+    : previousLabel(TaskLabelScope::currentLabel) {
+  TaskLabelScope::currentLabel = label;
+}
+
+TaskLabelScope::~TaskLabelScope() {
+  TaskLabelScope::currentLabel = this->previousLabel;
+}
+
+const char *TaskLabelScope::getCurrentLabel() {
+  return TaskLabelScope::currentLabel;
+}
+
+void TaskTelemetry::Histogram::record(std::uint64_t value) {
+  // Index of the highest bit set, or 0 for 0.
+  std::size_t bucket = value ? 63 - __builtin_clzll(value) : 0;
+  bucket = std::min(bucket, bucketsCount - 1);
+  this->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  this->total.fetch_add(value, std::memory_order_relaxed);
+  std::uint64_t max = this->max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !this->max.compare_exchange_weak(
+             max, value, std::memory_order_relaxed)) {
+  }
+}
+
+TaskTelemetry::Histogram::Counts TaskTelemetry::Histogram::load() const {
+  // Values recorded while it's loaded may be counted only partially, which
+  // is fine for statistics.
+  Counts counts;
+  for (std::size_t bucket = 0; bucket < bucketsCount; bucket++) {
+    counts.buckets[bucket] =
+        this->buckets[bucket].load(std::memory_order_relaxed);
+    counts.count += counts.buckets[bucket];
+  }
+  counts.total = this->total.load(std::memory_order_relaxed);
+  counts.max = this->max.load(std::memory_order_relaxed);
+  return counts;
+}
+
+void TaskTelemetry::Histogram::Counts::add(const Counts &counts) {
+  for (std::size_t bucket = 0; bucket < bucketsCount; bucket++) {
+    this->buckets[bucket] += counts.buckets[bucket];
+  }
+  this->count += counts.count;
+  this->total += counts.total;
+  this->max = std::max(this->max, counts.max);
+}
+
+HistogramSummary TaskTelemetry::Histogram::Counts::summarize() const {
+  auto getPercentile = [this](std::uint64_t percentile) {
+    std::uint64_t valuesBelow = 0;
+    std::uint64_t threshold = (this->count * percentile + 99) / 100;
+    for (std::size_t bucket = 0; bucket < bucketsCount; bucket++) {
+      valuesBelow += this->buckets[bucket];
+      if (valuesBelow >= threshold) {
+        return std::min(std::uint64_t{1} << (bucket + 1), this->max);
+      }
+    }
+    return this->max;
+  };
+  return HistogramSummary{
+      this->count,
+      this->total,
+      getPercentile(50),
+      getPercentile(90),
+      getPercentile(99),
+      this->max};
+}
+
+TaskTelemetry::Registry &TaskTelemetry::getRegistry() {
+  static Registry *registry = new Registry();
+  return *registry;
+}
+
+TaskTelemetry::TaskTelemetry(const std::string name) : name(name) {
+  this->labelSlots[labelSlotsCount - 1].label.store("other");
+  Registry &registry = TaskTelemetry::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.telemetries.push_back(this);
+}
+
+TaskTelemetry::~TaskTelemetry() {
+  Registry &registry = TaskTelemetry::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.telemetries.erase(std::remove(
+      registry.telemetries.begin(), registry.telemetries.end(), this));
+}
+
+TaskTelemetry::LabelSlot &TaskTelemetry::getLabelSlot(const char *label) {
+  std::size_t probedSlotsCount = labelSlotsCount - 1;
+  std::size_t firstSlot = std::hash<const char *>{}(label) % probedSlotsCount;
+  for (std::size_t i = 0; i < probedSlotsCount; i++) {
+    LabelSlot &slot = this->labelSlots[(firstSlot + i) % probedSlotsCount];
+    const char *slotLabel = slot.label.load(std::memory_order_acquire);
+    if (slotLabel == nullptr &&
+        slot.label.compare_exchange_strong(
+            slotLabel, label, std::memory_order_acq_rel)) {
+      return slot;
+    }
+    if (slotLabel == label) {
+      return slot;
+    }
+  }
+  return this->labelSlots[labelSlotsCount - 1];
+}
+
+void TaskTelemetry::recordQueueDepth(std::size_t queueDepth) {
+  this->queueDepth.record(queueDepth);
+}
+
+void TaskTelemetry::recordTask(
+    const char *label,
+    std::uint64_t waitTimeUs,
+    std::uint64_t runTimeUs) {
+  LabelSlot &slot = this->getLabelSlot(label);
+  slot.waitTimeUs.record(waitTimeUs);
+  slot.runTimeUs.record(runTimeUs);
+}
+
+TaskQueueTelemetry
+TaskTelemetry::getSnapshot(std::size_t slowestTasksCount) const {
+  struct LabelCounts {
+    Histogram::Counts waitTimeUs;
+    Histogram::Counts runTimeUs;
+  };
+  // The same label may take a few slots if its text is stored at different
+  // addresses, so slots are merged by the text.
+  std::unordered_map<std::string, LabelCounts> labelsCounts;
+  Histogram::Counts waitTimeUs;
+  Histogram::Counts runTimeUs;
+  for (const LabelSlot &slot : this->labelSlots) {
+    const char *label = slot.label.load(std::memory_order_acquire);
+    if (label == nullptr) {
+      continue;
+    }
+    Histogram::Counts slotWaitTimeUs = slot.waitTimeUs.load();
+    Histogram::Counts slotRunTimeUs = slot.runTimeUs.load();
+    if (slotRunTimeUs.count == 0) {
+      continue;
+    }
+    LabelCounts &labelCounts = labelsCounts[label];
+    labelCounts.waitTimeUs.add(slotWaitTimeUs);
+    labelCounts.runTimeUs.add(slotRunTimeUs);
+    waitTimeUs.add(slotWaitTimeUs);
+    runTimeUs.add(slotRunTimeUs);
+  }
+
+  std::vector<TaskLabelTelemetry> slowestTasks;
+  for (const auto &labelCounts : labelsCounts) {
+    slowestTasks.push_back(
+        {labelCounts.first,
+         labelCounts.second.waitTimeUs.summarize(),
+         labelCounts.second.runTimeUs.summarize()});
+  }
+  std::sort(
+      slowestTasks.begin(),
+      slowestTasks.end(),
+      [](const TaskLabelTelemetry &a, const TaskLabelTelemetry &b) {
+        return a.runTimeUs.max > b.runTimeUs.max;
+      });
+  if (slowestTasks.size() > slowestTasksCount) {
+    slowestTasks.resize(slowestTasksCount);
+  }
+
+  return TaskQueueTelemetry{
+      this->name,
+      this->queueDepth.load().summarize(),
+      waitTimeUs.summarize(),
+      runTimeUs.summarize(),
+      slowestTasks};
+}
+
+std::vector<TaskQueueTelemetry>
+TaskTelemetry::getAllSnapshots(std::size_t slowestTasksCount) {
+  Registry &registry = TaskTelemetry::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<TaskQueueTelemetry> snapshots;
+  for (const TaskTelemetry *telemetry : registry.telemetries) {
+    snapshots.push_back(telemetry->getSnapshot(slowestTasksCount));
+  }
+  return snapshots;
+}
+
+} // namespace comm
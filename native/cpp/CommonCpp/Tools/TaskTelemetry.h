@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+struct HistogramSummary {
+  std::uint64_t count;
+  std::uint64_t total;
+  // Percentiles are approximated by the upper bound of a power of two
+  // histogram bucket, so they are precise up to a factor of two.
+  std::uint64_t p50;
+  std::uint64_t p90;
+  std::uint64_t p99;
+  std::uint64_t max;
+};
+
+struct TaskLabelTelemetry {
+  std::string label;
+  HistogramSummary waitTimeUs;
+  HistogramSummary runTimeUs;
+};
+
+struct TaskQueueTelemetry {
+  std::string name;
+  // Tasks waiting in the queue right after each task was scheduled.
+  HistogramSummary queueDepth;
+  // Time from scheduling a task until it started.
+  HistogramSummary waitTimeUs;
+  HistogramSummary runTimeUs;
+  // Sorted by the longest run time, descending.
+  std::vector<TaskLabelTelemetry> slowestTasks;
+};
+
+// Labels the tasks scheduled on the current thread while it's alive. Labels
+// have to outlive the program, e.g. string literals or `__func__`. Tasks
+// scheduled from within a task inherit its label.
+class TaskLabelScope {
+  static thread_local const char *currentLabel;
+  const char *previousLabel;
+
+public:
+  explicit TaskLabelScope(const char *label);
+  ~TaskLabelScope();
+  static const char *getCurrentLabel();
+};
+
+// Statistics of the tasks run by a worker thread or a thread pool. Recording
+// only touches atomics, so it's cheap enough to stay on in production, and
+// any thread can take a snapshot at any time.
+class TaskTelemetry {
+  class Histogram {
+  public:
+    // Bucket n holds values from 2^n up to 2^(n + 1).
+    static constexpr std::size_t bucketsCount{32};
+    struct Counts {
+      std::array<std::uint64_t, bucketsCount> buckets{};
+      std::uint64_t count{0};
+      std::uint64_t total{0};
+      std::uint64_t max{0};
+
+      void add(const Counts &counts);
+      HistogramSummary summarize() const;
+    };
+
+    void record(std::uint64_t value);
+    Counts load() const;
+
+  private:
+    // The count is the sum of the buckets, so recording a value takes only
+    // two atomic increments unless it's a new maximum.
+    std::array<std::atomic<std::uint64_t>, bucketsCount> buckets{};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> max{0};
+  };
+
+  struct LabelSlot {
+    std::atomic<const char *> label{nullptr};
+    Histogram waitTimeUs;
+    Histogram runTimeUs;
+  };
+
+  struct Registry {
+    std::mutex mutex;
+    std::vector<const TaskTelemetry *> telemetries;
+  };
+
+  // Labels are told apart by their address. Once all slots are taken, the
+  // last one collects the tasks of all other labels.
+  static constexpr std::size_t labelSlotsCount{48};
+  const std::string name;
+  Histogram queueDepth;
+  std::array<LabelSlot, labelSlotsCount> labelSlots;
+
+  // Never destroyed, as worker threads owned by static objects unregister
+  // their telemetries at exit.
+  static Registry &getRegistry();
+  LabelSlot &getLabelSlot(const char *label);
+
+public:
+  TaskTelemetry(const std::string name);
+  TaskTelemetry(const TaskTelemetry &) = delete;
+  TaskTelemetry &operator=(const TaskTelemetry &) = delete;
+  ~TaskTelemetry();
+
+  void recordQueueDepth(std::size_t queueDepth);
+  void recordTask(
+      const char *label,
+      std::uint64_t waitTimeUs,
+      std::uint64_t runTimeUs);
+  TaskQueueTelemetry getSnapshot(std::size_t slowestTasksCount) const;
+  // Snapshots of all worker threads and thread pools alive.
+  static std::vector<TaskQueueTelemetry>
+  getAllSnapshots(std::size_t slowestTasksCount);
+};
+
+} // namespace comm
@@ -0,0 +1,130 @@
+#include "WorkStealingThreadPool.h"
+#include "Logger.h"
+#include <algorithm>
+#include <sstream>
+
+namespace comm {
+
+thread_local WorkStealingThreadPool *WorkStealingThreadPool::currentPool =
+    nullptr;
+thread_local std::size_t WorkStealingThreadPool::currentWorker = 0;
+
+WorkStealingThreadPool &WorkStealingThreadPool::shared() {
+  static WorkStealingThreadPool pool(
+      "cpu",
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 2) - 1);
+  return pool;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const std::string name,
+    std::size_t threadsCount)
+    : name(name), telemetry(name) {
+  threadsCount = std::max<std::size_t>(threadsCount, 1);
+  for (std::size_t i = 0; i < threadsCount; i++) {
+    this->workers.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < threadsCount; i++) {
+    this->threads.emplace_back([this, i]() { this->run(i); });
+  }
+}
+
+bool WorkStealingThreadPool::takeTask(
+    std::size_t worker,
+    ScheduledTask &task) {
+  std::size_t workersCount = this->workers.size();
+  // Starts with the worker's own queue and then goes through the others.
+  for (std::size_t offset = 0; offset < workersCount; offset++) {
+    Worker &victim = *this->workers[(worker + offset) % workersCount];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tasks.empty()) {
+      continue;
+    }
+    task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    this->queuedTasksCount--;
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::run(std::size_t worker) {
+  currentPool = this;
+  currentWorker = worker;
+  while (true) {
+    ScheduledTask task;
+    if (this->takeTask(worker, task)) {
+      auto startedAt = std::chrono::steady_clock::now();
+      {
+        TaskLabelScope labelScope(task.label);
+        task.task();
+      }
+      auto finishedAt = std::chrono::steady_clock::now();
+      this->telemetry.recordTask(
+          task.label,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              startedAt - task.scheduledAt)
+              .count(),
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              finishedAt - startedAt)
+              .count());
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->taskScheduled.wait(lock, [this]() {
+      return this->stopping || this->queuedTasksCount > 0;
+    });
+    // Tasks scheduled before the pool was asked to stop still run.
+    if (this->stopping && this->queuedTasksCount == 0) {
+      break;
+    }
+  }
+}
+
+void WorkStealingThreadPool::scheduleTask(Task task) {
+  std::size_t worker = currentPool == this
+      ? currentWorker
+      : this->nextWorker++ % this->workers.size();
+  // Counted before the task is queued, so a thread taking it right away
+  // can't decrement the count first.
+  std::size_t queueDepth = ++this->queuedTasksCount;
+  {
+    std::lock_guard<std::mutex> lock(this->workers[worker]->mutex);
+    this->workers[worker]->tasks.push_back(ScheduledTask{
+        std::move(task),
+        TaskLabelScope::getCurrentLabel(),
+        std::chrono::steady_clock::now()});
+  }
+  this->telemetry.recordQueueDepth(queueDepth);
+  {
+    // Taken so a thread that just saw no tasks is already waiting when it's
+    // notified.
+    std::lock_guard<std::mutex> lock(this->mutex);
+  }
+  this->taskScheduled.notify_one();
+}
+
+std::size_t WorkStealingThreadPool::getThreadsCount() const {
+  return this->threads.size();
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->taskScheduled.notify_all();
+  for (std::thread &thread : this->threads) {
+    try {
+      thread.join();
+    } catch (const std::system_error &error) {
+      std::ostringstream stringStream;
+      stringStream << "Error occurred joining the " + this->name +
+              " thread pool: "
+                   << error.what();
+      Logger::log(stringStream.str());
+    }
+  }
+}
+
+} // namespace comm
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "TaskTelemetry.h"
+#include "WorkerThread.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace comm {
+
+// Runs CPU-bound tasks on several threads. Every thread has its own queue and
+// takes tasks from the queues of other threads once it runs out of them, so
+// one long task doesn't hold up the ones scheduled after it. Tasks may run in
+// any order and in parallel, so a task touching a resource shared with other
+// tasks should be scheduled through a `KeyedSerialExecutor`, or on a
+// `WorkerThread` if the resource has to stay on a single thread.
+class WorkStealingThreadPool {
+  struct ScheduledTask {
+    Task task;
+    const char *label;
+    std::chrono::steady_clock::time_point scheduledAt;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<ScheduledTask> tasks;
+  };
+
+  // The pool and the index of the worker running on the current thread, so
+  // tasks scheduled from within a task stay on the same worker.
+  static thread_local WorkStealingThreadPool *currentPool;
+  static thread_local std::size_t currentWorker;
+
+  const std::string name;
+  TaskTelemetry telemetry;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  std::atomic<std::size_t> nextWorker{0};
+  // Tasks scheduled and not yet taken. Threads sleep while it's zero. It's
+  // incremented before a task is queued, so it may briefly count a task that
+  // isn't queued yet, but never wraps around.
+  std::atomic<std::size_t> queuedTasksCount{0};
+
+  std::mutex mutex;
+  std::condition_variable taskScheduled;
+  bool stopping{false};
+
+  bool takeTask(std::size_t worker, ScheduledTask &task);
+  void run(std::size_t worker);
+
+public:
+  // Shared by all modules. Sized to the hardware, leaving one core to the JS
+  // thread.
+  static WorkStealingThreadPool &shared();
+
+  WorkStealingThreadPool(const std::string name, std::size_t threadsCount);
+  void scheduleTask(Task task);
+  std::size_t getThreadsCount() const;
+  ~WorkStealingThreadPool();
+};
+
+} // namespace comm
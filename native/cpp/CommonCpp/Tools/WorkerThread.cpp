@@ -1,33 +1,177 @@
 #include "WorkerThread.h"
 #include "Logger.h"
+#include <algorithm>
 #include <sstream>
 
 namespace comm {
 
 WorkerThread::WorkerThread(const std::string name)
-    : tasks(folly::MPMCQueue<std::unique_ptr<taskType>>(100)), name(name) {
-  auto job = [this]() {
-    while (true) {
-      std::unique_ptr<taskType> lastTask;
-      this->tasks.blockingRead(lastTask);
-      if (lastTask == nullptr) {
+    : name(name), telemetry(name) {
+  this->thread = std::make_unique<std::thread>([this]() { this->run(); });
+}
+
+bool WorkerThread::areLanesEmpty() const {
+  return std::all_of(
+      this->lanes.begin(),
+      this->lanes.end(),
+      [](const std::deque<ScheduledTask> &lane) { return lane.empty(); });
+}
+
+std::size_t WorkerThread::pickLane() {
+  std::size_t pickedLane = lanesCount;
+  std::size_t oldestLane = lanesCount;
+  bool anyLaneStarved = false;
+  for (std::size_t lane = 0; lane < lanesCount; lane++) {
+    if (this->lanes[lane].empty()) {
+      continue;
+    }
+    if (pickedLane == lanesCount) {
+      pickedLane = lane;
+    }
+    if (oldestLane == lanesCount ||
+        this->lanes[lane].front().sequenceNumber <
+            this->lanes[oldestLane].front().sequenceNumber) {
+      oldestLane = lane;
+    }
+    anyLaneStarved |= this->skippedCounts[lane] >= this->starvationLimit;
+  }
+  if (anyLaneStarved) {
+    pickedLane = oldestLane;
+  }
+
+  std::uint64_t pickedSequenceNumber =
+      this->lanes[pickedLane].front().sequenceNumber;
+  for (std::size_t lane = 0; lane < lanesCount; lane++) {
+    if (!this->lanes[lane].empty() &&
+        this->lanes[lane].front().sequenceNumber < pickedSequenceNumber) {
+      this->skippedCounts[lane]++;
+    }
+  }
+  this->skippedCounts[pickedLane] = 0;
+  return pickedLane;
+}
+
+std::uint64_t WorkerThread::pushTask(Task &&task, std::size_t lane) {
+  std::uint64_t sequenceNumber = this->nextSequenceNumber++;
+  this->lanes[lane].push_back(ScheduledTask{
+      std::move(task),
+      sequenceNumber,
+      TaskLabelScope::getCurrentLabel(),
+      std::chrono::steady_clock::now()});
+  this->queuedTasksCount++;
+  this->telemetry.recordQueueDepth(this->queuedTasksCount);
+  return sequenceNumber;
+}
+
+void WorkerThread::run() {
+  while (true) {
+    ScheduledTask task;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->runningLane = lanesCount;
+      if (this->areLanesEmpty()) {
+        this->becameIdle.notify_all();
+      }
+      this->taskScheduled.wait(lock, [this]() {
+        return this->stopping || !this->areLanesEmpty();
+      });
+      // Tasks scheduled before the thread was asked to stop still run.
+      if (this->areLanesEmpty()) {
         break;
       }
-      (*lastTask)();
+      std::size_t lane = this->pickLane();
+      task = std::move(this->lanes[lane].front());
+      this->lanes[lane].pop_front();
+      this->queuedTasksCount--;
+      this->runningLane = lane;
+    }
+    this->taskTaken.notify_all();
+
+    auto startedAt = std::chrono::steady_clock::now();
+    {
+      TaskLabelScope labelScope(task.label);
+      task.task();
     }
-  };
-  this->thread = std::make_unique<std::thread>(job);
+    auto finishedAt = std::chrono::steady_clock::now();
+    this->telemetry.recordTask(
+        task.label,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            startedAt - task.scheduledAt)
+            .count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            finishedAt - startedAt)
+            .count());
+  }
 }
 
-void WorkerThread::scheduleTask(const taskType task) {
-  if (!this->tasks.write(std::make_unique<taskType>(std::move(task)))) {
+void WorkerThread::scheduleTask(Task task, TaskPriority priority) {
+  if (!this->tryScheduleTask(task, priority)) {
     throw std::runtime_error(
         "Error scheduling task on the " + this->name + " worker thread");
   }
 }
 
+std::uint64_t
+WorkerThread::scheduleTaskBlocking(Task task, TaskPriority priority) {
+  std::size_t lane = static_cast<std::size_t>(priority);
+  std::uint64_t sequenceNumber;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (std::this_thread::get_id() != this->thread->get_id()) {
+      this->taskTaken.wait(lock, [this, lane]() {
+        return this->lanes[lane].size() < this->laneCapacity;
+      });
+    }
+    sequenceNumber = this->pushTask(std::move(task), lane);
+  }
+  this->taskScheduled.notify_one();
+  return sequenceNumber;
+}
+
+std::optional<std::uint64_t>
+WorkerThread::tryScheduleTask(Task &task, TaskPriority priority) {
+  std::size_t lane = static_cast<std::size_t>(priority);
+  std::uint64_t sequenceNumber;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->lanes[lane].size() >= this->laneCapacity) {
+      return std::nullopt;
+    }
+    sequenceNumber = this->pushTask(std::move(task), lane);
+  }
+  this->taskScheduled.notify_one();
+  return sequenceNumber;
+}
+
+bool WorkerThread::hasPendingTasks(TaskPriority priority) const {
+  std::size_t lane = static_cast<std::size_t>(priority);
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->runningLane == lane || !this->lanes[lane].empty();
+}
+
+std::uint64_t WorkerThread::getScheduledTasksCount() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->nextSequenceNumber;
+}
+
+bool WorkerThread::isIdle() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->runningLane == lanesCount && this->areLanesEmpty();
+}
+
+void WorkerThread::waitUntilIdle() const {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->becameIdle.wait(lock, [this]() {
+    return this->runningLane == lanesCount && this->areLanesEmpty();
+  });
+}
+
 WorkerThread::~WorkerThread() {
-  this->tasks.blockingWrite(nullptr);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->taskScheduled.notify_one();
   try {
     this->thread->join();
   } catch (const std::system_error &error) {
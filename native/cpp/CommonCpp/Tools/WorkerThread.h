@@ -1,22 +1,96 @@
 #pragma once
 
-#include <folly/MPMCQueue.h>
+#include "Task.h"
+#include "TaskTelemetry.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 
 namespace comm {
 
+// Tasks which have to be copied, e.g. to run the same one several times.
+// Everything else schedules a `Task`.
 using taskType = std::function<void()>;
 
+// Tasks run in the order of their priorities, and in the order they were
+// scheduled within one priority. Every priority has a lane of its own
+// capacity, so a burst of background work can't keep interactive tasks from
+// being scheduled.
+enum class TaskPriority { INTERACTIVE, WRITE, BACKGROUND };
+
 class WorkerThread {
+  struct ScheduledTask {
+    Task task;
+    std::uint64_t sequenceNumber;
+    const char *label;
+    std::chrono::steady_clock::time_point scheduledAt;
+  };
+
+  static constexpr std::size_t lanesCount{3};
+  // Once a lane was passed over this many times in a row for tasks
+  // scheduled after its next one, tasks run in the order they were
+  // scheduled until that lane gets its turn.
+  const std::size_t starvationLimit{16};
+  const std::size_t laneCapacity{100};
   std::unique_ptr<std::thread> thread;
-  folly::MPMCQueue<std::unique_ptr<taskType>> tasks;
   const std::string name;
+  TaskTelemetry telemetry;
+
+  mutable std::mutex mutex;
+  std::condition_variable taskScheduled;
+  std::condition_variable taskTaken;
+  mutable std::condition_variable becameIdle;
+  std::array<std::deque<ScheduledTask>, lanesCount> lanes;
+  std::array<std::size_t, lanesCount> skippedCounts{};
+  std::uint64_t nextSequenceNumber{0};
+  // Lane of the task being run, or lanesCount if there is none.
+  std::size_t runningLane{lanesCount};
+  bool stopping{false};
+  std::size_t queuedTasksCount{0};
+
+  // The caller has to hold the mutex.
+  bool areLanesEmpty() const;
+  std::size_t pickLane();
+  std::uint64_t pushTask(Task &&task, std::size_t lane);
+  void run();
 
 public:
   WorkerThread(const std::string name);
-  void scheduleTask(const taskType task);
+  // Throws if the lane of the task's priority is full.
+  void scheduleTask(Task task, TaskPriority priority = TaskPriority::WRITE);
+  // Waits until the lane of the task's priority has room, so it's meant for
+  // background producers rather than the JS thread. Called from the worker
+  // thread itself it schedules the task right away, as waiting would never
+  // end. Returns the sequence number the task got.
+  std::uint64_t scheduleTaskBlocking(
+      Task task,
+      TaskPriority priority = TaskPriority::WRITE);
+  // Returns nothing instead of scheduling the task if its lane is full, so
+  // the caller can run it elsewhere or give up without waiting. The task is
+  // moved from only if it was scheduled, and then its sequence number is
+  // returned.
+  std::optional<std::uint64_t> tryScheduleTask(
+      Task &task,
+      TaskPriority priority = TaskPriority::WRITE);
+  // Tasks of the given priority are waiting or running.
+  bool hasPendingTasks(TaskPriority priority) const;
+  // Tasks get sequence numbers from 0 in the order they were scheduled, so
+  // this is also the number the next task will get.
+  std::uint64_t getScheduledTasksCount() const;
+  // No task is running or waiting. It's only a hint, as tasks can be
+  // scheduled right after it's checked.
+  bool isIdle() const;
+  // Returns once no task is running or waiting, with the same caveat.
+  void waitUntilIdle() const;
   ~WorkerThread();
 };
 
@@ -26,6 +26,10 @@ public:
   virtual jsi::Value getClientDBStore(jsi::Runtime &rt) = 0;
   virtual jsi::Value removeAllDrafts(jsi::Runtime &rt) = 0;
   virtual jsi::Array getAllMessagesSync(jsi::Runtime &rt) = 0;
+  virtual jsi::Value getMessagesForThread(jsi::Runtime &rt, jsi::String threadID, std::optional<jsi::String> beforeTime, std::optional<jsi::String> beforeID, double limit) = 0;
+  virtual jsi::Value getMessagesForThreadAfter(jsi::Runtime &rt, jsi::String threadID, jsi::String afterTime, jsi::String afterID, double limit) = 0;
+  virtual jsi::Value searchMessages(jsi::Runtime &rt, jsi::String query, std::optional<jsi::String> threadID, double limit, double offset) = 0;
+  virtual jsi::Value getThreadSummaries(jsi::Runtime &rt) = 0;
   virtual jsi::Value processDraftStoreOperations(jsi::Runtime &rt, jsi::Array operations) = 0;
   virtual jsi::Value processMessageStoreOperations(jsi::Runtime &rt, jsi::Array operations) = 0;
   virtual void processMessageStoreOperationsSync(jsi::Runtime &rt, jsi::Array operations) = 0;
@@ -58,6 +62,10 @@ public:
   virtual jsi::Value clearSensitiveData(jsi::Runtime &rt) = 0;
   virtual bool checkIfDatabaseNeedsDeletion(jsi::Runtime &rt) = 0;
   virtual void reportDBOperationsFailure(jsi::Runtime &rt) = 0;
+  virtual jsi::Array getSQLiteStatementProfiles(jsi::Runtime &rt) = 0;
+  virtual void logSQLiteStatementProfiles(jsi::Runtime &rt, double statementsCount) = 0;
+  virtual jsi::Object getStoreOperationsCompactionStats(jsi::Runtime &rt) = 0;
+  virtual jsi::Array getTaskQueuesTelemetry(jsi::Runtime &rt, double slowestTasksCount) = 0;
   virtual jsi::Value computeBackupKey(jsi::Runtime &rt, jsi::String password, jsi::String backupID) = 0;
   virtual jsi::Value generateRandomString(jsi::Runtime &rt, double size) = 0;
   virtual jsi::Value setCommServicesAuthMetadata(jsi::Runtime &rt, jsi::String userID, jsi::String deviceID, jsi::String accessToken) = 0;
@@ -137,6 +145,38 @@ private:
       return bridging::callFromJs<jsi::Array>(
           rt, &T::getAllMessagesSync, jsInvoker_, instance_);
     }
+    jsi::Value getMessagesForThread(jsi::Runtime &rt, jsi::String threadID, std::optional<jsi::String> beforeTime, std::optional<jsi::String> beforeID, double limit) override {
+      static_assert(
+          bridging::getParameterCount(&T::getMessagesForThread) == 5,
+          "Expected getMessagesForThread(...) to have 5 parameters");
+
+      return bridging::callFromJs<jsi::Value>(
+          rt, &T::getMessagesForThread, jsInvoker_, instance_, std::move(threadID), std::move(beforeTime), std::move(beforeID), std::move(limit));
+    }
+    jsi::Value getMessagesForThreadAfter(jsi::Runtime &rt, jsi::String threadID, jsi::String afterTime, jsi::String afterID, double limit) override {
+      static_assert(
+          bridging::getParameterCount(&T::getMessagesForThreadAfter) == 5,
+          "Expected getMessagesForThreadAfter(...) to have 5 parameters");
+
+      return bridging::callFromJs<jsi::Value>(
+          rt, &T::getMessagesForThreadAfter, jsInvoker_, instance_, std::move(threadID), std::move(afterTime), std::move(afterID), std::move(limit));
+    }
+    jsi::Value searchMessages(jsi::Runtime &rt, jsi::String query, std::optional<jsi::String> threadID, double limit, double offset) override {
+      static_assert(
+          bridging::getParameterCount(&T::searchMessages) == 5,
+          "Expected searchMessages(...) to have 5 parameters");
+
+      return bridging::callFromJs<jsi::Value>(
+          rt, &T::searchMessages, jsInvoker_, instance_, std::move(query), std::move(threadID), std::move(limit), std::move(offset));
+    }
+    jsi::Value getThreadSummaries(jsi::Runtime &rt) override {
+      static_assert(
+          bridging::getParameterCount(&T::getThreadSummaries) == 1,
+          "Expected getThreadSummaries(...) to have 1 parameters");
+
+      return bridging::callFromJs<jsi::Value>(
+          rt, &T::getThreadSummaries, jsInvoker_, instance_);
+    }
     jsi::Value processDraftStoreOperations(jsi::Runtime &rt, jsi::Array operations) override {
       static_assert(
           bridging::getParameterCount(&T::processDraftStoreOperations) == 2,
@@ -393,6 +433,38 @@ private:
       return bridging::callFromJs<void>(
           rt, &T::reportDBOperationsFailure, jsInvoker_, instance_);
     }
+    jsi::Array getSQLiteStatementProfiles(jsi::Runtime &rt) override {
+      static_assert(
+          bridging::getParameterCount(&T::getSQLiteStatementProfiles) == 1,
+          "Expected getSQLiteStatementProfiles(...) to have 1 parameters");
+
+      return bridging::callFromJs<jsi::Array>(
+          rt, &T::getSQLiteStatementProfiles, jsInvoker_, instance_);
+    }
+    void logSQLiteStatementProfiles(jsi::Runtime &rt, double statementsCount) override {
+      static_assert(
+          bridging::getParameterCount(&T::logSQLiteStatementProfiles) == 2,
+          "Expected logSQLiteStatementProfiles(...) to have 2 parameters");
+
+      return bridging::callFromJs<void>(
+          rt, &T::logSQLiteStatementProfiles, jsInvoker_, instance_, std::move(statementsCount));
+    }
+    jsi::Object getStoreOperationsCompactionStats(jsi::Runtime &rt) override {
+      static_assert(
+          bridging::getParameterCount(&T::getStoreOperationsCompactionStats) == 1,
+          "Expected getStoreOperationsCompactionStats(...) to have 1 parameters");
+
+      return bridging::callFromJs<jsi::Object>(
+          rt, &T::getStoreOperationsCompactionStats, jsInvoker_, instance_);
+    }
+    jsi::Array getTaskQueuesTelemetry(jsi::Runtime &rt, double slowestTasksCount) override {
+      static_assert(
+          bridging::getParameterCount(&T::getTaskQueuesTelemetry) == 2,
+          "Expected getTaskQueuesTelemetry(...) to have 2 parameters");
+
+      return bridging::callFromJs<jsi::Array>(
+          rt, &T::getTaskQueuesTelemetry, jsInvoker_, instance_, std::move(slowestTasksCount));
+    }
     jsi::Value computeBackupKey(jsi::Runtime &rt, jsi::String password, jsi::String backupID) override {
       static_assert(
           bridging::getParameterCount(&T::computeBackupKey) == 3,
@@ -8,42 +8,158 @@ GlobalDBSingleton GlobalDBSingleton::instance;
 GlobalDBSingleton::GlobalDBSingleton()
     : multithreadingEnabled(false),
       databaseThread(nullptr),
-      tasksCancelled(false) {
+      tasksCancelled(false),
+      readThreadsEnabled(false),
+      nextReadThread(0) {
 }
 
-void GlobalDBSingleton::scheduleOrRun(const taskType task) {
+std::optional<std::uint64_t>
+GlobalDBSingleton::scheduleOrRun(Task task, TaskPriority priority) {
   if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
-    this->scheduleOrRunCommonImpl(task);
-    return;
+    return this->scheduleOrRunCommonImpl(std::move(task), priority);
   }
 
+  // Blocks copy what they capture, so the task is shared with the block.
+  auto sharedTask = std::make_shared<Task>(std::move(task));
   dispatch_async(dispatch_get_main_queue(), ^{
-    this->scheduleOrRunCommonImpl(task);
+    this->scheduleOrRunCommonImpl(std::move(*sharedTask), priority);
   });
+  return std::nullopt;
 }
 
-void GlobalDBSingleton::scheduleOrRunCancellable(const taskType task) {
+std::optional<std::uint64_t> GlobalDBSingleton::scheduleOrRunWithoutWaiting(
+    Task task,
+    TaskPriority priority) {
   if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
-    this->scheduleOrRunCancellableCommonImpl(task);
+    return this->scheduleOrRunWithoutWaitingCommonImpl(
+        std::move(task), priority);
+  }
+
+  // The main thread runs the task in place, so it never waits for room.
+  auto sharedTask = std::make_shared<Task>(std::move(task));
+  dispatch_async(dispatch_get_main_queue(), ^{
+    this->scheduleOrRunWithoutWaitingCommonImpl(
+        std::move(*sharedTask), priority);
+  });
+  return std::nullopt;
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellable(
+    Task task,
+    TaskPriority priority) {
+  if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
+    this->scheduleOrRunCancellableCommonImpl(std::move(task), priority);
     return;
   }
 
+  auto sharedTask = std::make_shared<Task>(std::move(task));
   dispatch_async(dispatch_get_main_queue(), ^{
-    this->scheduleOrRunCancellableCommonImpl(task);
+    this->scheduleOrRunCancellableCommonImpl(std::move(*sharedTask), priority);
   });
 }
 
 void GlobalDBSingleton::scheduleOrRunCancellable(
-    const taskType task,
-    const std::shared_ptr<facebook::react::Promise> promise,
-    const std::shared_ptr<facebook::react::CallInvoker> jsInvoker) {
+    Task task,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken) {
   if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
-    this->scheduleOrRunCancellableCommonImpl(task, promise, jsInvoker);
+    this->scheduleOrRunCancellableCommonImpl(
+        std::move(task),
+        std::move(promise),
+        std::move(jsInvoker),
+        std::move(cancellationToken));
+    return;
+  }
+
+  auto sharedTask = std::make_shared<Task>(std::move(task));
+  dispatch_async(dispatch_get_main_queue(), ^{
+    this->scheduleOrRunCancellableCommonImpl(
+        std::move(*sharedTask), promise, jsInvoker, cancellationToken);
+  });
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableRead(Task task) {
+  if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
+    this->scheduleOrRunCancellableReadCommonImpl(std::move(task));
+    return;
+  }
+
+  auto sharedTask = std::make_shared<Task>(std::move(task));
+  dispatch_async(dispatch_get_main_queue(), ^{
+    this->scheduleOrRunCancellableReadCommonImpl(std::move(*sharedTask));
+  });
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableRead(
+    Task task,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken,
+    ReadOrdering ordering) {
+  if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
+    this->scheduleOrRunCancellableReadCommonImpl(
+        std::move(task),
+        std::move(promise),
+        std::move(jsInvoker),
+        std::move(cancellationToken),
+        ordering);
+    return;
+  }
+
+  auto sharedTask = std::make_shared<Task>(std::move(task));
+  dispatch_async(dispatch_get_main_queue(), ^{
+    this->scheduleOrRunCancellableReadCommonImpl(
+        std::move(*sharedTask),
+        promise,
+        jsInvoker,
+        cancellationToken,
+        ordering);
+  });
+}
+
+void GlobalDBSingleton::scheduleOrRunCancellableSnapshotReads(
+    openSnapshotType openSnapshot,
+    std::vector<taskType> reads,
+    taskType closeSnapshot,
+    taskType onDone,
+    std::shared_ptr<facebook::react::Promise> promise,
+    std::shared_ptr<facebook::react::CallInvoker> jsInvoker,
+    std::shared_ptr<CancellationToken> cancellationToken) {
+  if (NSThread.isMainThread || this->multithreadingEnabled.load()) {
+    this->scheduleOrRunCancellableSnapshotReadsCommonImpl(
+        std::move(openSnapshot),
+        std::move(reads),
+        std::move(closeSnapshot),
+        std::move(onDone),
+        std::move(promise),
+        std::move(jsInvoker),
+        std::move(cancellationToken));
+    return;
+  }
+
+  dispatch_async(dispatch_get_main_queue(), ^{
+    this->scheduleOrRunCancellableSnapshotReadsCommonImpl(
+        openSnapshot,
+        reads,
+        closeSnapshot,
+        onDone,
+        promise,
+        jsInvoker,
+        cancellationToken);
+  });
+}
+
+void GlobalDBSingleton::enableReadThreads(
+    std::size_t readThreadsCount,
+    const taskType readThreadInitializer) {
+  if (NSThread.isMainThread) {
+    this->enableReadThreadsCommonImpl(readThreadsCount, readThreadInitializer);
     return;
   }
 
   dispatch_async(dispatch_get_main_queue(), ^{
-    this->scheduleOrRunCancellableCommonImpl(task, promise, jsInvoker);
+    this->enableReadThreadsCommonImpl(readThreadsCount, readThreadInitializer);
   });
 }
 
@@ -36,6 +36,53 @@ type CommServicesAuthMetadata = {
   +accessToken?: ?string,
 };
 
+type SQLiteStatementProfile = {
+  +sql: string,
+  +callsCount: number,
+  +totalTimeMs: number,
+  +p50TimeMs: number,
+  +p90TimeMs: number,
+  +p99TimeMs: number,
+  +rowsReturned: number,
+  +rowsChanged: number,
+};
+
+type StoreOperationsCompactionStats = {
+  +operationsCount: number,
+  +executedOperationsCount: number,
+};
+
+type TaskHistogram = {
+  +count: number,
+  +total: number,
+  +p50: number,
+  +p90: number,
+  +p99: number,
+  +max: number,
+};
+
+type TaskLabelTelemetry = {
+  +label: string,
+  +waitTimeMs: TaskHistogram,
+  +runTimeMs: TaskHistogram,
+};
+
+type TaskQueueTelemetry = {
+  +name: string,
+  +queueDepth: TaskHistogram,
+  +waitTimeMs: TaskHistogram,
+  +runTimeMs: TaskHistogram,
+  +slowestTasks: $ReadOnlyArray<TaskLabelTelemetry>,
+};
+
+type ClientDBThreadSummary = {
+  +threadID: string,
+  +lastMessageID: string,
+  +lastMessageTime: string,
+  +lastMessageType: number,
+  +messagesCount: number,
+};
+
 interface Spec extends TurboModule {
   +getDraft: (key: string) => Promise<string>;
   +updateDraft: (key: string, text: string) => Promise<boolean>;
@@ -43,6 +90,25 @@ interface Spec extends TurboModule {
   +getClientDBStore: () => Promise<ClientDBStore>;
   +removeAllDrafts: () => Promise<void>;
   +getAllMessagesSync: () => $ReadOnlyArray<ClientDBMessageInfo>;
+  +getMessagesForThread: (
+    threadID: string,
+    beforeTime: ?string,
+    beforeID: ?string,
+    limit: number,
+  ) => Promise<$ReadOnlyArray<ClientDBMessageInfo>>;
+  +getMessagesForThreadAfter: (
+    threadID: string,
+    afterTime: string,
+    afterID: string,
+    limit: number,
+  ) => Promise<$ReadOnlyArray<ClientDBMessageInfo>>;
+  +searchMessages: (
+    query: string,
+    threadID: ?string,
+    limit: number,
+    offset: number,
+  ) => Promise<$ReadOnlyArray<string>>;
+  +getThreadSummaries: () => Promise<$ReadOnlyArray<ClientDBThreadSummary>>;
   +processDraftStoreOperations: (
     operations: $ReadOnlyArray<ClientDBDraftStoreOperation>,
   ) => Promise<void>;
@@ -115,6 +181,12 @@ interface Spec extends TurboModule {
   +clearSensitiveData: () => Promise<void>;
   +checkIfDatabaseNeedsDeletion: () => boolean;
   +reportDBOperationsFailure: () => void;
+  +getSQLiteStatementProfiles: () => $ReadOnlyArray<SQLiteStatementProfile>;
+  +logSQLiteStatementProfiles: (statementsCount: number) => void;
+  +getStoreOperationsCompactionStats: () => StoreOperationsCompactionStats;
+  +getTaskQueuesTelemetry: (
+    slowestTasksCount: number,
+  ) => $ReadOnlyArray<TaskQueueTelemetry>;
   +computeBackupKey: (password: string, backupID: string) => Promise<Object>;
   +generateRandomString: (size: number) => Promise<string>;
   +setCommServicesAuthMetadata: (
@@ -20,6 +20,7 @@
 , fmt
 , glog
 , grpc
+, gtest
 , libiconv
 , libuv
 , localstack
@@ -102,6 +103,7 @@ mkShell {
     double-conversion # tunnelbroker
     glog # tunnelbroker
     folly # cpp tools
+    gtest # CommonCpp host tests
     fmt # needed for folly
     boost # needed for folly
     olm # needed for CryptoTools
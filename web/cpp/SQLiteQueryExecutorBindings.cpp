@@ -69,6 +69,11 @@ EMSCRIPTEN_BINDINGS(SQLiteQueryExecutor) {
       .field("repliesCount", &WebThread::replies_count)
       .field("avatar", &WebThread::avatar)
       .field("pinnedCount", &WebThread::pinned_count);
+  value_object<WebThreadPatch>("WebThreadPatch")
+      .field("id", &WebThreadPatch::id)
+      .field("currentUser", &WebThreadPatch::current_user)
+      .field("roles", &WebThreadPatch::roles)
+      .field("members", &WebThreadPatch::members);
 
   value_object<WebMessage>("WebMessage")
       .field("id", &WebMessage::id)
@@ -92,6 +97,13 @@ EMSCRIPTEN_BINDINGS(SQLiteQueryExecutor) {
       .field("message", &MessageWithMedias::message)
       .field("medias", &MessageWithMedias::medias);
 
+  value_object<WebThreadSummary>("WebThreadSummary")
+      .field("thread", &WebThreadSummary::thread)
+      .field("lastMessageID", &WebThreadSummary::last_message_id)
+      .field("lastMessageTime", &WebThreadSummary::last_message_time)
+      .field("lastMessageType", &WebThreadSummary::last_message_type)
+      .field("messagesCount", &WebThreadSummary::messages_count);
+
   value_object<OlmPersistSession>("OlmPersistSession")
       .field("targetUserID", &OlmPersistSession::target_user_id)
       .field("sessionData", &OlmPersistSession::session_data);
@@ -104,6 +116,21 @@ EMSCRIPTEN_BINDINGS(SQLiteQueryExecutor) {
       .function("removeAllDrafts", &SQLiteQueryExecutor::removeAllDrafts)
       .function("removeDrafts", &SQLiteQueryExecutor::removeDrafts)
       .function("getAllMessagesWeb", &SQLiteQueryExecutor::getAllMessagesWeb)
+      .function(
+          "getMessagesForThreadWeb",
+          &SQLiteQueryExecutor::getMessagesForThreadWeb)
+      .function(
+          "getMessagesForThreadAfterWeb",
+          &SQLiteQueryExecutor::getMessagesForThreadAfterWeb)
+      .function("searchMessagesWeb", &SQLiteQueryExecutor::searchMessagesWeb)
+      .function(
+          "indexMessagesForSearch",
+          &SQLiteQueryExecutor::indexMessagesForSearch)
+      .function(
+          "resetMessageSearchIndex",
+          &SQLiteQueryExecutor::resetMessageSearchIndex)
+      .function(
+          "getThreadSummariesWeb", &SQLiteQueryExecutor::getThreadSummariesWeb)
       .function("removeAllMessages", &SQLiteQueryExecutor::removeAllMessages)
       .function("removeMessages", &SQLiteQueryExecutor::removeMessages)
       .function(
@@ -153,6 +180,7 @@ EMSCRIPTEN_BINDINGS(SQLiteQueryExecutor) {
       .function("removeAllUsers", &SQLiteQueryExecutor::removeAllUsers)
       .function("getAllUsers", &SQLiteQueryExecutor::getAllUsers)
       .function("replaceThreadWeb", &SQLiteQueryExecutor::replaceThreadWeb)
+      .function("patchThreadWeb", &SQLiteQueryExecutor::patchThreadWeb)
       .function("getAllThreadsWeb", &SQLiteQueryExecutor::getAllThreadsWeb)
       .function("removeAllThreads", &SQLiteQueryExecutor::removeAllThreads)
       .function("removeThreads", &SQLiteQueryExecutor::removeThreads)
@@ -0,0 +1,125 @@
+// @flow
+
+import { getDatabaseModule } from '../db-module.js';
+import { clearSensitiveData } from '../utils/db-utils.js';
+
+const FILE_PATH = 'test.sqlite';
+
+describe('Message search queries', () => {
+  let queryExecutor;
+  let dbModule;
+
+  beforeAll(async () => {
+    dbModule = getDatabaseModule();
+  });
+
+  beforeEach(() => {
+    queryExecutor = new dbModule.SQLiteQueryExecutor(FILE_PATH);
+  });
+
+  afterEach(() => {
+    clearSensitiveData(dbModule, FILE_PATH, queryExecutor);
+  });
+
+  const replaceMessage = (
+    id: string,
+    thread: string,
+    type: number,
+    content: string,
+  ) => {
+    queryExecutor.replaceMessageWeb({
+      id,
+      localID: { value: '', isNull: true },
+      thread,
+      user: '1',
+      type,
+      futureType: { value: 0, isNull: true },
+      content: { value: content, isNull: false },
+      time: '0',
+    });
+  };
+
+  const search = (query: string, limit: number = 10, offset: number = 0) =>
+    queryExecutor.searchMessagesWeb(
+      query,
+      { value: '', isNull: true },
+      limit,
+      offset,
+    );
+
+  it('should index inserted text messages', () => {
+    replaceMessage('1', '1', 0, 'hello world');
+    replaceMessage('2', '1', 1, 'hello world');
+    expect(search('hello')).toStrictEqual(['1']);
+    expect(search('hel')).toStrictEqual(['1']);
+    expect(search('hello planet')).toStrictEqual([]);
+  });
+
+  it('should update index when message is replaced', () => {
+    replaceMessage('1', '1', 0, 'hello world');
+    replaceMessage('1', '1', 0, 'goodbye world');
+    expect(search('hello')).toStrictEqual([]);
+    expect(search('goodbye')).toStrictEqual(['1']);
+  });
+
+  it('should update index when message is rekeyed', () => {
+    replaceMessage('1', '1', 0, 'hello world');
+    queryExecutor.rekeyMessage('1', '2');
+    expect(search('hello')).toStrictEqual(['2']);
+  });
+
+  it('should remove deleted messages from index', () => {
+    replaceMessage('1', '1', 0, 'hello world');
+    replaceMessage('2', '1', 0, 'hello there');
+    queryExecutor.removeMessages(['1']);
+    expect(search('hello')).toStrictEqual(['2']);
+    queryExecutor.removeAllMessages();
+    expect(search('hello')).toStrictEqual([]);
+  });
+
+  it('should page through results ordered by rank', () => {
+    replaceMessage('1', '1', 0, 'apple apple apple');
+    replaceMessage('2', '1', 0, 'apple banana cherry date');
+    replaceMessage(
+      '3',
+      '2',
+      0,
+      'apple and a long list of many other unrelated words here',
+    );
+    expect(search('apple')).toStrictEqual(['1', '2', '3']);
+    expect(search('app', 2, 0)).toStrictEqual(['1', '2']);
+    expect(search('app', 2, 2)).toStrictEqual(['3']);
+    expect(
+      queryExecutor.searchMessagesWeb(
+        'apple',
+        { value: '2', isNull: false },
+        10,
+        0,
+      ),
+    ).toStrictEqual(['3']);
+  });
+
+  it('should rebuild index in chunks after reset', () => {
+    replaceMessage('1', '1', 0, 'apple pie');
+    replaceMessage('2', '1', 1, 'apple pie');
+    replaceMessage('3', '1', 0, 'apple tart');
+    expect(queryExecutor.indexMessagesForSearch(2)).toBe(true);
+
+    queryExecutor.beginTransaction();
+    queryExecutor.resetMessageSearchIndex();
+    queryExecutor.commitTransaction();
+    expect(search('apple')).toStrictEqual([]);
+
+    // Messages added before the backfill reaches them are left to it
+    replaceMessage('4', '1', 0, 'apple crumble');
+    expect(search('apple')).toStrictEqual([]);
+
+    expect(queryExecutor.indexMessagesForSearch(2)).toBe(false);
+    expect(search('apple')).toStrictEqual(['1']);
+    expect(queryExecutor.indexMessagesForSearch(2)).toBe(true);
+    expect([...search('apple')].sort()).toStrictEqual(['1', '3', '4']);
+
+    replaceMessage('5', '1', 0, 'apple strudel');
+    expect(search('strudel')).toStrictEqual(['5']);
+  });
+});
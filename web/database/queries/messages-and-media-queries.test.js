@@ -159,6 +159,141 @@ describe('Message and media store queries', () => {
     expect(rekeyedMessage?.message.thread).toBe('2');
   });
 
+  it('should return messages for thread before time', () => {
+    queryExecutor.replaceMessageWeb({
+      id: '4',
+      localID: { value: '', isNull: true },
+      thread: '1',
+      user: '1',
+      type: 0,
+      futureType: { value: 0, isNull: true },
+      content: { value: '', isNull: true },
+      time: '10',
+    });
+    queryExecutor.replaceMessageWeb({
+      id: '5',
+      localID: { value: '', isNull: true },
+      thread: '1',
+      user: '1',
+      type: 0,
+      futureType: { value: 0, isNull: true },
+      content: { value: '', isNull: true },
+      time: '20',
+    });
+
+    const messages = queryExecutor.getMessagesForThreadWeb(
+      '1',
+      '20',
+      '5',
+      10,
+    );
+    expect(messages.length).toBe(3);
+    expect(messages[0].message.id).toBe('4');
+    const messageWithMedia = messages.find(
+      messageWithMedia => messageWithMedia.message.id === '1',
+    );
+    expect(messageWithMedia?.medias.length).toBe(2);
+
+    const limitedMessages = queryExecutor.getMessagesForThreadWeb(
+      '1',
+      '20',
+      '5',
+      1,
+    );
+    expect(limitedMessages.length).toBe(1);
+    expect(limitedMessages[0].message.id).toBe('4');
+  });
+
+  it('should page through messages with the same time', () => {
+    const firstPage = queryExecutor.getMessagesForThreadWeb('1', '1', '', 1);
+    expect(firstPage.length).toBe(1);
+    expect(firstPage[0].message.id).toBe('2');
+
+    const secondPage = queryExecutor.getMessagesForThreadWeb(
+      '1',
+      firstPage[0].message.time,
+      firstPage[0].message.id,
+      1,
+    );
+    expect(secondPage.length).toBe(1);
+    expect(secondPage[0].message.id).toBe('1');
+
+    const newerMessages = queryExecutor.getMessagesForThreadAfterWeb(
+      '1',
+      secondPage[0].message.time,
+      secondPage[0].message.id,
+      10,
+    );
+    expect(newerMessages.length).toBe(1);
+    expect(newerMessages[0].message.id).toBe('2');
+  });
+
+  it('should return messages for thread after time', () => {
+    queryExecutor.replaceMessageWeb({
+      id: '4',
+      localID: { value: '', isNull: true },
+      thread: '1',
+      user: '1',
+      type: 0,
+      futureType: { value: 0, isNull: true },
+      content: { value: '', isNull: true },
+      time: '10',
+    });
+    queryExecutor.replaceMessageWeb({
+      id: '5',
+      localID: { value: '', isNull: true },
+      thread: '2',
+      user: '1',
+      type: 0,
+      futureType: { value: 0, isNull: true },
+      content: { value: '', isNull: true },
+      time: '20',
+    });
+
+    const messages = queryExecutor.getMessagesForThreadAfterWeb(
+      '1',
+      '0',
+      '2',
+      10,
+    );
+    expect(messages.length).toBe(1);
+    expect(messages[0].message.id).toBe('4');
+    expect(messages[0].medias.length).toBe(0);
+  });
+
+  it('should return media of pages with more messages than inline keys', () => {
+    for (let i = 0; i < 100; i++) {
+      const id = `page-${i}`;
+      queryExecutor.replaceMessageWeb({
+        id,
+        localID: { value: '', isNull: true },
+        thread: '3',
+        user: '1',
+        type: 0,
+        futureType: { value: 0, isNull: true },
+        content: { value: '', isNull: true },
+        time: `${i + 1}`,
+      });
+      queryExecutor.replaceMedia({
+        id,
+        container: id,
+        thread: '3',
+        uri: '1',
+        type: '1',
+        extras: '1',
+      });
+    }
+
+    const messages = queryExecutor.getMessagesForThreadWeb('3', '101', '', 100);
+    expect(messages.length).toBe(100);
+    for (const messageWithMedia of messages) {
+      expect(messageWithMedia.medias.length).toBe(1);
+      expect(messageWithMedia.medias[0].container).toBe(
+        messageWithMedia.message.id,
+      );
+    }
+  });
+
   it('should correctly handle nullable integer', () => {
     const allMessages = queryExecutor.getAllMessagesWeb();
     const messageWithNullFutureType = allMessages.find(
@@ -0,0 +1,149 @@
+// @flow
+
+import { getDatabaseModule } from '../db-module.js';
+import { clearSensitiveData } from '../utils/db-utils.js';
+
+const FILE_PATH = 'test.sqlite';
+
+describe('Thread summaries queries', () => {
+  let queryExecutor;
+  let dbModule;
+
+  beforeAll(async () => {
+    dbModule = getDatabaseModule();
+  });
+
+  beforeEach(() => {
+    queryExecutor = new dbModule.SQLiteQueryExecutor(FILE_PATH);
+    replaceMessage('1', '1', 0, '10');
+    replaceMessage('2', '1', 1, '20');
+    replaceMessage('3', '1', 2, '5');
+    replaceMessage('4', '2', 0, '1');
+  });
+
+  afterEach(() => {
+    clearSensitiveData(dbModule, FILE_PATH, queryExecutor);
+  });
+
+  function replaceMessage(
+    id: string,
+    thread: string,
+    type: number,
+    time: string,
+  ) {
+    queryExecutor.replaceMessageWeb({
+      id,
+      localID: { value: '', isNull: true },
+      thread,
+      user: '1',
+      type,
+      futureType: { value: 0, isNull: true },
+      content: { value: '', isNull: true },
+      time,
+    });
+  }
+
+  const getSummaries = () =>
+    [...queryExecutor.getThreadSummariesWeb()].sort((a, b) =>
+      a.thread.localeCompare(b.thread),
+    );
+
+  it('should summarize threads on insert', () => {
+    expect(getSummaries()).toStrictEqual([
+      {
+        thread: '1',
+        lastMessageID: '2',
+        lastMessageTime: '20',
+        lastMessageType: 1,
+        messagesCount: 3,
+      },
+      {
+        thread: '2',
+        lastMessageID: '4',
+        lastMessageTime: '1',
+        lastMessageType: 0,
+        messagesCount: 1,
+      },
+    ]);
+  });
+
+  it('should break time ties by message id', () => {
+    replaceMessage('5', '1', 3, '20');
+    expect(getSummaries()[0]).toStrictEqual({
+      thread: '1',
+      lastMessageID: '5',
+      lastMessageTime: '20',
+      lastMessageType: 3,
+      messagesCount: 4,
+    });
+  });
+
+  it('should move replaced message between threads', () => {
+    replaceMessage('2', '2', 1, '30');
+    expect(getSummaries()).toStrictEqual([
+      {
+        thread: '1',
+        lastMessageID: '1',
+        lastMessageTime: '10',
+        lastMessageType: 0,
+        messagesCount: 2,
+      },
+      {
+        thread: '2',
+        lastMessageID: '2',
+        lastMessageTime: '30',
+        lastMessageType: 1,
+        messagesCount: 2,
+      },
+    ]);
+  });
+
+  it('should keep latest message when older one is deleted', () => {
+    queryExecutor.removeMessages(['3']);
+    expect(getSummaries()[0]).toStrictEqual({
+      thread: '1',
+      lastMessageID: '2',
+      lastMessageTime: '20',
+      lastMessageType: 1,
+      messagesCount: 2,
+    });
+  });
+
+  it('should find next latest message when latest one is deleted', () => {
+    queryExecutor.removeMessages(['2']);
+    expect(getSummaries()[0]).toStrictEqual({
+      thread: '1',
+      lastMessageID: '1',
+      lastMessageTime: '10',
+      lastMessageType: 0,
+      messagesCount: 2,
+    });
+  });
+
+  it('should update latest message id on rekey', () => {
+    queryExecutor.rekeyMessage('2', '6');
+    expect(getSummaries()[0]).toStrictEqual({
+      thread: '1',
+      lastMessageID: '6',
+      lastMessageTime: '20',
+      lastMessageType: 1,
+      messagesCount: 3,
+    });
+  });
+
+  it('should remove summary with last message of thread', () => {
+    queryExecutor.removeMessages(['4']);
+    expect(getSummaries().map(summary => summary.thread)).toStrictEqual([
+      '1',
+    ]);
+  });
+
+  it('should remove summaries of removed threads', () => {
+    queryExecutor.removeMessagesForThreads(['1']);
+    expect(getSummaries().map(summary => summary.thread)).toStrictEqual([
+      '2',
+    ]);
+    queryExecutor.removeAllMessages();
+    expect(getSummaries()).toStrictEqual([]);
+  });
+});
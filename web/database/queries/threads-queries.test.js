@@ -91,4 +91,182 @@ describe('Threads queries', () => {
     const threads = queryExecutor.getAllThreadsWeb();
     expect(threads.length).toBe(2);
   });
+
+  const replaceThreadWithMembers = () => {
+    queryExecutor.replaceThreadWeb({
+      id: '4',
+      type: 1,
+      name: { value: '', isNull: true },
+      avatar: { value: '', isNull: true },
+      description: { value: '', isNull: true },
+      color: '1',
+      creationTime: '1',
+      parentThreadID: { value: '', isNull: true },
+      containingThreadID: { value: '', isNull: true },
+      community: { value: '', isNull: true },
+      members: JSON.stringify([
+        { id: '3', role: 'r', isSender: false },
+        { id: '1', role: 'r', isSender: false },
+        { id: '2', role: 'r', isSender: true },
+      ]),
+      roles: JSON.stringify({ r: { id: 'r', name: 'Members' } }),
+      currentUser: JSON.stringify({
+        role: 'r',
+        subscription: { home: true, pushNotifs: false },
+        unread: false,
+      }),
+      sourceMessageID: { value: '', isNull: true },
+      repliesCount: 1,
+      pinnedCount: 1,
+    });
+  };
+
+  const getThread = (id: string) =>
+    queryExecutor.getAllThreadsWeb().find(thread => thread.id === id);
+
+  it('should merge current user patch into thread', () => {
+    replaceThreadWithMembers();
+    const patched = queryExecutor.patchThreadWeb({
+      id: '4',
+      currentUser: {
+        value: JSON.stringify({ subscription: { pushNotifs: true } }),
+        isNull: false,
+      },
+      roles: { value: '', isNull: true },
+      members: { value: '', isNull: true },
+    });
+    expect(patched).toBe(true);
+    const thread = getThread('4');
+    expect(JSON.parse(thread?.currentUser ?? '')).toStrictEqual({
+      role: 'r',
+      subscription: { home: true, pushNotifs: true },
+      unread: false,
+    });
+    expect(JSON.parse(thread?.roles ?? '')).toStrictEqual({
+      r: { id: 'r', name: 'Members' },
+    });
+  });
+
+  it('should remove keys set to null by current user patch', () => {
+    replaceThreadWithMembers();
+    queryExecutor.patchThreadWeb({
+      id: '4',
+      currentUser: { value: JSON.stringify({ unread: null }), isNull: false },
+      roles: { value: '', isNull: true },
+      members: { value: '', isNull: true },
+    });
+    expect(JSON.parse(getThread('4')?.currentUser ?? '')).toStrictEqual({
+      role: 'r',
+      subscription: { home: true, pushNotifs: false },
+    });
+  });
+
+  it('should patch members in place keeping their order', () => {
+    replaceThreadWithMembers();
+    const patched = queryExecutor.patchThreadWeb({
+      id: '4',
+      currentUser: { value: '', isNull: true },
+      roles: { value: '', isNull: true },
+      members: {
+        value: JSON.stringify({
+          '1': { isSender: true },
+          '5': { role: 'r', isSender: true },
+        }),
+        isNull: false,
+      },
+    });
+    expect(patched).toBe(true);
+    expect(JSON.parse(getThread('4')?.members ?? '')).toStrictEqual([
+      { id: '3', role: 'r', isSender: false },
+      { id: '1', role: 'r', isSender: true },
+      { id: '2', role: 'r', isSender: true },
+    ]);
+  });
+
+  it('should keep order of many patched members', () => {
+    const memberIDs = ['9', '3', '12', '1', '7', '20', '5', '16', '2', '11'];
+    queryExecutor.replaceThreadWeb({
+      id: '4',
+      type: 1,
+      name: { value: '', isNull: true },
+      avatar: { value: '', isNull: true },
+      description: { value: '', isNull: true },
+      color: '1',
+      creationTime: '1',
+      parentThreadID: { value: '', isNull: true },
+      containingThreadID: { value: '', isNull: true },
+      community: { value: '', isNull: true },
+      members: JSON.stringify(
+        memberIDs.map(id => ({ id, role: 'r', isSender: false })),
+      ),
+      roles: '{}',
+      currentUser: '{}',
+      sourceMessageID: { value: '', isNull: true },
+      repliesCount: 1,
+      pinnedCount: 1,
+    });
+    queryExecutor.patchThreadWeb({
+      id: '4',
+      currentUser: { value: '', isNull: true },
+      roles: { value: '', isNull: true },
+      members: {
+        value: JSON.stringify({
+          '20': { isSender: true },
+          '1': { isSender: true },
+          '11': { isSender: true },
+        }),
+        isNull: false,
+      },
+    });
+    expect(JSON.parse(getThread('4')?.members ?? '')).toStrictEqual(
+      memberIDs.map(id => ({
+        id,
+        role: 'r',
+        isSender: id === '20' || id === '1' || id === '11',
+      })),
+    );
+  });
+
+  it('should throw when members patch is not valid JSON', () => {
+    replaceThreadWithMembers();
+    expect(() =>
+      queryExecutor.patchThreadWeb({
+        id: '4',
+        currentUser: { value: JSON.stringify({ unread: true }), isNull: false },
+        roles: { value: '', isNull: true },
+        members: { value: '{"1":', isNull: false },
+      }),
+    ).toThrow();
+    const thread = getThread('4');
+    expect(JSON.parse(thread?.currentUser ?? '').unread).toBe(false);
+    expect(JSON.parse(thread?.members ?? '')[1]).toStrictEqual({
+      id: '1',
+      role: 'r',
+      isSender: false,
+    });
+  });
+
+  it('should return false when patching missing thread', () => {
+    const patched = queryExecutor.patchThreadWeb({
+      id: '100',
+      currentUser: { value: JSON.stringify({ unread: true }), isNull: false },
+      roles: { value: '', isNull: true },
+      members: { value: '', isNull: true },
+    });
+    expect(patched).toBe(false);
+    expect(queryExecutor.getAllThreadsWeb().length).toBe(3);
+  });
+
+  it('should throw when patch is not valid JSON', () => {
+    replaceThreadWithMembers();
+    expect(() =>
+      queryExecutor.patchThreadWeb({
+        id: '4',
+        currentUser: { value: '{"unread":', isNull: false },
+        roles: { value: '', isNull: true },
+        members: { value: '', isNull: true },
+      }),
+    ).toThrow();
+    expect(JSON.parse(getThread('4')?.currentUser ?? '').unread).toBe(false);
+  });
 });
@@ -1,6 +1,9 @@
 // @flow
 
-import type { ClientDBThreadInfo } from 'lib/types/thread-types.js';
+import type {
+  ClientDBThreadInfo,
+  ClientDBThreadPatch,
+} from 'lib/types/thread-types.js';
 
 export type Nullable<T> = {
   +value: T,
@@ -30,6 +33,13 @@ export type WebClientDBThreadInfo = {
   +pinnedCount: number,
 };
 
+export type WebClientDBThreadPatch = {
+  +id: string,
+  +currentUser: NullableString,
+  +roles: NullableString,
+  +members: NullableString,
+};
+
 function createNullableString(value: ?string): NullableString {
   if (value === null || value === undefined) {
     return {
@@ -99,4 +109,19 @@ function webThreadToClientDBThreadInfo(
   return result;
 }
 
-export { clientDBThreadInfoToWebThread, webThreadToClientDBThreadInfo };
+function clientDBThreadPatchToWebThreadPatch(
+  patch: ClientDBThreadPatch,
+): WebClientDBThreadPatch {
+  return {
+    id: patch.id,
+    currentUser: createNullableString(patch.currentUser),
+    roles: createNullableString(patch.roles),
+    members: createNullableString(patch.members),
+  };
+}
+
+export {
+  clientDBThreadInfoToWebThread,
+  webThreadToClientDBThreadInfo,
+  clientDBThreadPatchToWebThreadPatch,
+};
@@ -8,6 +8,7 @@ import type { ClientDBDraftInfo } from 'lib/types/draft-types.js';
 
 import {
   type WebClientDBThreadInfo,
+  type WebClientDBThreadPatch,
   type NullableString,
   type NullableInt,
 } from './entities.js';
@@ -32,6 +33,14 @@ type Media = {
   +extras: string,
 };
 
+type WebThreadSummary = {
+  +thread: string,
+  +lastMessageID: string,
+  +lastMessageTime: string,
+  +lastMessageType: number,
+  +messagesCount: number,
+};
+
 type OlmPersistSession = {
   +targetUserID: string,
   +sessionData: string,
@@ -50,6 +59,33 @@ declare export class SQLiteQueryExecutor {
     +message: WebMessage,
     +medias: $ReadOnlyArray<Media>,
   }>;
+  getMessagesForThreadWeb(
+    threadID: string,
+    beforeTime: string,
+    beforeID: string,
+    limit: number,
+  ): $ReadOnlyArray<{
+    +message: WebMessage,
+    +medias: $ReadOnlyArray<Media>,
+  }>;
+  getMessagesForThreadAfterWeb(
+    threadID: string,
+    afterTime: string,
+    afterID: string,
+    limit: number,
+  ): $ReadOnlyArray<{
+    +message: WebMessage,
+    +medias: $ReadOnlyArray<Media>,
+  }>;
+  searchMessagesWeb(
+    query: string,
+    threadID: NullableString,
+    limit: number,
+    offset: number,
+  ): $ReadOnlyArray<string>;
+  indexMessagesForSearch(messagesCount: number): boolean;
+  resetMessageSearchIndex(): void;
+  getThreadSummariesWeb(): $ReadOnlyArray<WebThreadSummary>;
   removeAllMessages(): void;
   removeMessages(ids: $ReadOnlyArray<string>): void;
   removeMessagesForThreads(threadIDs: $ReadOnlyArray<string>): void;
@@ -91,6 +127,7 @@ declare export class SQLiteQueryExecutor {
   getAllUsers(): ClientDBUserInfo[];
 
   replaceThreadWeb(thread: WebClientDBThreadInfo): void;
+  patchThreadWeb(patch: WebClientDBThreadPatch): boolean;
   removeThreads(ids: $ReadOnlyArray<string>): void;
   removeAllThreads(): void;
   getAllThreadsWeb(): WebClientDBThreadInfo[];
@@ -16,6 +16,7 @@ import { getMessageForException } from 'lib/utils/errors.js';
 
 import {
   clientDBThreadInfoToWebThread,
+  clientDBThreadPatchToWebThreadPatch,
   webThreadToClientDBThreadInfo,
 } from '../types/entities.js';
 import type { EmscriptenModule } from '../types/module.js';
@@ -108,6 +109,10 @@ function processThreadStoreOperations(
         sqliteQueryExecutor.replaceThreadWeb(
           clientDBThreadInfoToWebThread(operation.payload),
         );
+      } else if (operation.type === 'patch') {
+        sqliteQueryExecutor.patchThreadWeb(
+          clientDBThreadPatchToWebThreadPatch(operation.payload),
+        );
       } else {
         throw new Error('Unsupported thread operation');
       }
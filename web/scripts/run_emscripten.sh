@@ -42,6 +42,8 @@ SQLITE_COMPILATION_FLAGS=(
  -DSQLITE_DISABLE_LFS
  -DSQLITE_ENABLE_FTS3
  -DSQLITE_ENABLE_FTS3_PARENTHESIS
+ -DSQLITE_ENABLE_FTS5
+ # The web database is only ever used from a single worker thread
  -DSQLITE_THREADSAFE=0
  -DSQLITE_ENABLE_NORMALIZE
  -DSQLITE_HAS_CODEC
@@ -147,10 +149,13 @@ CFLAGS=(
 
 INPUT_FILES=(
   "${INPUT_DIR}SQLiteConnectionManager.cpp"
+  "${INPUT_DIR}SQLitePerformanceProfile.cpp"
+  "${INPUT_DIR}SQLiteProfiler.cpp"
   "${WEB_CPP_DIR}SQLiteQueryExecutorBindings.cpp"
   "${WEB_CPP_DIR}Logger.cpp"
   "${ENTITIES_DIR}SQLiteDataConverters.cpp"
   "${ENTITIES_DIR}SQLiteStatementWrapper.cpp"
+  "${NATIVE_CPP_DIR}CommonCpp/Tools/CancellationToken.cpp"
   "$SQLITE_BITCODE_FILE"
 )
 